@@ -5,18 +5,24 @@
 
 #pragma once
 
+#include <functional>
 #include <memory>
 #include <ygm/detail/mpi.hpp>
 
 namespace ygm {
 
+template <typename T>
+class future;
+
 class comm {
 public:
-  comm(int *argc, char ***argv, int buffer_capacity);
+  // credit_budget bounds the bytes a sender may have outstanding at any one
+  // receiver; 0 selects a default of 8 buffers.
+  comm(int *argc, char ***argv, int buffer_capacity, size_t credit_budget);
 
   // TODO:  Add way to detect if this MPI_Comm is already open. E.g., static
   // map<MPI_Comm, impl*>
-  comm(MPI_Comm comm, int buffer_capacity);
+  comm(MPI_Comm comm, int buffer_capacity, size_t credit_budget);
 
   ~comm();
 
@@ -27,6 +33,22 @@ public:
   template <typename AsyncFunction, typename... SendArgs>
   void async(int dest, AsyncFunction fn, const SendArgs &... args);
 
+  // Like async, but executed on the receiver's handler thread owning shard
+  template <typename AsyncFunction, typename... SendArgs>
+  void async_sharded(int dest, uint32_t shard, AsyncFunction fn,
+                     const SendArgs &... args);
+
+  // Runs fn on dest and returns a future holding its result
+  template <typename AsyncFunction, typename... SendArgs>
+  auto async_call(int dest, AsyncFunction fn, const SendArgs &... args);
+
+#if defined(__cpp_impl_coroutine)
+  // Awaitable form of async_call for use inside a ygm::task, e.g.
+  //   auto value = co_await world.remote(dest, fn, args...);
+  template <typename AsyncFunction, typename... SendArgs>
+  auto remote(int dest, AsyncFunction fn, const SendArgs &... args);
+#endif
+
   template <typename... SendArgs>
   void async_preempt(int dest, const SendArgs &... args);
 
@@ -35,10 +57,32 @@ public:
   template <typename... SendArgs>
   void async_bcast_preempt(const SendArgs &... args);
 
+  //
+  // Threads executing messages sent with async_sharded.  0 (the default)
+  // executes them on the calling thread like any other message.  Collective;
+  // must be set before constructing containers.
+  //
+  int  handler_threads() const;
+  void set_handler_threads(int num_threads);
+
+  //
+  // Maximum nesting of message processing inside handlers that themselves
+  // call async.  Deeper messages are deferred to an outer processing loop.
+  //
+  int  max_process_depth() const;
+  void set_max_process_depth(int depth);
+
   void async_flush(int rank);
   void async_flush_bcast();
   void async_flush_all();
 
+  //
+  // Runs fn once during the next barrier, before termination is checked.
+  // Containers register one to flush sender-side buffers; fn may send
+  // messages and register further callbacks.  User thread only.
+  //
+  void register_pre_barrier_callback(const std::function<void()> &fn);
+
   //
   // Collective operations across all ranks.  Cannot be called inside OpenMP
   // region.
@@ -59,8 +103,12 @@ public:
   //
   //  Communicator information
   //
-  int size() const;
-  int rank() const;
+  int    size() const;
+  int    rank() const;
+  size_t buffer_capacity() const;
+  // Communicator for collective MPI calls, such as MPI-IO, made outside of
+  // YGM's messaging while no messages are in flight
+  MPI_Comm get_mpi_comm() const;
 
   //
   //	Counters
@@ -68,9 +116,22 @@ public:
   int64_t local_bytes_sent() const;
   int64_t global_bytes_sent() const;
   void reset_bytes_sent_counter();
+  int64_t local_bytes_received() const;
+  int64_t global_bytes_received() const;
+  void reset_bytes_received_counter();
   int64_t local_rpc_calls() const;
   int64_t global_rpc_calls() const;
   void reset_rpc_call_counter();
+  int64_t local_buffer_pool_hits() const;
+  int64_t local_buffer_pool_misses() const;
+  int64_t local_peak_buffer_bytes() const;
+  int64_t global_peak_buffer_bytes() const;
+  void reset_buffer_pool_counters();
+  double local_credit_wait_time() const;
+  double global_credit_wait_time() const;
+  int64_t local_credit_waits() const;
+  int64_t global_credit_waits() const;
+  void reset_credit_wait_counters();
 
   std::ostream &cout0() {
     static std::ostringstream dummy;
@@ -125,6 +186,9 @@ public:
 private:
   comm() = delete;
 
+  template <typename T>
+  friend class future;
+
   class impl;
   std::shared_ptr<impl> pimpl;
   std::shared_ptr<detail::mpi_init_finalize> pimpl_if;
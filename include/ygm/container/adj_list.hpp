@@ -0,0 +1,247 @@
+// Copyright 2019-2021 Lawrence Livermore National Security, LLC and other YGM
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <algorithm>
+#include <cereal/types/utility.hpp>
+#include <cereal/types/vector.hpp>
+#include <utility>
+#include <vector>
+#include <ygm/comm.hpp>
+#include <ygm/container/detail/csr.hpp>
+#include <ygm/container/detail/hash_partitioner.hpp>
+#include <ygm/detail/ygm_ptr.hpp>
+#include <ygm/meta/functional.hpp>
+
+namespace ygm::container {
+
+/**
+ * @brief Directed adjacency list stored as a CSR per rank.  Edges (u, v) are
+ * batched per destination and built into the owner of u's CSR by finalize().
+ *
+ * With a delegate threshold, vertices reaching that out-degree become
+ * delegates: every rank knows them, and their edges are held by the owner of
+ * each target instead, so a hub's adjacency is spread over all ranks.
+ */
+template <typename Vertex,
+          typename Partitioner = detail::hash_partitioner<Vertex>>
+class adj_list {
+ public:
+  using self_type   = adj_list<Vertex, Partitioner>;
+  using vertex_type = Vertex;
+  using edge_type   = std::pair<Vertex, Vertex>;
+
+  /**
+   * @param delegate_threshold Out-degree at which a vertex is delegated; 0
+   * disables delegation
+   */
+  adj_list(ygm::comm &comm, size_t delegate_threshold = 0)
+      : m_comm(comm),
+        m_delegate_threshold(delegate_threshold),
+        m_batches(comm.size()),
+        m_delegate_batches(comm.size()),
+        pthis(this) {
+    m_comm.barrier();
+  }
+
+  ~adj_list() { m_comm.barrier(); }
+
+  void async_insert_edge(const vertex_type &u, const vertex_type &v) {
+    if (is_delegated(u)) {
+      int dest = owner(v);
+      m_delegate_batches[dest].emplace_back(u, v);
+      if (m_delegate_batches[dest].size() >= batch_size()) {
+        send_batch(dest, m_delegate_batches[dest], true);
+      }
+    } else {
+      int dest = owner(u);
+      m_batches[dest].emplace_back(u, v);
+      if (m_batches[dest].size() >= batch_size()) {
+        send_batch(dest, m_batches[dest], false);
+      }
+    }
+  }
+
+  /**
+   * @brief Collectively builds the CSRs from every edge inserted so far,
+   * delegating vertices that reached the threshold.  Does nothing if no
+   * rank inserted edges since the last call.
+   */
+  void finalize() {
+    for (int dest = 0; dest < m_comm.size(); ++dest) {
+      send_batch(dest, m_batches[dest], false);
+      send_batch(dest, m_delegate_batches[dest], true);
+    }
+    m_comm.barrier();
+    int local_pending = !m_pending.empty() || !m_delegate_pending.empty();
+    if (!m_comm.all_reduce_max(local_pending)) {
+      return;
+    }
+
+    std::vector<edge_type> edges;
+    m_csr.append_edges(edges);
+    edges.insert(edges.end(), m_pending.begin(), m_pending.end());
+    std::vector<edge_type>().swap(m_pending);
+
+    if (m_delegate_threshold > 0) {
+      delegate_hubs(edges);
+    }
+
+    m_csr.build(edges);
+    std::vector<edge_type> delegate_edges;
+    m_delegate_csr.append_edges(delegate_edges);
+    delegate_edges.insert(delegate_edges.end(), m_delegate_pending.begin(),
+                          m_delegate_pending.end());
+    std::vector<edge_type>().swap(m_delegate_pending);
+    m_delegate_csr.build(delegate_edges);
+    m_comm.barrier();
+  }
+
+  /**
+   * @brief Calls fn(u, v) on every edge held by this rank, finalizing first.
+   */
+  template <typename Function>
+  void for_all_edges(Function fn) {
+    finalize();
+    m_csr.for_all_edges(fn);
+    m_delegate_csr.for_all_edges(fn);
+  }
+
+  /**
+   * @brief Calls visitor(u, v, args...) for each edge (u, v) built by the
+   * last finalize().  Delegated vertices are visited on every rank holding
+   * part of their adjacency.
+   */
+  template <typename Visitor, typename... VisitorArgs>
+  void async_visit_neighbors(const vertex_type &u, Visitor visitor,
+                             const VisitorArgs &...args) {
+    auto visit_wrapper = [](auto pcomm, int from, auto padj,
+                            const vertex_type &u, const VisitorArgs &...args) {
+      Visitor *vis;
+      auto &local = padj->is_delegated(u) ? padj->m_delegate_csr : padj->m_csr;
+      auto [first, last] = local.neighbors(u);
+      for (; first != last; ++first) {
+        ygm::meta::apply_optional(*vis, std::make_tuple(padj, from),
+                                  std::forward_as_tuple(u, *first, args...));
+      }
+    };
+    if (is_delegated(u)) {
+      for (int dest = 0; dest < m_comm.size(); ++dest) {
+        m_comm.async(dest, visit_wrapper, pthis, u,
+                     std::forward<const VisitorArgs>(args)...);
+      }
+    } else {
+      m_comm.async(owner(u), visit_wrapper, pthis, u,
+                   std::forward<const VisitorArgs>(args)...);
+    }
+  }
+
+  size_t num_edges() {
+    finalize();
+    return m_comm.all_reduce_sum(m_csr.num_edges() +
+                                 m_delegate_csr.num_edges());
+  }
+
+  /**
+   * @brief Number of vertices with at least one out-edge.
+   */
+  size_t num_vertices() {
+    finalize();
+    return m_comm.all_reduce_sum(m_csr.num_vertices()) + m_delegates.size();
+  }
+
+  bool is_delegated(const vertex_type &u) const {
+    return std::binary_search(m_delegates.begin(), m_delegates.end(), u);
+  }
+
+  const std::vector<vertex_type> &delegates() const { return m_delegates; }
+
+  int owner(const vertex_type &u) const {
+    auto [dest, bank] = partitioner(u, m_comm.size(), 1024);
+    return dest;
+  }
+
+  ygm::comm &comm() { return m_comm; }
+
+ private:
+  size_t batch_size() const {
+    return std::max<size_t>(1,
+                            m_comm.buffer_capacity() / (2 * sizeof(edge_type)));
+  }
+
+  void send_batch(int dest, std::vector<edge_type> &batch, bool delegate) {
+    if (batch.empty()) {
+      return;
+    }
+    auto receiver = [](auto pcomm, int from, auto padj,
+                       const std::vector<edge_type> &batch, bool delegate) {
+      auto &pending = delegate ? padj->m_delegate_pending : padj->m_pending;
+      pending.insert(pending.end(), batch.begin(), batch.end());
+    };
+    m_comm.async(dest, receiver, pthis, batch, delegate);
+    batch.clear();
+  }
+
+  /**
+   * @brief Finds new hubs among this rank's vertices, agrees on them with
+   * every rank, and moves all hub edges to the owners of their targets.
+   */
+  void delegate_hubs(std::vector<edge_type> &edges) {
+    std::sort(edges.begin(), edges.end());
+    std::vector<vertex_type> new_hubs;
+    for (size_t i = 0; i < edges.size();) {
+      size_t j = i;
+      while (j < edges.size() && edges[j].first == edges[i].first) ++j;
+      if (j - i >= m_delegate_threshold) {
+        new_hubs.push_back(edges[i].first);
+      }
+      i = j;
+    }
+    new_hubs = m_comm.all_reduce(new_hubs, [](const auto &a, const auto &b) {
+      std::vector<vertex_type> out;
+      std::set_union(a.begin(), a.end(), b.begin(), b.end(),
+                     std::back_inserter(out));
+      return out;
+    });
+    if (new_hubs.empty()) {
+      return;
+    }
+    std::vector<vertex_type> delegates;
+    std::set_union(m_delegates.begin(), m_delegates.end(), new_hubs.begin(),
+                   new_hubs.end(), std::back_inserter(delegates));
+    m_delegates.swap(delegates);
+
+    auto moved = std::stable_partition(
+        edges.begin(), edges.end(),
+        [this](const edge_type &e) { return !is_delegated(e.first); });
+    for (auto itr = moved; itr != edges.end(); ++itr) {
+      int dest = owner(itr->second);
+      m_delegate_batches[dest].push_back(*itr);
+      if (m_delegate_batches[dest].size() >= batch_size()) {
+        send_batch(dest, m_delegate_batches[dest], true);
+      }
+    }
+    edges.erase(moved, edges.end());
+    for (int dest = 0; dest < m_comm.size(); ++dest) {
+      send_batch(dest, m_delegate_batches[dest], true);
+    }
+    m_comm.barrier();
+  }
+
+  Partitioner                         partitioner;
+  ygm::comm                           m_comm;
+  size_t                              m_delegate_threshold;
+  std::vector<std::vector<edge_type>> m_batches;
+  std::vector<std::vector<edge_type>> m_delegate_batches;
+  std::vector<edge_type>              m_pending;
+  std::vector<edge_type>              m_delegate_pending;
+  detail::csr<vertex_type>            m_csr;
+  detail::csr<vertex_type>            m_delegate_csr;
+  std::vector<vertex_type>            m_delegates;
+  typename ygm::ygm_ptr<self_type>    pthis;
+};
+
+}  // namespace ygm::container
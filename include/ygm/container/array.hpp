@@ -0,0 +1,183 @@
+// Copyright 2019-2021 Lawrence Livermore National Security, LLC and other YGM
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <algorithm>
+#include <cereal/types/utility.hpp>
+#include <cereal/types/vector.hpp>
+#include <utility>
+#include <vector>
+#include <ygm/comm.hpp>
+#include <ygm/container/detail/array_partitioner.hpp>
+#include <ygm/detail/ygm_ptr.hpp>
+#include <ygm/meta/functional.hpp>
+
+namespace ygm::container {
+
+/**
+ * @brief Fixed-size distributed array.  Owners and local offsets are computed
+ * arithmetically by Partitioner (detail::block_partitioner or
+ * detail::cyclic_partitioner), so index operations need no lookup structure.
+ */
+template <typename Value, typename Partitioner = detail::block_partitioner>
+class array {
+ public:
+  using self_type  = array<Value, Partitioner>;
+  using value_type = Value;
+
+  // Elements sharing a shard run on the same handler thread; spans of
+  // neighbouring indices share one to avoid false sharing
+  static constexpr size_t shard_span = 64;
+
+  array(ygm::comm &comm, size_t size, const value_type &fill = value_type())
+      : m_comm(comm),
+        m_partitioner(size, comm.size()),
+        m_default_value(fill),
+        pthis(this) {
+    m_local.resize(m_partitioner.local_size(m_comm.rank()), fill);
+    m_comm.barrier();
+  }
+
+  ~array() { m_comm.barrier(); }
+
+  size_t size() const { return m_partitioner.m_size; }
+
+  int owner(size_t index) const { return m_partitioner.owner(index); }
+
+  bool is_mine(size_t index) const { return owner(index) == m_comm.rank(); }
+
+  void async_set(size_t index, const value_type &value) {
+    ASSERT_RELEASE(index < size());
+    auto setter = [](auto pcomm, int from, auto parr, size_t index,
+                     const value_type &value) {
+      parr->local_ref(index) = value;
+    };
+    m_comm.async_sharded(owner(index), shard(index), setter, pthis, index,
+                         value);
+  }
+
+  /**
+   * @brief Calls visitor(index, value, args...) on the owner of index, with
+   * value a mutable reference.
+   */
+  template <typename Visitor, typename... VisitorArgs>
+  void async_visit(size_t index, Visitor visitor,
+                   const VisitorArgs &...args) {
+    ASSERT_RELEASE(index < size());
+    auto visit_wrapper = [](auto pcomm, int from, auto parr, size_t index,
+                            const VisitorArgs &...args) {
+      Visitor *vis;
+      ygm::meta::apply_optional(
+          *vis, std::make_tuple(parr, from),
+          std::forward_as_tuple(index, parr->local_ref(index), args...));
+    };
+    m_comm.async_sharded(owner(index), shard(index), visit_wrapper, pthis,
+                         index, std::forward<const VisitorArgs>(args)...);
+  }
+
+  /**
+   * @brief Replaces element index with op(element, value) on its owner.
+   */
+  template <typename ReductionOp>
+  void async_reduce(size_t index, const value_type &value, ReductionOp op) {
+    ASSERT_RELEASE(index < size());
+    auto reducer = [](auto pcomm, int from, auto parr, size_t index,
+                      const value_type &value) {
+      ReductionOp *op;
+      auto        &element = parr->local_ref(index);
+      element              = (*op)(element, value);
+    };
+    m_comm.async_sharded(owner(index), shard(index), reducer, pthis, index,
+                         value);
+  }
+
+  /**
+   * @brief Calls fn(index, value) on every element.
+   */
+  template <typename Function>
+  void for_all(Function fn) {
+    m_comm.barrier();
+    local_for_all(fn);
+  }
+
+  template <typename Function>
+  void local_for_all(Function fn) {
+    for (size_t i = 0; i < m_local.size(); ++i) {
+      fn(m_partitioner.global_index(m_comm.rank(), i), m_local[i]);
+    }
+  }
+
+  /**
+   * @brief Collectively changes the size, moving elements whose owner
+   * changes.  New elements are set to fill.
+   */
+  void resize(size_t new_size, const value_type &fill) {
+    m_comm.barrier();
+    Partitioner new_partitioner(new_size, m_comm.size());
+    std::vector<value_type> new_local(
+        new_partitioner.local_size(m_comm.rank()), fill);
+
+    using entry_type = std::pair<size_t, value_type>;
+    using batch_type = std::vector<entry_type>;
+    auto receiver    = [](auto pcomm, int from, auto parr,
+                       const batch_type &batch) {
+      parr->m_resize_inbox.insert(parr->m_resize_inbox.end(), batch.begin(),
+                                  batch.end());
+    };
+    size_t batch_size = std::max<size_t>(
+        1, m_comm.buffer_capacity() / (2 * sizeof(entry_type)));
+    std::vector<batch_type> batches(m_comm.size());
+    for (size_t i = 0; i < m_local.size(); ++i) {
+      size_t index = m_partitioner.global_index(m_comm.rank(), i);
+      if (index >= new_size) continue;
+      int dest = new_partitioner.owner(index);
+      if (dest == m_comm.rank()) {
+        new_local[new_partitioner.local_index(index)] = std::move(m_local[i]);
+      } else {
+        batches[dest].emplace_back(index, std::move(m_local[i]));
+        if (batches[dest].size() >= batch_size) {
+          m_comm.async(dest, receiver, pthis, batches[dest]);
+          batches[dest].clear();
+        }
+      }
+    }
+    for (int dest = 0; dest < m_comm.size(); ++dest) {
+      if (!batches[dest].empty()) {
+        m_comm.async(dest, receiver, pthis, batches[dest]);
+      }
+    }
+    m_comm.barrier();
+
+    for (auto &[index, value] : m_resize_inbox) {
+      new_local[new_partitioner.local_index(index)] = std::move(value);
+    }
+    std::vector<std::pair<size_t, value_type>>().swap(m_resize_inbox);
+    m_local.swap(new_local);
+    m_partitioner = new_partitioner;
+  }
+
+  void resize(size_t new_size) { resize(new_size, m_default_value); }
+
+  ygm::comm &comm() { return m_comm; }
+
+  value_type &local_ref(size_t index) {
+    return m_local[m_partitioner.local_index(index)];
+  }
+
+ private:
+  uint32_t shard(size_t index) const {
+    return m_partitioner.local_index(index) / shard_span;
+  }
+
+  ygm::comm                                  m_comm;
+  Partitioner                                m_partitioner;
+  value_type                                 m_default_value;
+  std::vector<value_type>                    m_local;
+  std::vector<std::pair<size_t, value_type>> m_resize_inbox;
+  typename ygm::ygm_ptr<self_type>           pthis;
+};
+
+}  // namespace ygm::container
@@ -16,6 +16,9 @@ class bag {
 
   bag(ygm::comm &comm) : m_impl(comm) {}
 
+  // Keeps local data in per-rank memory-mapped files; needs an mmap_allocator
+  bag(ygm::comm &comm, const detail::mmap_file &file) : m_impl(comm, file) {}
+
   void async_insert(const value_type &item) { m_impl.async_insert(item); }
 
   template <typename Function>
@@ -36,10 +39,45 @@ class bag {
 
   ygm::comm &comm() { return m_impl.comm(); }
 
+  // Collective sample sort into a new block-distributed container; the bag
+  // is unchanged
+  template <typename Compare = std::less<value_type>>
+  sorted_array<value_type, Compare> sort(Compare cfn = Compare()) {
+    return m_impl.sort(cfn);
+  }
+
+  // Collective global top-k, best first under cfn
+  template <typename Compare = std::greater<value_type>>
+  std::vector<value_type> topk(size_t k, Compare cfn = Compare()) {
+    return m_impl.topk(k, cfn);
+  }
+
+  // Collective exact selection of the item of global rank n under cfn
+  template <typename Compare = std::less<value_type>>
+  value_type nth_element(size_t n, Compare cfn = Compare()) {
+    return m_impl.nth_element(n, cfn);
+  }
+
+  // Collective exact quantile, q in [0, 1]
+  template <typename Compare = std::less<value_type>>
+  value_type quantile(double q, Compare cfn = Compare()) {
+    return m_impl.quantile(q, cfn);
+  }
+
+  // Collective approximate quantiles from mergeable per-rank sketches
+  template <typename Compare = std::less<value_type>>
+  std::vector<value_type> approx_quantiles(const std::vector<double> &qs,
+                                           Compare cfn = Compare()) {
+    return m_impl.approx_quantiles(qs, cfn);
+  }
+
   void serialize(const std::string &fname) { m_impl.serialize(fname); }
   void deserialize(const std::string &fname) { m_impl.deserialize(fname); }
+  void checkpoint(const std::string &fname) { m_impl.checkpoint(fname); }
+  void restore(const std::string &fname) { m_impl.restore(fname); }
+  void persist() { m_impl.persist(); }
 
  private:
-  detail::bag_impl<value_type> m_impl;
+  impl_type m_impl;
 };
 }  // namespace ygm::container
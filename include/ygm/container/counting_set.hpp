@@ -6,6 +6,7 @@
 #pragma once
 
 #include <ygm/comm.hpp>
+#include <ygm/container/detail/count_cache.hpp>
 #include <ygm/container/map.hpp>
 #include <ygm/detail/ygm_ptr.hpp>
 
@@ -13,17 +14,22 @@ namespace ygm::container {
 
 template <typename Key, typename Partitioner = detail::hash_partitioner<Key>,
           typename Compare = std::less<Key>,
-          class Alloc = std::allocator<std::pair<const Key, size_t>>>
+          class Alloc = std::allocator<std::pair<const Key, size_t>>,
+          typename Storage = detail::tree_storage>
 class counting_set {
 public:
-  using self_type = counting_set<Key, Partitioner, Compare, Alloc>;
+  using self_type = counting_set<Key, Partitioner, Compare, Alloc, Storage>;
   using key_type = Key;
   using value_type = size_t;
-  const size_t count_cache_size = 1024 * 1024;
+  static constexpr size_t default_cache_capacity = 64 * 1024;
+  static constexpr size_t default_cache_ways = 8;
 
-  counting_set(ygm::comm &comm) : m_map(comm, value_type(0)), pthis(this) {
-    m_count_cache.resize(count_cache_size, {key_type(), -1});
-  }
+  // A cache_capacity of 0 sends every insert immediately
+  counting_set(ygm::comm &comm,
+               size_t cache_capacity = default_cache_capacity,
+               size_t cache_ways = default_cache_ways)
+      : m_count_cache(cache_capacity, cache_ways), m_map(comm, value_type(0)),
+        pthis(this) {}
 
   void async_insert(const key_type &key) { cache_insert(key); }
 
@@ -75,6 +81,60 @@ public:
     return m_map.all_gather(keys);
   }
 
+  // Non-collective all_gather.  Only this rank's cached counts are flushed
+  // first; counts other ranks still cache are not reflected.
+  template <typename STLKeyContainer>
+  auto async_gather(const STLKeyContainer &keys) {
+    count_cache_flush_all();
+    return m_map.async_gather(keys);
+  }
+
+  // Collective top-k keys by count, most frequent first
+  std::vector<std::pair<key_type, value_type>> topk(size_t k) {
+    count_cache_flush_all();
+    return m_map.topk(k, [](const auto &a, const auto &b) {
+      return a.second > b.second;
+    });
+  }
+
+  // Collective selection of the key at rank n of the multiset of inserted
+  // keys, i.e. each key weighted by its count
+  key_type nth_element(size_t n) {
+    return detail::distributed_select(m_map.comm(), local_weighted(), n,
+                                      Compare());
+  }
+
+  // Collective exact quantile of inserted keys, q in [0, 1]
+  key_type quantile(double q) {
+    return detail::distributed_quantile(m_map.comm(), local_weighted(), q,
+                                        Compare());
+  }
+
+  // Collective approximate quantiles of inserted keys
+  std::vector<key_type> approx_quantiles(const std::vector<double> &qs) {
+    count_cache_flush_all();
+    detail::quantile_sketch<key_type> sketch;
+    m_map.for_all([&sketch](const auto &kv) {
+      sketch.insert(kv.first, kv.second, Compare());
+    });
+    return detail::distributed_approx_quantiles(m_map.comm(), sketch, qs,
+                                                Compare());
+  }
+
+  // Flushes this rank's cache and changes its geometry.  Not collective.
+  void resize_cache(size_t cache_capacity,
+                    size_t cache_ways = default_cache_ways) {
+    count_cache_flush_all();
+    m_count_cache.reset(cache_capacity, cache_ways);
+  }
+
+  // This rank's cache hits, misses, evictions and flush messages
+  const detail::count_cache_stats &cache_stats() const {
+    return m_count_cache.stats();
+  }
+
+  void reset_cache_stats() { m_count_cache.reset_stats(); }
+
   void serialize(const std::string &fname) {
     count_cache_flush_all();
     m_map.serialize(fname);
@@ -83,62 +143,53 @@ public:
     count_cache_flush_all();
     m_map.deserialize(fname);
   }
+  void checkpoint(const std::string &fname) {
+    count_cache_flush_all();
+    m_map.checkpoint(fname);
+  }
+  void restore(const std::string &fname) {
+    count_cache_flush_all();
+    m_map.restore(fname);
+  }
 
 private:
+  std::vector<std::pair<key_type, uint64_t>> local_weighted() {
+    count_cache_flush_all();
+    std::vector<std::pair<key_type, uint64_t>> to_return;
+    m_map.for_all([&to_return](const auto &kv) {
+      to_return.emplace_back(kv.first, kv.second);
+    });
+    return to_return;
+  }
+
   void cache_erase(const key_type &key) {
-    size_t slot = std::hash<key_type>{}(key) % count_cache_size;
-    if (m_count_cache[slot].second != -1 && m_count_cache[slot].first == key) {
-      // Key was cached, clear cache
-      m_count_cache[slot].second = -1;
-      m_count_cache[slot].first = key_type();
-    }
+    m_count_cache.erase(key);
     m_map.async_erase(key);
   }
+
   void cache_insert(const key_type &key) {
-    size_t slot = std::hash<key_type>{}(key) % count_cache_size;
-    if (m_count_cache[slot].second == -1) {
-      m_count_cache[slot].first = key;
-      m_count_cache[slot].second = 1;
-    } else {
-      // flush slot, fill with key
-      ASSERT_DEBUG(m_count_cache[slot].second > 0);
-      if (m_count_cache[slot].first == key) {
-        m_count_cache[slot].second++;
-      } else {
-        count_cache_flush(slot);
-        ASSERT_DEBUG(m_count_cache[slot].second == -1);
-        m_count_cache[slot].first = key;
-        m_count_cache[slot].second = 1;
-      }
-    }
-    if (m_count_cache[slot].second == std::numeric_limits<int32_t>::max()) {
-      count_cache_flush(slot);
-    }
+    m_count_cache.insert(key, [this](const key_type &key, int32_t count) {
+      count_cache_flush(key, count);
+    });
   }
 
-  void count_cache_flush(size_t slot) {
-    auto key = m_count_cache[slot].first;
-    auto cached_count = m_count_cache[slot].second;
+  void count_cache_flush(const key_type &key, int32_t cached_count) {
     ASSERT_DEBUG(cached_count > 0);
     m_map.async_visit(key,
                       [](std::pair<const key_type, size_t> &key_count,
                          int32_t to_add) { key_count.second += to_add; },
                       cached_count);
-    m_count_cache[slot].first = key_type();
-    m_count_cache[slot].second = -1;
   }
 
   void count_cache_flush_all() {
-    for (size_t i = 0; i < m_count_cache.size(); ++i) {
-      if (m_count_cache[i].second > 0) {
-        count_cache_flush(i);
-      }
-    }
+    m_count_cache.flush_all([this](const key_type &key, int32_t count) {
+      count_cache_flush(key, count);
+    });
   }
   counting_set() = delete;
 
-  std::vector<std::pair<Key, int32_t>> m_count_cache;
-  map<Key, value_type, Partitioner, Compare, Alloc> m_map;
+  detail::count_cache<Key> m_count_cache;
+  map<Key, value_type, Partitioner, Compare, Alloc, Storage> m_map;
   typename ygm::ygm_ptr<self_type> pthis;
 };
 
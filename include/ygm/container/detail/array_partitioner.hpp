@@ -0,0 +1,63 @@
+// Copyright 2019-2021 Lawrence Livermore National Security, LLC and other YGM
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <cstddef>
+
+namespace ygm::container::detail {
+
+/**
+ * @brief Contiguous blocks of ceil(size / nranks) indices per rank.
+ */
+struct block_partitioner {
+  block_partitioner(size_t size, int nranks)
+      : m_nranks(nranks), m_block((size + nranks - 1) / nranks), m_size(size) {
+    if (m_block == 0) m_block = 1;
+  }
+
+  int owner(size_t index) const { return index / m_block; }
+
+  size_t local_index(size_t index) const { return index % m_block; }
+
+  size_t global_index(int rank, size_t local) const {
+    return rank * m_block + local;
+  }
+
+  size_t local_size(int rank) const {
+    size_t first = rank * m_block;
+    if (first >= m_size) return 0;
+    return first + m_block > m_size ? m_size - first : m_block;
+  }
+
+  int    m_nranks;
+  size_t m_block;
+  size_t m_size;
+};
+
+/**
+ * @brief Index i lives on rank i % nranks.
+ */
+struct cyclic_partitioner {
+  cyclic_partitioner(size_t size, int nranks)
+      : m_nranks(nranks), m_size(size) {}
+
+  int owner(size_t index) const { return index % m_nranks; }
+
+  size_t local_index(size_t index) const { return index / m_nranks; }
+
+  size_t global_index(int rank, size_t local) const {
+    return local * m_nranks + rank;
+  }
+
+  size_t local_size(int rank) const {
+    return m_size / m_nranks + (size_t(rank) < m_size % m_nranks ? 1 : 0);
+  }
+
+  int    m_nranks;
+  size_t m_size;
+};
+
+}  // namespace ygm::container::detail
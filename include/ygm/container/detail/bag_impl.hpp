@@ -8,23 +8,49 @@
 #include <fstream>
 #include <vector>
 #include <ygm/comm.hpp>
+#include <ygm/container/detail/checkpoint.hpp>
+#include <ygm/container/detail/mmap_allocator.hpp>
+#include <ygm/container/sorted_array.hpp>
+#include <ygm/container/detail/selection.hpp>
 #include <ygm/detail/ygm_ptr.hpp>
 
 namespace ygm::container::detail {
 template <typename Item, typename Alloc = std::allocator<Item>>
 class bag_impl {
  public:
-  using value_type = Item;
-  using self_type  = bag_impl<Item, Alloc>;
+  using value_type     = Item;
+  using self_type      = bag_impl<Item, Alloc>;
+  using local_bag_type = std::vector<value_type, Alloc>;
 
-  bag_impl(ygm::comm &comm) : m_comm(comm), pthis(this) { m_comm.barrier(); }
+  // Whether local data lives in a memory-mapped file, see mmap_file
+  static constexpr bool persistent = is_mmap_allocator<Alloc>::value;
+  static_assert(!persistent || std::is_trivially_copyable_v<Item>,
+                "Persistent bags need items that own no memory");
+
+  bag_impl(ygm::comm &comm) : m_comm(comm), m_local_bags(1), pthis(this) {
+    m_comm.barrier();
+  }
+
+  /**
+   * @brief Constructs a bag whose local items live in the files named by
+   * file, reattaching to the items left there by an earlier job on the same
+   * number of ranks, or starting empty.
+   */
+  bag_impl(ygm::comm &comm, const mmap_file &file)
+      : m_comm(comm),
+        m_mmap(std::make_unique<mmap_root<local_bag_type>>(m_comm, file, 1)),
+        m_local_bags(*m_mmap),
+        pthis(this) {
+    static_assert(persistent, "mmap_file requires an mmap_allocator");
+    m_comm.barrier();
+  }
 
   ~bag_impl() { m_comm.barrier(); }
 
   void async_insert(const value_type &item) {
     auto inserter = [](auto mailbox, int from, auto map,
                        const value_type &item) {
-      map->m_local_bag.push_back(item);
+      map->local_bag().push_back(item);
     };
     int dest = (m_round_robin++ + m_comm.rank()) % m_comm.size();
     m_comm.async(dest, inserter, pthis, item);
@@ -38,27 +64,37 @@ class bag_impl {
 
   void clear() {
     m_comm.barrier();
-    m_local_bag.clear();
+    local_bag().clear();
   }
 
   size_t size() {
     m_comm.barrier();
-    return m_comm.all_reduce_sum(m_local_bag.size());
+    return m_comm.all_reduce_sum(local_bag().size());
   }
 
   void swap(self_type &s) {
     m_comm.barrier();
-    m_local_bag.swap(s.m_local_bag);
+    m_local_bags.swap(s.m_local_bags);
+    m_mmap.swap(s.m_mmap);
   }
 
   ygm::comm &comm() { return m_comm; }
 
+  /**
+   * @brief Collectively flushes a persistent bag's files, which unmapping
+   * them at destruction also does.
+   */
+  void persist() {
+    m_comm.barrier();
+    m_mmap->sync();
+  }
+
   void serialize(const std::string &fname) {
     m_comm.barrier();
     std::string   rank_fname = fname + std::to_string(m_comm.rank());
     std::ofstream os(rank_fname, std::ios::binary);
     cereal::JSONOutputArchive oarchive(os);
-    oarchive(m_local_bag, m_round_robin, m_comm.size());
+    oarchive(local_bag(), m_round_robin, m_comm.size());
   }
 
   void deserialize(const std::string &fname) {
@@ -69,7 +105,7 @@ class bag_impl {
 
     cereal::JSONInputArchive iarchive(is);
     int                      comm_size;
-    iarchive(m_local_bag, m_round_robin, comm_size);
+    iarchive(local_bag(), m_round_robin, comm_size);
 
     if (comm_size != m_comm.size()) {
       m_comm.cerr0(
@@ -78,15 +114,108 @@ class bag_impl {
     }
   }
 
+  /**
+   * @brief Collectively writes a binary checkpoint of the bag into the single
+   * file fname.
+   */
+  void checkpoint(const std::string &fname) {
+    m_comm.barrier();
+    checkpoint_writer writer(m_comm);
+    writer.meta(m_round_robin);
+    for (const auto &item : local_bag()) {
+      writer.record(item);
+    }
+    writer.write(fname);
+  }
+
+  /**
+   * @brief Collectively replaces the contents of the bag with a checkpoint.
+   * With the rank count it was written with, every rank reloads its own
+   * items.  Otherwise rank r streams the payloads of the old ranks congruent
+   * to r modulo the current size and deals their items round robin with
+   * async_insert, so the bag ends up balanced over the new ranks.
+   */
+  void restore(const std::string &fname) {
+    m_comm.barrier();
+    checkpoint_reader reader(m_comm, fname);
+    local_bag().clear();
+    if (reader.num_ranks() == m_comm.size()) {
+      reader.read_meta(m_comm.rank(), m_round_robin);
+      reader.for_each_record<value_type>(
+          m_comm.rank(),
+          [this](value_type &item) { local_bag().push_back(std::move(item)); });
+    } else {
+      for (int old_rank = m_comm.rank(); old_rank < reader.num_ranks();
+           old_rank += m_comm.size()) {
+        reader.for_each_record<value_type>(
+            old_rank, [this](value_type &item) { async_insert(item); });
+      }
+    }
+    m_comm.barrier();
+  }
+
+  template <typename Compare>
+  sorted_array<value_type, Compare> sort(Compare cfn) {
+    m_comm.barrier();
+    return sorted_array<value_type, Compare>(
+        m_comm, std::vector<value_type>(local_bag().begin(), local_bag().end()),
+        cfn);
+  }
+
+  template <typename Compare>
+  std::vector<value_type> topk(size_t k, Compare cfn) {
+    m_comm.barrier();
+    bounded_heap<value_type, Compare> heap(k, cfn);
+    local_for_all([&heap](const value_type &v) { heap.push(v); });
+    return distributed_topk(m_comm, std::move(heap), k, cfn);
+  }
+
+  template <typename Compare>
+  value_type nth_element(size_t n, Compare cfn) {
+    m_comm.barrier();
+    return distributed_select(m_comm, local_weighted(), n, cfn);
+  }
+
+  template <typename Compare>
+  value_type quantile(double q, Compare cfn) {
+    m_comm.barrier();
+    return distributed_quantile(m_comm, local_weighted(), q, cfn);
+  }
+
+  template <typename Compare>
+  std::vector<value_type> approx_quantiles(const std::vector<double> &qs,
+                                           Compare                    cfn) {
+    m_comm.barrier();
+    quantile_sketch<value_type> sketch;
+    local_for_all(
+        [&sketch, &cfn](const value_type &v) { sketch.insert(v, 1, cfn); });
+    return distributed_approx_quantiles(m_comm, sketch, qs, cfn);
+  }
+
   template <typename Function>
   void local_for_all(Function fn) {
-    std::for_each(m_local_bag.begin(), m_local_bag.end(), fn);
+    std::for_each(local_bag().begin(), local_bag().end(), fn);
   }
 
  protected:
-  size_t                           m_round_robin = 0;
-  ygm::comm                        m_comm;
-  std::vector<value_type>          m_local_bag;
-  typename ygm::ygm_ptr<self_type> pthis;
+  local_bag_type       &local_bag() { return m_local_bags[0]; }
+  const local_bag_type &local_bag() const { return m_local_bags[0]; }
+
+  std::vector<std::pair<value_type, uint64_t>> local_weighted() const {
+    std::vector<std::pair<value_type, uint64_t>> to_return;
+    to_return.reserve(local_bag().size());
+    for (const auto &v : local_bag()) {
+      to_return.emplace_back(v, 1);
+    }
+    return to_return;
+  }
+
+  size_t                                     m_round_robin = 0;
+  ygm::comm                                  m_comm;
+  // Declared before m_local_bags, which may point into its mapping
+  std::unique_ptr<mmap_root<local_bag_type>> m_mmap;
+  // A single shard, owned or the root of the mapped file
+  shard_array<local_bag_type>                m_local_bags;
+  typename ygm::ygm_ptr<self_type>           pthis;
 };
 }  // namespace ygm::container::detail
@@ -0,0 +1,273 @@
+// Copyright 2019-2021 Lawrence Livermore National Security, LLC and other YGM
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <tuple>
+#include <vector>
+#include <ygm/comm.hpp>
+#include <ygm/detail/mpi.hpp>
+#include <ygm/detail/ygm_cereal_archive.hpp>
+
+namespace ygm::container::detail {
+
+/**
+ * Binary container checkpoints, written collectively into a single file.
+ *
+ * The file starts with a header of native-endian uint64 words: magic,
+ * version, the number of ranks that wrote it, then one index entry per rank
+ * of {offset, bytes, records} locating that rank's payload.  A payload is a
+ * sequence of blocks, each a {bytes, records} pair of uint64 followed by that
+ * many bytes of YGMOutputArchive data.  The first block holds the
+ * container's metadata and no records, the rest hold records of a fixed
+ * tuple of fields, so a reader can stream a payload one block at a time.
+ */
+struct checkpoint_entry {
+  uint64_t offset;
+  uint64_t bytes;
+  uint64_t records;
+};
+
+inline constexpr uint64_t checkpoint_magic   = 0x54504b434d4759ULL;  // YGMCKPT
+inline constexpr uint64_t checkpoint_version = 1;
+// Largest single MPI-IO call, keeping counts within int
+inline constexpr size_t checkpoint_io_chunk = size_t(1) << 30;
+
+/**
+ * @brief Collects this rank's checkpoint payload and writes every rank's
+ * payload into one file with MPI_File_write_at_all.
+ */
+class checkpoint_writer {
+ public:
+  explicit checkpoint_writer(ygm::comm &comm,
+                             size_t     block_capacity = size_t(1) << 20)
+      : m_comm(comm), m_block_capacity(block_capacity) {}
+
+  /**
+   * @brief Writes the metadata block; must come before any record.
+   */
+  template <typename... Meta>
+  void meta(const Meta &... meta) {
+    ASSERT_RELEASE(m_payload.empty());
+    open_block();
+    if constexpr (sizeof...(Meta) > 0) {
+      m_archive(meta...);
+    }
+    close_block();
+  }
+
+  template <typename... Fields>
+  void record(const Fields &... fields) {
+    if (!m_block_open) {
+      open_block();
+    }
+    m_archive(fields...);
+    ++m_block_records;
+    ++m_records;
+    if (m_payload.size() - m_block_start >= m_block_capacity) {
+      close_block();
+    }
+  }
+
+  /**
+   * @brief Collectively writes the file.  Ranks must not be sending messages.
+   */
+  void write(const std::string &fname) {
+    if (m_block_open) {
+      close_block();
+    }
+    MPI_Comm mpi_comm = m_comm.get_mpi_comm();
+    int      nranks   = m_comm.size();
+
+    uint64_t              local[2] = {m_payload.size(), m_records};
+    std::vector<uint64_t> sizes(2 * nranks);
+    ASSERT_MPI(MPI_Allgather(local, 2, MPI_UINT64_T, sizes.data(), 2,
+                             MPI_UINT64_T, mpi_comm));
+
+    std::vector<uint64_t> header{checkpoint_magic, checkpoint_version,
+                                 uint64_t(nranks)};
+    uint64_t offset = (3 + 3 * uint64_t(nranks)) * sizeof(uint64_t);
+    uint64_t my_offset{0};
+    for (int r = 0; r < nranks; ++r) {
+      if (r == m_comm.rank()) my_offset = offset;
+      header.insert(header.end(), {offset, sizes[2 * r], sizes[2 * r + 1]});
+      offset += sizes[2 * r];
+    }
+
+    MPI_File fh;
+    ASSERT_MPI(MPI_File_open(mpi_comm, fname.c_str(),
+                             MPI_MODE_CREATE | MPI_MODE_WRONLY, MPI_INFO_NULL,
+                             &fh));
+    ASSERT_MPI(MPI_File_set_size(fh, offset));
+    size_t header_bytes = m_comm.rank0() ? header.size() * sizeof(uint64_t) : 0;
+    write_at_all(fh, 0, reinterpret_cast<const char *>(header.data()),
+                 header_bytes);
+    write_at_all(fh, my_offset, m_payload.data(), m_payload.size());
+    ASSERT_MPI(MPI_File_close(&fh));
+  }
+
+  size_t payload_bytes() const { return m_payload.size(); }
+
+ private:
+  void open_block() {
+    m_block_start = m_payload.size();
+    m_payload.resize(m_block_start + 2 * sizeof(uint64_t));
+    m_block_records = 0;
+    m_block_open    = true;
+  }
+
+  void close_block() {
+    uint64_t block_header[2] = {
+        m_payload.size() - m_block_start - 2 * sizeof(uint64_t),
+        m_block_records};
+    std::memcpy(m_payload.data() + m_block_start, block_header,
+                sizeof(block_header));
+    m_block_open = false;
+  }
+
+  // Every rank makes the same number of calls, writing empty chunks once
+  // its data is written
+  void write_at_all(MPI_File fh, uint64_t offset, const char *data,
+                    size_t bytes) {
+    long chunks     = (bytes + checkpoint_io_chunk - 1) / checkpoint_io_chunk;
+    long max_chunks = m_comm.all_reduce_max(chunks);
+    for (long i = 0; i < max_chunks; ++i) {
+      size_t begin = std::min(bytes, i * checkpoint_io_chunk);
+      size_t count = std::min(bytes - begin, checkpoint_io_chunk);
+      ASSERT_MPI(MPI_File_write_at_all(fh, offset + begin, data + begin,
+                                       int(count), MPI_BYTE,
+                                       MPI_STATUS_IGNORE));
+    }
+  }
+
+  ygm::comm               &m_comm;
+  size_t                   m_block_capacity;
+  std::vector<char>        m_payload;
+  cereal::YGMOutputArchive m_archive{m_payload};
+  size_t                   m_block_start   = 0;
+  uint64_t                 m_block_records = 0;
+  uint64_t                 m_records       = 0;
+  bool                     m_block_open    = false;
+};
+
+/**
+ * @brief Reads a checkpoint written by checkpoint_writer.  Opening reads the
+ * header collectively; payloads are then read independently, one buffer of
+ * whole blocks at a time, so any rank can stream any rank's payload.
+ */
+class checkpoint_reader {
+ public:
+  checkpoint_reader(ygm::comm &comm, const std::string &fname,
+                    size_t read_capacity = size_t(16) << 20)
+      : m_comm(comm), m_read_capacity(read_capacity) {
+    ASSERT_MPI(MPI_File_open(m_comm.get_mpi_comm(), fname.c_str(),
+                             MPI_MODE_RDONLY, MPI_INFO_NULL, &m_fh));
+    uint64_t fixed[3];
+    ASSERT_MPI(MPI_File_read_at_all(m_fh, 0, fixed, 3, MPI_UINT64_T,
+                                    MPI_STATUS_IGNORE));
+    if (fixed[0] != checkpoint_magic || fixed[1] != checkpoint_version) {
+      throw std::runtime_error("Not a YGM checkpoint: " + fname);
+    }
+    m_index.resize(fixed[2]);
+    ASSERT_MPI(MPI_File_read_at_all(m_fh, sizeof(fixed), m_index.data(),
+                                    int(3 * fixed[2]), MPI_UINT64_T,
+                                    MPI_STATUS_IGNORE));
+  }
+
+  ~checkpoint_reader() { MPI_File_close(&m_fh); }
+
+  checkpoint_reader(const checkpoint_reader &)            = delete;
+  checkpoint_reader &operator=(const checkpoint_reader &) = delete;
+
+  // Number of ranks that wrote the checkpoint
+  int num_ranks() const { return m_index.size(); }
+
+  const std::vector<checkpoint_entry> &index() const { return m_index; }
+
+  /**
+   * @brief Reads the metadata block of old_rank's payload.
+   */
+  template <typename... Meta>
+  void read_meta(int old_rank, Meta &... meta) {
+    uint64_t block_header[2];
+    read_at(m_index[old_rank].offset, reinterpret_cast<char *>(block_header),
+            sizeof(block_header));
+    std::vector<char> block(block_header[0]);
+    read_at(m_index[old_rank].offset + sizeof(block_header), block.data(),
+            block.size());
+    if constexpr (sizeof...(Meta) > 0) {
+      cereal::YGMInputArchive iarchive(block.data(), block.size());
+      iarchive(meta...);
+    }
+  }
+
+  /**
+   * @brief Calls fn(fields &...) with every record of old_rank's payload,
+   * holding at most about read_capacity bytes of it at a time.  fn may move
+   * from the fields.
+   */
+  template <typename... Fields, typename Function>
+  void for_each_record(int old_rank, Function fn) {
+    const auto &entry    = m_index[old_rank];
+    uint64_t    position = 0;
+    bool        is_meta  = true;
+    std::vector<char> buffer;
+    while (position < entry.bytes) {
+      // Read as many whole blocks as fit, and at least one
+      size_t want = std::min<uint64_t>(entry.bytes - position,
+                                       std::max(m_read_capacity, buffer.size()));
+      buffer.resize(want);
+      read_at(entry.offset + position, buffer.data(), want);
+      size_t used = 0;
+      while (used + 2 * sizeof(uint64_t) <= want) {
+        uint64_t block_header[2];
+        std::memcpy(block_header, buffer.data() + used, sizeof(block_header));
+        size_t block_end = used + sizeof(block_header) + block_header[0];
+        if (block_end > want) {
+          break;
+        }
+        if (!is_meta) {
+          cereal::YGMInputArchive iarchive(
+              buffer.data() + used + sizeof(block_header), block_header[0]);
+          for (uint64_t i = 0; i < block_header[1]; ++i) {
+            std::tuple<Fields...> record;
+            std::apply([&iarchive](auto &... f) { iarchive(f...); }, record);
+            std::apply(fn, record);
+          }
+        }
+        is_meta = false;
+        used    = block_end;
+      }
+      if (used == 0) {
+        // The next block is larger than the buffer
+        uint64_t block_header[2];
+        std::memcpy(block_header, buffer.data(), sizeof(block_header));
+        buffer.resize(sizeof(block_header) + block_header[0]);
+        continue;
+      }
+      position += used;
+    }
+  }
+
+ private:
+  void read_at(uint64_t offset, char *data, size_t bytes) {
+    for (size_t begin = 0; begin < bytes; begin += checkpoint_io_chunk) {
+      size_t count = std::min(bytes - begin, checkpoint_io_chunk);
+      ASSERT_MPI(MPI_File_read_at(m_fh, offset + begin, data + begin,
+                                  int(count), MPI_BYTE, MPI_STATUS_IGNORE));
+    }
+  }
+
+  ygm::comm                    &m_comm;
+  size_t                        m_read_capacity;
+  MPI_File                      m_fh;
+  std::vector<checkpoint_entry> m_index;
+};
+
+}  // namespace ygm::container::detail
@@ -0,0 +1,199 @@
+// Copyright 2019-2021 Lawrence Livermore National Security, LLC and other YGM
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <vector>
+
+namespace ygm::container::detail {
+
+struct count_cache_stats {
+  uint64_t hits      = 0;
+  uint64_t misses    = 0;
+  uint64_t evictions = 0;
+  uint64_t flushes   = 0;
+
+  double hit_rate() const {
+    uint64_t lookups = hits + misses;
+    return lookups == 0 ? 0.0 : double(hits) / double(lookups);
+  }
+};
+
+/**
+ * @brief Set-associative cache of pending counts.  A key maps to one set of
+ * ways slots; a miss in a full set evicts by CLOCK over small per-slot use
+ * counters, so frequently hit keys survive colliding cold keys.
+ *
+ * Occupied slots are tracked in a dirty list, so flush_all costs the number
+ * of occupied slots rather than the capacity.  Slots are allocated on first
+ * insert.  Evicted and flushed counts are handed to a flush(key, count)
+ * callback, which may re-enter insert.
+ */
+template <typename Key>
+class count_cache {
+ public:
+  using key_type = Key;
+
+  count_cache(size_t capacity, size_t ways) { reset(capacity, ways); }
+
+  /**
+   * @brief Adds one to key's count, evicting a colder key from its set if
+   * the set is full.
+   */
+  template <typename Flush>
+  void insert(const key_type &key, Flush flush) {
+    if (m_capacity == 0) {
+      ++m_stats.misses;
+      ++m_stats.flushes;
+      flush(key, int32_t(1));
+      return;
+    }
+    if (m_slots.empty()) {
+      m_slots.resize(m_num_sets * m_ways);
+      m_hands.resize(m_num_sets, 0);
+    }
+
+    size_t base = set_index(key) * m_ways;
+    size_t free = m_ways;
+    for (size_t way = 0; way < m_ways; ++way) {
+      slot_type &s = m_slots[base + way];
+      if (!s.used) {
+        if (free == m_ways) free = way;
+      } else if (s.key == key) {
+        ++m_stats.hits;
+        if (s.use < max_use) ++s.use;
+        if (++s.count == std::numeric_limits<int32_t>::max()) {
+          int32_t count = s.count;
+          s.count       = 0;
+          ++m_stats.flushes;
+          flush(key, count);
+        }
+        return;
+      }
+    }
+
+    ++m_stats.misses;
+    if (free != m_ways) {
+      m_dirty.push_back(base + free);
+      m_slots[base + free] = slot_type{key, 1, 1, true};
+      return;
+    }
+
+    // Replace the victim before flushing, since flush may re-enter insert
+    slot_type &victim = m_slots[base + clock_victim(base / m_ways)];
+    key_type   old_key   = victim.key;
+    int32_t    old_count = victim.count;
+    victim               = slot_type{key, 1, 1, true};
+    ++m_stats.evictions;
+    if (old_count > 0) {
+      ++m_stats.flushes;
+      flush(old_key, old_count);
+    }
+  }
+
+  /**
+   * @brief Drops any count cached for key.
+   */
+  void erase(const key_type &key) {
+    if (m_slots.empty()) return;
+    size_t base = set_index(key) * m_ways;
+    for (size_t way = 0; way < m_ways; ++way) {
+      slot_type &s = m_slots[base + way];
+      if (s.used && s.key == key) {
+        s.count = 0;
+        return;
+      }
+    }
+  }
+
+  /**
+   * @brief Hands every cached count to flush and empties the cache.
+   */
+  template <typename Flush>
+  void flush_all(Flush flush) {
+    std::vector<size_t> dirty;
+    dirty.swap(m_dirty);
+    for (size_t i : dirty) {
+      slot_type &s = m_slots[i];
+      if (!s.used) continue;
+      key_type key   = s.key;
+      int32_t  count = s.count;
+      s              = slot_type{};
+      if (count > 0) {
+        ++m_stats.flushes;
+        flush(key, count);
+      }
+    }
+  }
+
+  /**
+   * @brief Changes the geometry; the cache must have been flushed.
+   * Capacity 0 disables caching.
+   */
+  void reset(size_t capacity, size_t ways) {
+    m_ways     = std::max<size_t>(1, ways);
+    m_num_sets = 1;
+    while (m_num_sets * m_ways < capacity) {
+      m_num_sets *= 2;
+    }
+    m_capacity = capacity == 0 ? 0 : m_num_sets * m_ways;
+    std::vector<slot_type>().swap(m_slots);
+    std::vector<uint32_t>().swap(m_hands);
+    std::vector<size_t>().swap(m_dirty);
+  }
+
+  size_t capacity() const { return m_capacity; }
+
+  size_t ways() const { return m_ways; }
+
+  size_t occupied() const { return m_dirty.size(); }
+
+  const count_cache_stats &stats() const { return m_stats; }
+
+  void reset_stats() { m_stats = count_cache_stats{}; }
+
+ private:
+  // Saturating use counter; a slot survives up to max_use sweeps of the hand
+  static constexpr uint8_t max_use = 3;
+
+  struct slot_type {
+    key_type key   = key_type();
+    int32_t  count = 0;
+    uint8_t  use   = 0;
+    bool     used  = false;
+  };
+
+  size_t set_index(const key_type &key) const {
+    // Fibonacci mixing, since std::hash is the identity for integers
+    uint64_t h = uint64_t(std::hash<key_type>{}(key)) * 0x9E3779B97F4A7C15ull;
+    return (h >> 32) & (m_num_sets - 1);
+  }
+
+  size_t clock_victim(size_t set) {
+    size_t    base = set * m_ways;
+    uint32_t &hand = m_hands[set];
+    while (m_slots[base + hand].use > 0) {
+      --m_slots[base + hand].use;
+      hand = (hand + 1) % m_ways;
+    }
+    size_t victim = hand;
+    hand          = (hand + 1) % m_ways;
+    return victim;
+  }
+
+  size_t                 m_capacity = 0;
+  size_t                 m_ways     = 1;
+  size_t                 m_num_sets = 1;
+  std::vector<slot_type> m_slots;
+  std::vector<uint32_t>  m_hands;
+  std::vector<size_t>    m_dirty;
+  count_cache_stats      m_stats;
+};
+
+}  // namespace ygm::container::detail
@@ -0,0 +1,88 @@
+// Copyright 2019-2021 Lawrence Livermore National Security, LLC and other YGM
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+namespace ygm::container::detail {
+
+/**
+ * @brief Local compressed sparse row adjacency: sorted source vertices, an
+ * offset per source and one flat array of targets.
+ */
+template <typename Vertex>
+class csr {
+ public:
+  using edge_type = std::pair<Vertex, Vertex>;
+
+  /**
+   * @brief Replaces the contents with edges, which are consumed.
+   */
+  void build(std::vector<edge_type> &edges) {
+    std::sort(edges.begin(), edges.end());
+    clear();
+    m_targets.reserve(edges.size());
+    for (const auto &[u, v] : edges) {
+      if (m_vertices.empty() || m_vertices.back() != u) {
+        m_vertices.push_back(u);
+        m_offsets.push_back(m_targets.size());
+      }
+      m_targets.push_back(v);
+    }
+    m_offsets.push_back(m_targets.size());
+    m_vertices.shrink_to_fit();
+    m_offsets.shrink_to_fit();
+    std::vector<edge_type>().swap(edges);
+  }
+
+  void append_edges(std::vector<edge_type> &out) const {
+    out.reserve(out.size() + m_targets.size());
+    for_all_edges([&out](const Vertex &u, const Vertex &v) {
+      out.emplace_back(u, v);
+    });
+  }
+
+  /**
+   * @brief Range of u's targets; empty if u has no edges here.
+   */
+  std::pair<const Vertex *, const Vertex *> neighbors(const Vertex &u) const {
+    auto itr = std::lower_bound(m_vertices.begin(), m_vertices.end(), u);
+    if (itr == m_vertices.end() || *itr != u) {
+      return {nullptr, nullptr};
+    }
+    size_t i = itr - m_vertices.begin();
+    return {m_targets.data() + m_offsets[i],
+            m_targets.data() + m_offsets[i + 1]};
+  }
+
+  template <typename Function>
+  void for_all_edges(Function fn) const {
+    for (size_t i = 0; i < m_vertices.size(); ++i) {
+      for (size_t j = m_offsets[i]; j < m_offsets[i + 1]; ++j) {
+        fn(m_vertices[i], m_targets[j]);
+      }
+    }
+  }
+
+  size_t num_vertices() const { return m_vertices.size(); }
+
+  size_t num_edges() const { return m_targets.size(); }
+
+  void clear() {
+    m_vertices.clear();
+    m_offsets.clear();
+    m_targets.clear();
+  }
+
+ private:
+  std::vector<Vertex> m_vertices;
+  std::vector<size_t> m_offsets;
+  std::vector<Vertex> m_targets;
+};
+
+}  // namespace ygm::container::detail
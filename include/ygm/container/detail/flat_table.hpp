@@ -0,0 +1,448 @@
+// Copyright 2019-2021 Lawrence Livermore National Security, LLC and other YGM
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <new>
+#include <numeric>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <ygm/container/detail/hash_table.hpp>
+
+namespace ygm::container::detail {
+
+/**
+ * @brief Sorted flat array for write-once/read-many use.  Inserts are appended
+ * to a pending tail without any lookup; the first read afterwards sorts the
+ * tail, merges it into the sorted prefix and compacts the array to its exact
+ * size.  Lookups go through an Eytzinger-ordered sample of every
+ * block_size-th key, which stays cache resident, followed by a binary search
+ * within one block.
+ *
+ * Interleaving inserts with lookups rebuilds the array on every lookup, so
+ * this layout suits bulk loads followed by queries.  Reads may rebuild and are
+ * therefore not safe to run concurrently on the same table.
+ *
+ * @tparam Key Key type
+ * @tparam Value Stored element, e.g. std::pair<const Key, T> or const Key
+ * @tparam KeyOfValue Extracts the key from an element
+ */
+template <typename Key, typename Value, typename KeyOfValue, typename Compare,
+          typename Alloc>
+class flat_table {
+  using slot_type   = std::aligned_storage_t<sizeof(Value), alignof(Value)>;
+  using slot_alloc  =
+      typename std::allocator_traits<Alloc>::template rebind_alloc<slot_type>;
+  using slot_traits = std::allocator_traits<slot_alloc>;
+  template <typename T>
+  using rebound_vector = std::vector<
+      T, typename std::allocator_traits<Alloc>::template rebind_alloc<T>>;
+
+  static constexpr size_t block_size = 16;
+
+  // How a pending element combines with existing elements of its key
+  enum pending_op : uint8_t {
+    op_multi,      // kept alongside existing elements
+    op_assign,     // replaces existing elements
+    op_if_absent,  // dropped if the key already has elements
+  };
+
+ public:
+  using key_type       = Key;
+  using value_type     = Value;
+  using size_type      = size_t;
+  using iterator       = Value *;
+  using const_iterator = const Value *;
+  using allocator_type = slot_alloc;
+
+  flat_table() = default;
+
+  explicit flat_table(const allocator_type &alloc) : m_alloc(alloc) {}
+
+  flat_table(const flat_table &o)
+      : m_alloc(slot_traits::select_on_container_copy_construction(o.m_alloc)) {
+    insert(o.begin(), o.end());
+  }
+
+  flat_table(flat_table &&o) noexcept { swap(o); }
+
+  flat_table &operator=(flat_table o) {
+    swap(o);
+    return *this;
+  }
+
+  ~flat_table() { release(); }
+
+  void swap(flat_table &o) noexcept {
+    std::swap(m_alloc, o.m_alloc);
+    std::swap(m_slots, o.m_slots);
+    std::swap(m_size, o.m_size);
+    std::swap(m_capacity, o.m_capacity);
+    std::swap(m_sorted, o.m_sorted);
+    std::swap(m_pending_ops, o.m_pending_ops);
+    std::swap(m_index_keys, o.m_index_keys);
+    std::swap(m_index_ranks, o.m_index_ranks);
+    std::swap(m_index_valid, o.m_index_valid);
+  }
+
+  size_t size() const {
+    build();
+    return m_size;
+  }
+  bool empty() const { return size() == 0; }
+
+  allocator_type get_allocator() const { return m_alloc; }
+
+  iterator begin() {
+    build();
+    return data();
+  }
+  iterator end() {
+    build();
+    return data() + m_size;
+  }
+  const_iterator begin() const {
+    build();
+    return data();
+  }
+  const_iterator end() const {
+    build();
+    return data() + m_size;
+  }
+
+  void clear() { release(); }
+
+  void reserve(size_t n) {
+    if (n > m_capacity) {
+      reallocate(n);
+    }
+  }
+
+  /**
+   * @brief Appends an element, allowing duplicate keys.  No lookup is done
+   * until the next read.
+   *
+   * @return Iterator to the appended element, valid until the next insert or
+   * read
+   */
+  iterator insert(const value_type &v) { return append(op_multi, v); }
+
+  template <typename InputIt>
+  void insert(InputIt first, InputIt last) {
+    for (; first != last; ++first) {
+      append(op_multi, *first);
+    }
+  }
+
+  /**
+   * @brief Appends an element that replaces every element of its key once the
+   * table is rebuilt.
+   */
+  template <typename... Args>
+  void assign(const key_type &key, Args &&... args) {
+    append(op_assign, key, std::forward<Args>(args)...);
+  }
+
+  /**
+   * @brief Appends an element that is dropped on rebuild if its key already
+   * has elements.
+   */
+  template <typename... Args>
+  void insert_if_absent(const key_type &key, Args &&... args) {
+    append(op_if_absent, key, std::forward<Args>(args)...);
+  }
+
+  /**
+   * @brief Looks key up, rebuilding first, and appends (key, args...) if it is
+   * absent.
+   *
+   * @return Iterator to the element with key and whether it was inserted
+   */
+  template <typename... Args>
+  std::pair<iterator, bool> try_emplace(const key_type &key, Args &&... args) {
+    auto range = equal_range(key);
+    if (range.first != range.second) {
+      return {range.first, false};
+    }
+    return {append(op_if_absent, key, std::forward<Args>(args)...), true};
+  }
+
+  iterator find(const key_type &key) {
+    auto range = equal_range(key);
+    return range.first == range.second ? end() : range.first;
+  }
+
+  const_iterator find(const key_type &key) const {
+    auto range = equal_range(key);
+    return range.first == range.second ? end() : range.first;
+  }
+
+  std::pair<iterator, iterator> equal_range(const key_type &key) {
+    auto range = std::as_const(*this).equal_range(key);
+    return {const_cast<iterator>(range.first),
+            const_cast<iterator>(range.second)};
+  }
+
+  std::pair<const_iterator, const_iterator> equal_range(
+      const key_type &key) const {
+    build();
+    const_iterator first = data() + lower_bound_index(key);
+    const_iterator last  = first;
+    const_iterator stop  = data() + m_size;
+    while (last != stop && !Compare()(key, KeyOfValue()(*last))) {
+      ++last;
+    }
+    return {first, last};
+  }
+
+  size_t count(const key_type &key) const {
+    auto range = equal_range(key);
+    return range.second - range.first;
+  }
+
+  /**
+   * @brief First element whose key is not less than key.
+   */
+  iterator lower_bound(const key_type &key) {
+    build();
+    return data() + lower_bound_index(key);
+  }
+
+  const_iterator lower_bound(const key_type &key) const {
+    build();
+    return data() + lower_bound_index(key);
+  }
+
+  /**
+   * @brief Erases every element with key.
+   *
+   * @return Number of elements erased
+   */
+  size_t erase(const key_type &key) {
+    auto   range     = equal_range(key);
+    size_t first     = range.first - data();
+    size_t to_return = range.second - range.first;
+    if (to_return == 0) return 0;
+    for (size_t i = first; i < first + to_return; ++i) {
+      element(i).~Value();
+    }
+    for (size_t i = first + to_return; i < m_size; ++i) {
+      construct(i - to_return, std::move(element(i)));
+      element(i).~Value();
+    }
+    m_size -= to_return;
+    m_sorted      = m_size;
+    m_index_valid = false;
+    return to_return;
+  }
+
+ private:
+  Value *data() const {
+    if (m_slots == nullptr) return nullptr;
+    return std::launder(reinterpret_cast<Value *>(m_slots));
+  }
+
+  Value &element(size_t i) const { return data()[i]; }
+
+  template <typename... Args>
+  void construct(size_t i, Args &&... args) const {
+    ::new (static_cast<void *>(&m_slots[i])) Value(std::forward<Args>(args)...);
+  }
+
+  template <typename... Args>
+  iterator append(pending_op op, Args &&... args) {
+    if (m_size == m_capacity) {
+      reallocate(m_capacity == 0 ? block_size : m_capacity * 2);
+    }
+    construct(m_size, std::forward<Args>(args)...);
+    m_pending_ops.push_back(op);
+    return data() + m_size++;
+  }
+
+  /**
+   * @brief Moves the elements into a new allocation of exactly capacity
+   * slots.
+   */
+  void reallocate(size_t capacity) const {
+    slot_type *slots = slot_traits::allocate(m_alloc, capacity);
+    for (size_t i = 0; i < m_size; ++i) {
+      ::new (static_cast<void *>(&slots[i])) Value(std::move(element(i)));
+      element(i).~Value();
+    }
+    if (m_slots != nullptr) {
+      slot_traits::deallocate(m_alloc, m_slots, m_capacity);
+    }
+    m_slots    = slots;
+    m_capacity = capacity;
+  }
+
+  /**
+   * @brief Merges the pending tail into the sorted prefix, resolving pending
+   * operations in insertion order, and compacts the array.
+   */
+  void build() const {
+    if (m_sorted == m_size) {
+      if (!m_index_valid) build_index();
+      return;
+    }
+
+    auto less = [this](size_t a, size_t b) {
+      return Compare()(KeyOfValue()(element(a)), KeyOfValue()(element(b)));
+    };
+    rebound_vector<size_t> order(m_size - m_sorted);
+    std::iota(order.begin(), order.end(), m_sorted);
+    std::stable_sort(order.begin(), order.end(), less);
+
+    // Indices of surviving elements in merged order
+    rebound_vector<size_t> merged;
+    merged.reserve(m_size);
+    size_t a = 0, b = 0;
+    while (a < m_sorted || b < order.size()) {
+      size_t group_index = (b == order.size() ||
+                            (a < m_sorted && !less(order[b], a)))
+                               ? a
+                               : order[b];
+      const key_type &key   = KeyOfValue()(element(group_index));
+      size_t          start = merged.size();
+      while (a < m_sorted && !Compare()(key, KeyOfValue()(element(a)))) {
+        merged.push_back(a++);
+      }
+      while (b < order.size() &&
+             !Compare()(key, KeyOfValue()(element(order[b])))) {
+        size_t i = order[b++];
+        switch (m_pending_ops[i - m_sorted]) {
+          case op_multi:
+            merged.push_back(i);
+            break;
+          case op_assign:
+            merged.resize(start);
+            merged.push_back(i);
+            break;
+          case op_if_absent:
+            if (merged.size() == start) merged.push_back(i);
+            break;
+        }
+      }
+    }
+
+    slot_type *slots = merged.empty()
+                           ? nullptr
+                           : slot_traits::allocate(m_alloc, merged.size());
+    for (size_t i = 0; i < merged.size(); ++i) {
+      ::new (static_cast<void *>(&slots[i]))
+          Value(std::move(element(merged[i])));
+    }
+    destroy_all();
+    if (m_slots != nullptr) {
+      slot_traits::deallocate(m_alloc, m_slots, m_capacity);
+    }
+    m_slots    = slots;
+    m_size     = merged.size();
+    m_capacity = merged.size();
+    m_sorted   = m_size;
+    m_pending_ops.clear();
+    m_pending_ops.shrink_to_fit();
+    build_index();
+  }
+
+  /**
+   * @brief Lays out the first key of each block in Eytzinger (BFS) order.
+   */
+  void build_index() const {
+    size_t num_blocks = (m_size + block_size - 1) / block_size;
+    m_index_keys.clear();
+    m_index_ranks.clear();
+    m_index_keys.reserve(num_blocks + 1);
+    m_index_ranks.resize(num_blocks + 1);
+    // Slot 0 is unused so children of k are 2k and 2k+1
+    m_index_keys.resize(num_blocks + 1, key_type());
+    size_t next_block = 0;
+    fill_index(1, num_blocks, next_block);
+    m_index_valid = true;
+  }
+
+  void fill_index(size_t k, size_t num_blocks, size_t &next_block) const {
+    if (k > num_blocks) return;
+    fill_index(2 * k, num_blocks, next_block);
+    m_index_keys[k]  = KeyOfValue()(element(next_block * block_size));
+    m_index_ranks[k] = next_block++;
+    fill_index(2 * k + 1, num_blocks, next_block);
+  }
+
+  /**
+   * @brief Position of the first element not less than key.
+   */
+  size_t lower_bound_index(const key_type &key) const {
+    if (m_index_keys.size() <= 1) return 0;
+    size_t num_blocks = m_index_keys.size() - 1;
+    // First block whose leading key is not less than key
+    size_t k = 1;
+    while (k <= num_blocks) {
+      k = 2 * k + Compare()(m_index_keys[k], key);
+    }
+    k >>= __builtin_ffsll(~k);
+    size_t block = k == 0 ? num_blocks : m_index_ranks[k];
+    if (block == 0) return 0;
+    // The answer lies after the leading element of the previous block
+    Value *first = data() + (block - 1) * block_size + 1;
+    Value *last  = data() + std::min(m_size, block * block_size);
+    return std::lower_bound(first, last, key,
+                            [](const Value &v, const key_type &k) {
+                              return Compare()(KeyOfValue()(v), k);
+                            }) -
+           data();
+  }
+
+  void destroy_all() const {
+    if (!std::is_trivially_destructible<Value>::value) {
+      for (size_t i = 0; i < m_size; ++i) {
+        element(i).~Value();
+      }
+    }
+  }
+
+  void release() {
+    destroy_all();
+    if (m_slots != nullptr) {
+      slot_traits::deallocate(m_alloc, m_slots, m_capacity);
+    }
+    m_slots    = nullptr;
+    m_size     = 0;
+    m_capacity = 0;
+    m_sorted   = 0;
+    m_pending_ops.clear();
+    m_index_keys.clear();
+    m_index_ranks.clear();
+    m_index_valid = false;
+  }
+
+  // Rebuilding is logically const, so reads on a const table may reorganize
+  // the storage
+  mutable slot_alloc               m_alloc;
+  mutable slot_type               *m_slots    = nullptr;
+  mutable size_t                   m_size     = 0;
+  mutable size_t                   m_capacity = 0;
+  mutable size_t                   m_sorted   = 0;
+  mutable rebound_vector<uint8_t>  m_pending_ops;
+  mutable rebound_vector<key_type> m_index_keys;
+  mutable rebound_vector<size_t>   m_index_ranks;
+  mutable bool                     m_index_valid = false;
+};
+
+template <typename Key, typename Value, typename Compare = std::less<Key>,
+          typename Alloc = std::allocator<std::pair<const Key, Value>>>
+using flat_multimap =
+    flat_table<Key, std::pair<const Key, Value>, select_first, Compare, Alloc>;
+
+template <typename Key, typename Compare = std::less<Key>,
+          typename Alloc = std::allocator<Key>>
+using flat_multiset = flat_table<Key, const Key, select_self, Compare, Alloc>;
+
+}  // namespace ygm::container::detail
@@ -0,0 +1,20 @@
+// Copyright 2019-2021 Lawrence Livermore National Security, LLC and other YGM
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+namespace ygm::container {
+
+/**
+ * @brief Tag selecting container constructors that collectively insert a
+ * local range from every rank.
+ */
+struct from_local_t {
+  explicit from_local_t() = default;
+};
+
+inline constexpr from_local_t from_local{};
+
+}  // namespace ygm::container
@@ -0,0 +1,48 @@
+// Copyright 2019-2021 Lawrence Livermore National Security, LLC and other YGM
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <vector>
+#include <ygm/comm.hpp>
+
+namespace ygm::container::detail {
+
+/**
+ * @brief Result of a non-collective gather:  one future per owner batch,
+ * merged into Output once every reply has arrived.
+ */
+template <typename Output, typename Batch>
+class gather_future {
+ public:
+  gather_future(std::vector<ygm::future<Batch>> futures)
+      : m_futures(std::move(futures)) {}
+
+  bool ready() const {
+    for (const auto &f : m_futures) {
+      if (!f.ready()) return false;
+    }
+    return true;
+  }
+
+  /**
+   * @brief Waits for every reply, making progress on the comm, and returns the
+   * gathered key-value pairs.
+   */
+  Output get() {
+    Output to_return;
+    for (auto &f : m_futures) {
+      for (const auto &kv : f.get()) {
+        to_return.insert(kv);
+      }
+    }
+    return to_return;
+  }
+
+ private:
+  std::vector<ygm::future<Batch>> m_futures;
+};
+
+}  // namespace ygm::container::detail
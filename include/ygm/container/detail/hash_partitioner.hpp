@@ -4,19 +4,42 @@
 // SPDX-License-Identifier: MIT
 
 #pragma once
+#include <cstdint>
 #include <functional>
+#include <ygm/container/detail/key_hash.hpp>
 
 namespace ygm::container::detail {
 
-template <typename Key>
+/**
+ * @brief Places keys by a 64-bit mixing hash.  The rank comes from the high
+ * 32 bits and the bank from the low 32 bits, each scaled by multiply-shift
+ * rather than modulo, so the two are independent and the bank can be
+ * recomputed from the low 32 bits alone when they are carried in a message.
+ */
+template <typename Key, typename Hash = key_hash<Key>>
 struct hash_partitioner {
   std::pair<size_t, size_t> operator()(const Key& k, size_t nranks,
                                        size_t nbanks) const {
-    size_t hash = std::hash<Key>{}(k);
-    size_t rank = hash % nranks;
-    size_t bank = (hash / nranks) % nbanks;
-    return std::make_pair(rank, bank);
+    return place(hash(k), nranks, nbanks);
+  }
+
+  uint64_t hash(const Key& k) const { return Hash{}(k); }
+
+  static std::pair<size_t, size_t> place(uint64_t hash, size_t nranks,
+                                         size_t nbanks) {
+    size_t rank = ((hash >> 32) * nranks) >> 32;
+    return std::make_pair(rank, bank(local_hash(hash), nbanks));
+  }
+
+  /**
+   * @brief Part of the hash carried in messages; with the default Hash this
+   * is local_key_hash<Key>.
+   */
+  static uint32_t local_hash(uint64_t hash) { return uint32_t(hash); }
+
+  static size_t bank(uint32_t local_hash, size_t nbanks) {
+    return (uint64_t(local_hash) * nbanks) >> 32;
   }
 };
 
-}  // namespace ygm::container::detail
\ No newline at end of file
+}  // namespace ygm::container::detail
@@ -0,0 +1,500 @@
+// Copyright 2019-2021 Lawrence Livermore National Security, LLC and other YGM
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace ygm::container::detail {
+
+/**
+ * @brief Finalizer from splitmix64.  std::hash is the identity for integers on
+ * common platforms, and every key held by a rank shares its hash modulo the
+ * number of ranks, so the low bits must be remixed before masking.
+ */
+inline uint64_t mix_hash(uint64_t h) {
+  h ^= h >> 30;
+  h *= 0xbf58476d1ce4e5b9ULL;
+  h ^= h >> 27;
+  h *= 0x94d049bb133111ebULL;
+  h ^= h >> 31;
+  return h;
+}
+
+struct select_first {
+  template <typename Pair>
+  const auto &operator()(const Pair &p) const {
+    return p.first;
+  }
+};
+
+struct select_self {
+  template <typename T>
+  const T &operator()(const T &t) const {
+    return t;
+  }
+};
+
+/**
+ * @brief Open addressing hash table with linear probing.  Elements live in a
+ * single flat array next to a byte array of control codes holding 7 bits of
+ * each element's hash, so most probes that miss never touch the elements.
+ * Duplicate keys are allowed; erase uses backward shifting so the table never
+ * accumulates tombstones.
+ *
+ * @tparam Key Key type
+ * @tparam Value Stored element, e.g. std::pair<const Key, T> or const Key
+ * @tparam KeyOfValue Extracts the key from an element
+ */
+template <typename Key, typename Value, typename KeyOfValue, typename Hash,
+          typename KeyEqual, typename Alloc>
+class open_hash_table {
+  using slot_type  = std::aligned_storage_t<sizeof(Value), alignof(Value)>;
+  using slot_alloc =
+      typename std::allocator_traits<Alloc>::template rebind_alloc<slot_type>;
+  using slot_traits = std::allocator_traits<slot_alloc>;
+  using ctrl_alloc =
+      typename std::allocator_traits<Alloc>::template rebind_alloc<int8_t>;
+  using ctrl_traits = std::allocator_traits<ctrl_alloc>;
+
+  static constexpr int8_t empty_ctrl = -128;
+
+ public:
+  using key_type       = Key;
+  using value_type     = Value;
+  using size_type      = size_t;
+  using allocator_type = slot_alloc;
+
+  template <bool Const>
+  class iterator_base {
+   public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type        = Value;
+    using difference_type   = std::ptrdiff_t;
+    using reference = std::conditional_t<Const, const Value &, Value &>;
+    using pointer   = std::conditional_t<Const, const Value *, Value *>;
+    using table_pointer =
+        std::conditional_t<Const, const open_hash_table *, open_hash_table *>;
+
+    iterator_base() = default;
+    iterator_base(table_pointer t, size_t i) : m_table(t), m_index(i) {
+      skip_empty();
+    }
+    template <bool C = Const, typename = std::enable_if_t<C>>
+    iterator_base(const iterator_base<false> &o)
+        : m_table(o.m_table), m_index(o.m_index) {}
+
+    reference operator*() const { return m_table->element(m_index); }
+    pointer   operator->() const { return &m_table->element(m_index); }
+
+    iterator_base &operator++() {
+      ++m_index;
+      skip_empty();
+      return *this;
+    }
+    iterator_base operator++(int) {
+      iterator_base tmp = *this;
+      ++*this;
+      return tmp;
+    }
+
+    bool operator==(const iterator_base &o) const {
+      return m_index == o.m_index;
+    }
+    bool operator!=(const iterator_base &o) const { return !(*this == o); }
+
+   private:
+    friend class open_hash_table;
+    friend class iterator_base<true>;
+
+    void skip_empty() {
+      while (m_index < m_table->m_capacity &&
+             m_table->m_ctrl[m_index] == empty_ctrl) {
+        ++m_index;
+      }
+    }
+
+    table_pointer m_table = nullptr;
+    size_t        m_index = 0;
+  };
+
+  using iterator       = iterator_base<false>;
+  using const_iterator = iterator_base<true>;
+
+  /**
+   * @brief Walks the elements matching a single key along its probe sequence.
+   * Holds a pointer to the key passed to equal_range, which must outlive it.
+   */
+  template <bool Const>
+  class key_iterator_base {
+   public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type        = Value;
+    using difference_type   = std::ptrdiff_t;
+    using reference = std::conditional_t<Const, const Value &, Value &>;
+    using pointer   = std::conditional_t<Const, const Value *, Value *>;
+    using table_pointer =
+        std::conditional_t<Const, const open_hash_table *, open_hash_table *>;
+
+    key_iterator_base() = default;
+
+    reference operator*() const { return m_table->element(m_index); }
+    pointer   operator->() const { return &m_table->element(m_index); }
+
+    key_iterator_base &operator++() {
+      m_index = m_table->next_match(*m_key, m_fingerprint,
+                                    (m_index + 1) & m_table->m_mask);
+      return *this;
+    }
+
+    bool operator==(const key_iterator_base &o) const {
+      return m_index == o.m_index;
+    }
+    bool operator!=(const key_iterator_base &o) const { return !(*this == o); }
+
+   private:
+    friend class open_hash_table;
+
+    key_iterator_base(table_pointer t, const key_type *key, int8_t fp,
+                      size_t i)
+        : m_table(t), m_key(key), m_fingerprint(fp), m_index(i) {}
+
+    table_pointer   m_table       = nullptr;
+    const key_type *m_key         = nullptr;
+    int8_t          m_fingerprint = 0;
+    size_t          m_index       = npos;
+  };
+
+  using key_iterator       = key_iterator_base<false>;
+  using const_key_iterator = key_iterator_base<true>;
+
+  open_hash_table() = default;
+
+  explicit open_hash_table(const allocator_type &alloc) : m_alloc(alloc) {}
+
+  open_hash_table(const open_hash_table &o)
+      : m_alloc(slot_traits::select_on_container_copy_construction(o.m_alloc)) {
+    insert(o.begin(), o.end());
+  }
+
+  open_hash_table(open_hash_table &&o) noexcept { swap(o); }
+
+  open_hash_table &operator=(open_hash_table o) {
+    swap(o);
+    return *this;
+  }
+
+  ~open_hash_table() { release(); }
+
+  void swap(open_hash_table &o) noexcept {
+    std::swap(m_alloc, o.m_alloc);
+    std::swap(m_slots, o.m_slots);
+    std::swap(m_ctrl, o.m_ctrl);
+    std::swap(m_capacity, o.m_capacity);
+    std::swap(m_mask, o.m_mask);
+    std::swap(m_size, o.m_size);
+  }
+
+  size_t size() const { return m_size; }
+  bool   empty() const { return m_size == 0; }
+  size_t capacity() const { return m_capacity; }
+
+  allocator_type get_allocator() const { return m_alloc; }
+
+  iterator       begin() { return iterator(this, 0); }
+  iterator       end() { return iterator(this, m_capacity); }
+  const_iterator begin() const { return const_iterator(this, 0); }
+  const_iterator end() const { return const_iterator(this, m_capacity); }
+
+  void clear() {
+    destroy_all();
+    for (size_t i = 0; i < m_capacity; ++i) {
+      m_ctrl[i] = empty_ctrl;
+    }
+    m_size = 0;
+  }
+
+  /**
+   * @brief Grows the table so that n elements fit without rehashing.
+   */
+  void reserve(size_t n) {
+    size_t needed = 16;
+    while (needed * 3 < n * 4) {
+      needed *= 2;
+    }
+    if (needed > m_capacity) {
+      rehash(needed);
+    }
+  }
+
+  /**
+   * @brief Inserts an element, allowing duplicate keys.
+   */
+  iterator insert(const value_type &v) {
+    return insert_hashed(Hash()(KeyOfValue()(v)), v);
+  }
+
+  /**
+   * @brief insert with hash, equal to Hash()(key), computed elsewhere, e.g.
+   * carried in a message from the sender that partitioned the key.
+   */
+  iterator insert_hashed(size_t hash, const value_type &v) {
+    grow_if_needed();
+    size_t h = mix_hash(hash);
+    size_t i = h & m_mask;
+    while (m_ctrl[i] != empty_ctrl) {
+      i = (i + 1) & m_mask;
+    }
+    ::new (static_cast<void *>(&m_slots[i])) Value(v);
+    m_ctrl[i] = fingerprint(h);
+    ++m_size;
+    return iterator(this, i);
+  }
+
+  template <typename InputIt>
+  void insert(InputIt first, InputIt last) {
+    for (; first != last; ++first) {
+      insert(*first);
+    }
+  }
+
+  /**
+   * @brief Inserts an element constructed from (key, args...) unless key is
+   * present, with a single probe.
+   *
+   * @return Iterator to the element with key and whether it was inserted
+   */
+  template <typename... Args>
+  std::pair<iterator, bool> try_emplace(const key_type &key, Args &&... args) {
+    return try_emplace_hashed(Hash()(key), key, std::forward<Args>(args)...);
+  }
+
+  template <typename... Args>
+  std::pair<iterator, bool> try_emplace_hashed(size_t hash, const key_type &key,
+                                               Args &&... args) {
+    grow_if_needed();
+    size_t h  = mix_hash(hash);
+    int8_t fp = fingerprint(h);
+    size_t i  = h & m_mask;
+    while (m_ctrl[i] != empty_ctrl) {
+      if (m_ctrl[i] == fp && KeyEqual()(KeyOfValue()(element(i)), key)) {
+        return {iterator(this, i), false};
+      }
+      i = (i + 1) & m_mask;
+    }
+    ::new (static_cast<void *>(&m_slots[i]))
+        Value(key, std::forward<Args>(args)...);
+    m_ctrl[i] = fp;
+    ++m_size;
+    return {iterator(this, i), true};
+  }
+
+  iterator find(const key_type &key) {
+    auto range = equal_range(key);
+    return range.first == range.second ? end()
+                                       : iterator(this, range.first.m_index);
+  }
+
+  const_iterator find(const key_type &key) const {
+    auto range = equal_range(key);
+    return range.first == range.second
+               ? end()
+               : const_iterator(this, range.first.m_index);
+  }
+
+  std::pair<key_iterator, key_iterator> equal_range(const key_type &key) {
+    return equal_range_impl<false>(this, key, Hash()(key));
+  }
+
+  std::pair<const_key_iterator, const_key_iterator> equal_range(
+      const key_type &key) const {
+    return equal_range_impl<true>(this, key, Hash()(key));
+  }
+
+  std::pair<key_iterator, key_iterator> equal_range_hashed(
+      const key_type &key, size_t hash) {
+    return equal_range_impl<false>(this, key, hash);
+  }
+
+  std::pair<const_key_iterator, const_key_iterator> equal_range_hashed(
+      const key_type &key, size_t hash) const {
+    return equal_range_impl<true>(this, key, hash);
+  }
+
+  size_t count(const key_type &key) const {
+    size_t to_return{0};
+    auto   range = equal_range(key);
+    for (auto itr = range.first; itr != range.second; ++itr) {
+      ++to_return;
+    }
+    return to_return;
+  }
+
+  /**
+   * @brief Erases every element with key.
+   *
+   * @return Number of elements erased
+   */
+  size_t erase(const key_type &key) {
+    if (m_size == 0) return 0;
+    size_t h        = hash_of(key);
+    int8_t fp       = fingerprint(h);
+    size_t to_return{0};
+    // Backward shifting may move later matches into earlier slots, so
+    // restart from the home slot after each erase
+    for (size_t i = next_match(key, fp, h & m_mask); i != npos;
+         i        = next_match(key, fp, h & m_mask)) {
+      erase_slot(i);
+      ++to_return;
+    }
+    return to_return;
+  }
+
+ private:
+  static constexpr size_t npos = size_t(-1);
+
+  size_t hash_of(const key_type &key) const { return mix_hash(Hash()(key)); }
+
+  static int8_t fingerprint(size_t h) { return int8_t(h >> 57); }
+
+  Value &element(size_t i) {
+    return *std::launder(reinterpret_cast<Value *>(&m_slots[i]));
+  }
+  const Value &element(size_t i) const {
+    return *std::launder(reinterpret_cast<const Value *>(&m_slots[i]));
+  }
+
+  template <bool Const, typename TablePtr>
+  static std::pair<key_iterator_base<Const>, key_iterator_base<Const>>
+  equal_range_impl(TablePtr table, const key_type &key, size_t hash) {
+    if (table->m_size == 0) {
+      return {key_iterator_base<Const>(), key_iterator_base<Const>()};
+    }
+    size_t h  = mix_hash(hash);
+    int8_t fp = fingerprint(h);
+    size_t i  = table->next_match(key, fp, h & table->m_mask);
+    return {key_iterator_base<Const>(table, &key, fp, i),
+            key_iterator_base<Const>(table, &key, fp, npos)};
+  }
+
+  /**
+   * @brief First slot at or after i, before the next empty slot, holding key.
+   */
+  size_t next_match(const key_type &key, int8_t fp, size_t i) const {
+    while (m_ctrl[i] != empty_ctrl) {
+      if (m_ctrl[i] == fp && KeyEqual()(KeyOfValue()(element(i)), key)) {
+        return i;
+      }
+      i = (i + 1) & m_mask;
+    }
+    return npos;
+  }
+
+  void erase_slot(size_t i) {
+    element(i).~Value();
+    m_ctrl[i] = empty_ctrl;
+    --m_size;
+    // Shift following elements back unless that would move them before their
+    // home slot
+    for (size_t j = (i + 1) & m_mask; m_ctrl[j] != empty_ctrl;
+         j        = (j + 1) & m_mask) {
+      size_t home = hash_of(KeyOfValue()(element(j))) & m_mask;
+      if (((j - home) & m_mask) >= ((j - i) & m_mask)) {
+        ::new (static_cast<void *>(&m_slots[i])) Value(std::move(element(j)));
+        element(j).~Value();
+        m_ctrl[i] = m_ctrl[j];
+        m_ctrl[j] = empty_ctrl;
+        i         = j;
+      }
+    }
+  }
+
+  void grow_if_needed() {
+    // Maximum load factor of 3/4
+    if ((m_size + 1) * 4 > m_capacity * 3) {
+      rehash(m_capacity == 0 ? 16 : m_capacity * 2);
+    }
+  }
+
+  void rehash(size_t new_capacity) {
+    open_hash_table old(m_alloc);
+    swap(old);
+    slot_alloc slots(m_alloc);
+    ctrl_alloc ctrl(m_alloc);
+    m_slots    = slot_traits::allocate(slots, new_capacity);
+    m_ctrl     = ctrl_traits::allocate(ctrl, new_capacity);
+    m_capacity = new_capacity;
+    m_mask     = new_capacity - 1;
+    for (size_t i = 0; i < new_capacity; ++i) {
+      m_ctrl[i] = empty_ctrl;
+    }
+    for (size_t j = 0; j < old.m_capacity; ++j) {
+      if (old.m_ctrl[j] == empty_ctrl) continue;
+      size_t i = hash_of(KeyOfValue()(old.element(j))) & m_mask;
+      while (m_ctrl[i] != empty_ctrl) {
+        i = (i + 1) & m_mask;
+      }
+      ::new (static_cast<void *>(&m_slots[i])) Value(std::move(old.element(j)));
+      m_ctrl[i] = old.m_ctrl[j];
+      ++m_size;
+    }
+  }
+
+  void destroy_all() {
+    if (!std::is_trivially_destructible<Value>::value) {
+      for (size_t i = 0; i < m_capacity; ++i) {
+        if (m_ctrl[i] != empty_ctrl) {
+          element(i).~Value();
+        }
+      }
+    }
+  }
+
+  void release() {
+    if (m_slots == nullptr) return;
+    destroy_all();
+    slot_alloc slots(m_alloc);
+    ctrl_alloc ctrl(m_alloc);
+    slot_traits::deallocate(slots, m_slots, m_capacity);
+    ctrl_traits::deallocate(ctrl, m_ctrl, m_capacity);
+    m_slots    = nullptr;
+    m_ctrl     = nullptr;
+    m_capacity = 0;
+    m_mask     = 0;
+    m_size     = 0;
+  }
+
+  // Pointers come from the allocator, so a table whose allocator hands out
+  // offset_ptrs can live in a memory-mapped file
+  slot_alloc                    m_alloc;
+  typename slot_traits::pointer m_slots    = nullptr;
+  typename ctrl_traits::pointer m_ctrl     = nullptr;
+  size_t                        m_capacity = 0;
+  size_t                        m_mask     = 0;
+  size_t                        m_size     = 0;
+};
+
+template <typename Key, typename Value, typename Hash = std::hash<Key>,
+          typename KeyEqual = std::equal_to<Key>,
+          typename Alloc = std::allocator<std::pair<const Key, Value>>>
+using hash_multimap =
+    open_hash_table<Key, std::pair<const Key, Value>, select_first, Hash,
+                    KeyEqual, Alloc>;
+
+template <typename Key, typename Hash = std::hash<Key>,
+          typename KeyEqual = std::equal_to<Key>,
+          typename Alloc = std::allocator<Key>>
+using hash_multiset =
+    open_hash_table<Key, const Key, select_self, Hash, KeyEqual, Alloc>;
+
+}  // namespace ygm::container::detail
@@ -0,0 +1,91 @@
+// Copyright 2019-2021 Lawrence Livermore National Security, LLC and other YGM
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <set>
+#include <utility>
+#include <vector>
+
+namespace ygm::container::detail {
+
+/**
+ * @brief Space-Saving heavy-hitter sketch over a stream of keys.  Tracks at
+ * most capacity keys; an untracked key replaces the one with the smallest
+ * count and inherits that count as its error.  Any key occurring more than
+ * total() / capacity times is guaranteed to be tracked.
+ */
+template <typename Key, typename Compare = std::less<Key>>
+class heavy_hitters {
+ public:
+  using key_type = Key;
+
+  explicit heavy_hitters(size_t capacity) : m_capacity(capacity) {}
+
+  void insert(const key_type &key) {
+    ++m_total;
+    auto itr = m_counters.find(key);
+    if (itr != m_counters.end()) {
+      m_by_count.erase({itr->second.count, key});
+      ++itr->second.count;
+      m_by_count.insert({itr->second.count, key});
+      return;
+    }
+    uint64_t error = 0;
+    if (m_counters.size() >= m_capacity) {
+      auto min = m_by_count.begin();
+      error    = min->first;
+      m_counters.erase(min->second);
+      m_by_count.erase(min);
+    }
+    m_counters.emplace(key, counter_type{error + 1, error});
+    m_by_count.insert({error + 1, key});
+  }
+
+  /**
+   * @brief Keys that certainly make up at least fraction of the stream.
+   */
+  std::vector<key_type> heavy(double fraction) const {
+    std::vector<key_type> to_return;
+    for (const auto &[key, counter] : m_counters) {
+      if (counter.count - counter.error >= fraction * m_total) {
+        to_return.push_back(key);
+      }
+    }
+    return to_return;
+  }
+
+  uint64_t total() const { return m_total; }
+
+  void clear() {
+    m_counters.clear();
+    m_by_count.clear();
+    m_total = 0;
+  }
+
+ private:
+  struct counter_type {
+    uint64_t count;
+    uint64_t error;
+  };
+
+  struct count_less {
+    bool operator()(const std::pair<uint64_t, key_type> &a,
+                    const std::pair<uint64_t, key_type> &b) const {
+      return a.first < b.first ||
+             (a.first == b.first && Compare()(a.second, b.second));
+    }
+  };
+
+  size_t                                              m_capacity;
+  uint64_t                                            m_total = 0;
+  std::map<key_type, counter_type, Compare>           m_counters;
+  std::set<std::pair<uint64_t, key_type>, count_less> m_by_count;
+};
+
+}  // namespace ygm::container::detail
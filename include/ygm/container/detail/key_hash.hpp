@@ -0,0 +1,174 @@
+// Copyright 2019-2021 Lawrence Livermore National Security, LLC and other YGM
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+namespace ygm::container::detail {
+
+// Constants and mixing steps of wyhash (public domain, Wang Yi)
+inline constexpr uint64_t wyp0 = 0xa0761d6478bd642fULL;
+inline constexpr uint64_t wyp1 = 0xe7037ed1a0b428dbULL;
+inline constexpr uint64_t wyp2 = 0x8ebc6af09c88c6e3ULL;
+inline constexpr uint64_t wyp3 = 0x589965cc75374cc3ULL;
+
+/**
+ * @brief Replaces a and b with the low and high halves of their 128-bit
+ * product.
+ */
+inline void wymum(uint64_t &a, uint64_t &b) {
+#ifdef __SIZEOF_INT128__
+  __uint128_t r = __uint128_t(a) * b;
+  a             = uint64_t(r);
+  b             = uint64_t(r >> 64);
+#else
+  uint64_t ha = a >> 32, hb = b >> 32, la = uint32_t(a), lb = uint32_t(b);
+  uint64_t rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+  uint64_t t  = rl + (rm0 << 32);
+  uint64_t c  = t < rl;
+  uint64_t lo = t + (rm1 << 32);
+  c += lo < t;
+  a = lo;
+  b = rh + (rm0 >> 32) + (rm1 >> 32) + c;
+#endif
+}
+
+inline uint64_t wymix(uint64_t a, uint64_t b) {
+  wymum(a, b);
+  return a ^ b;
+}
+
+/**
+ * @brief Hashes a single 64-bit word.  Every input bit affects every output
+ * bit, so sequential and strided integers spread over all ranks and banks.
+ */
+inline uint64_t hash_word(uint64_t x) {
+  uint64_t a = x ^ wyp0, b = x ^ wyp1;
+  wymum(a, b);
+  return wymix(a ^ wyp0, b ^ wyp1);
+}
+
+/**
+ * @brief wyhash of len bytes at data.
+ */
+inline uint64_t hash_bytes(const void *data, size_t len, uint64_t seed = 0) {
+  auto r8 = [](const uint8_t *p) {
+    uint64_t v;
+    std::memcpy(&v, p, 8);
+    return v;
+  };
+  auto r4 = [](const uint8_t *p) {
+    uint32_t v;
+    std::memcpy(&v, p, 4);
+    return uint64_t(v);
+  };
+  const uint8_t *p = static_cast<const uint8_t *>(data);
+  seed ^= wymix(seed ^ wyp0, wyp1);
+  uint64_t a, b;
+  if (len <= 16) {
+    if (len >= 4) {
+      a = (r4(p) << 32) | r4(p + ((len >> 3) << 2));
+      b = (r4(p + len - 4) << 32) | r4(p + len - 4 - ((len >> 3) << 2));
+    } else if (len > 0) {
+      a = (uint64_t(p[0]) << 16) | (uint64_t(p[len >> 1]) << 8) | p[len - 1];
+      b = 0;
+    } else {
+      a = b = 0;
+    }
+  } else {
+    size_t i = len;
+    if (i > 48) {
+      uint64_t see1 = seed, see2 = seed;
+      do {
+        seed = wymix(r8(p) ^ wyp1, r8(p + 8) ^ seed);
+        see1 = wymix(r8(p + 16) ^ wyp2, r8(p + 24) ^ see1);
+        see2 = wymix(r8(p + 32) ^ wyp3, r8(p + 40) ^ see2);
+        p += 48;
+        i -= 48;
+      } while (i > 48);
+      seed ^= see1 ^ see2;
+    }
+    while (i > 16) {
+      seed = wymix(r8(p) ^ wyp1, r8(p + 8) ^ seed);
+      i -= 16;
+      p += 16;
+    }
+    a = r8(p + i - 16);
+    b = r8(p + i - 8);
+  }
+  a ^= wyp1;
+  b ^= seed;
+  wymum(a, b);
+  return wymix(a ^ wyp0 ^ len, b ^ wyp1);
+}
+
+/**
+ * @brief Default 64-bit key hash of the containers.  Integers, enums and
+ * pointers are mixed with hash_word, strings are hashed with hash_bytes and
+ * pairs combine their members; any other key mixes its std::hash, which on
+ * common platforms is the identity for integers.
+ */
+template <typename Key, typename Enable = void>
+struct key_hash {
+  uint64_t operator()(const Key &key) const {
+    return hash_word(std::hash<Key>{}(key));
+  }
+};
+
+template <typename Key>
+struct key_hash<Key, std::enable_if_t<std::is_integral_v<Key> ||
+                                      std::is_enum_v<Key> ||
+                                      std::is_pointer_v<Key>>> {
+  uint64_t operator()(const Key &key) const {
+    if constexpr (std::is_pointer_v<Key>) {
+      return hash_word(reinterpret_cast<uintptr_t>(key));
+    } else {
+      return hash_word(uint64_t(key));
+    }
+  }
+};
+
+template <typename CharT, typename Traits, typename Alloc>
+struct key_hash<std::basic_string<CharT, Traits, Alloc>> {
+  uint64_t operator()(const std::basic_string<CharT, Traits, Alloc> &s) const {
+    return hash_bytes(s.data(), s.size() * sizeof(CharT));
+  }
+};
+
+template <typename CharT, typename Traits>
+struct key_hash<std::basic_string_view<CharT, Traits>> {
+  uint64_t operator()(std::basic_string_view<CharT, Traits> s) const {
+    return hash_bytes(s.data(), s.size() * sizeof(CharT));
+  }
+};
+
+template <typename First, typename Second>
+struct key_hash<std::pair<First, Second>> {
+  uint64_t operator()(const std::pair<First, Second> &p) const {
+    return wymix(key_hash<First>{}(p.first) ^ wyp0,
+                 key_hash<Second>{}(p.second) ^ wyp1);
+  }
+};
+
+/**
+ * @brief The low 32 bits of key_hash, the part of the hash the containers
+ * carry in messages.  Hash tables built with it can reuse a carried hash
+ * instead of hashing the key again on the owner.
+ */
+template <typename Key>
+struct local_key_hash {
+  size_t operator()(const Key &key) const {
+    return uint32_t(key_hash<Key>{}(key));
+  }
+};
+
+}  // namespace ygm::container::detail
@@ -6,10 +6,18 @@
 #pragma once
 #include <cereal/archives/json.hpp>
 #include <cereal/types/utility.hpp>
+#include <cereal/types/vector.hpp>
 #include <fstream>
 #include <map>
+#include <set>
 #include <ygm/comm.hpp>
+#include <ygm/container/detail/checkpoint.hpp>
 #include <ygm/container/detail/hash_partitioner.hpp>
+#include <ygm/container/detail/heavy_hitters.hpp>
+#include <ygm/container/detail/mmap_allocator.hpp>
+#include <ygm/container/detail/range_partitioner.hpp>
+#include <ygm/container/detail/selection.hpp>
+#include <ygm/container/detail/storage.hpp>
 #include <ygm/detail/ygm_ptr.hpp>
 
 namespace ygm::container::detail {
@@ -17,92 +25,528 @@ namespace ygm::container::detail {
 template <typename Key, typename Value,
           typename Partitioner = detail::hash_partitioner<Key>,
           typename Compare = std::less<Key>,
-          class Alloc = std::allocator<std::pair<const Key, Value>>>
+          class Alloc = std::allocator<std::pair<const Key, Value>>,
+          typename Storage = detail::tree_storage>
 class map_impl {
 public:
-  using self_type = map_impl<Key, Value, Partitioner, Compare, Alloc>;
+  using self_type = map_impl<Key, Value, Partitioner, Compare, Alloc, Storage>;
   using value_type = Value;
   using key_type = Key;
+  using local_map_type =
+      typename Storage::template map_type<key_type, value_type, Compare, Alloc>;
+  // Serialized files always hold an ordered multimap, whatever the storage
+  using file_map_type = std::multimap<key_type, value_type, Compare>;
+  using gather_batch_type = std::vector<std::pair<key_type, value_type>>;
 
   Partitioner partitioner;
 
+  // Most checkpoint records a rank holds before sending them to new owners
+  static constexpr size_t restore_batch_size = size_t(1) << 16;
+
+  // Whether messages carry the low 32 bits of the key's hash
+  static constexpr bool carry_hash = carries_hash<Storage>::value;
+  static_assert(!carry_hash ||
+                    std::is_same_v<Partitioner, hash_partitioner<Key>>,
+                "carried_hash_storage requires the default hash_partitioner");
+
+  // Whether local data lives in memory-mapped files, see mmap_file
+  static constexpr bool persistent = is_mmap_allocator<Alloc>::value;
+  static_assert(!persistent || std::is_base_of_v<hash_storage, Storage>,
+                "mmap_allocator requires hash_storage; the node and vector "
+                "based storages keep raw pointers");
+  static_assert(!persistent || (std::is_trivially_copyable_v<Key> &&
+                                std::is_trivially_copyable_v<Value>),
+                "Persistent maps need keys and values that own no memory");
+
   map_impl(ygm::comm &comm) : m_comm(comm), pthis(this), m_default_value{} {
+    m_local_maps =
+        shard_array<local_map_type>(std::max(1, m_comm.handler_threads()));
+    m_shard_queues.resize(m_local_maps.size());
     m_comm.barrier();
   }
 
   map_impl(ygm::comm &comm, const value_type &dv)
       : m_comm(comm), pthis(this), m_default_value(dv) {
+    m_local_maps =
+        shard_array<local_map_type>(std::max(1, m_comm.handler_threads()));
+    m_shard_queues.resize(m_local_maps.size());
+    m_comm.barrier();
+  }
+
+  map_impl(ygm::comm &comm, const Partitioner &p)
+      : partitioner(p), m_comm(comm), pthis(this), m_default_value{} {
+    m_local_maps =
+        shard_array<local_map_type>(std::max(1, m_comm.handler_threads()));
+    m_shard_queues.resize(m_local_maps.size());
+    m_comm.barrier();
+  }
+
+  /**
+   * @brief Constructs a map whose local data lives in the files named by
+   * file, reattaching to the data left there by an earlier job on the same
+   * number of ranks and handler threads, or starting empty.
+   */
+  map_impl(ygm::comm &comm, const mmap_file &file)
+      : m_comm(comm), pthis(this), m_default_value{} {
+    static_assert(persistent, "mmap_file requires an mmap_allocator");
+    size_t num_shards = std::max(1, m_comm.handler_threads());
+    m_mmap = std::make_unique<mmap_root<local_map_type>>(m_comm, file,
+                                                         num_shards);
+    m_local_maps = shard_array<local_map_type>(*m_mmap);
+    m_shard_queues.resize(num_shards);
     m_comm.barrier();
   }
 
   ~map_impl() { m_comm.barrier(); }
 
+  /**
+   * @brief Collectively flushes a persistent map's files, which unmapping
+   * them at destruction also does.
+   */
+  void persist() {
+    m_comm.barrier();
+    m_mmap->sync();
+  }
+
   void async_insert_unique(const key_type &key, const value_type &value) {
+    if constexpr (carry_hash) {
+      auto inserter = [](auto mailbox, int from, auto map, uint32_t hash,
+                         const key_type &key, const value_type &value) {
+        map->local_apply(
+            map->shard_index_hashed(hash),
+            [](local_map_type &local_map, uint32_t hash, const key_type &key,
+               const value_type &value) {
+              auto [itr, inserted] =
+                  local_map.try_emplace_hashed(hash, key, value);
+              if (!inserted) {
+                itr->second = value;
+              }
+            },
+            hash, key, value);
+      };
+      uint64_t hash = partitioner.hash(key);
+      auto [dest, bank] = partitioner.place(hash, m_comm.size(), 1024);
+      m_comm.async_sharded(dest, bank, inserter, pthis,
+                           Partitioner::local_hash(hash), key, value);
+      return;
+    }
     auto inserter = [](auto mailbox, int from, auto map, const key_type &key,
                        const value_type &value) {
-      auto itr = map->m_local_map.find(key);
-      if (itr != map->m_local_map.end()) {
-        itr->second = value;
-      } else {
-        map->m_local_map.insert(std::make_pair(key, value));
-      }
+      map->local_apply(
+          map->shard_index(key),
+          [](local_map_type &local_map, const key_type &key,
+             const value_type &value) {
+            detail::insert_or_assign(local_map, key, value);
+          },
+          key, value);
     };
-    int dest = owner(key);
-    m_comm.async(dest, inserter, pthis, key, value);
+    auto [dest, bank] = partitioner(key, m_comm.size(), 1024);
+    m_comm.async_sharded(dest, bank, inserter, pthis, key, value);
   }
 
   void async_insert_multi(const key_type &key, const value_type &value) {
+    if constexpr (carry_hash) {
+      auto inserter = [](auto mailbox, int from, auto map, uint32_t hash,
+                         const key_type &key, const value_type &value) {
+        map->local_apply(
+            map->shard_index_hashed(hash),
+            [](local_map_type &local_map, uint32_t hash, const key_type &key,
+               const value_type &value) {
+              local_map.insert_hashed(hash, std::make_pair(key, value));
+            },
+            hash, key, value);
+      };
+      uint64_t hash = partitioner.hash(key);
+      auto [dest, bank] = partitioner.place(hash, m_comm.size(), 1024);
+      m_comm.async_sharded(dest, bank, inserter, pthis,
+                           Partitioner::local_hash(hash), key, value);
+      return;
+    }
     auto inserter = [](auto mailbox, int from, auto map, const key_type &key,
                        const value_type &value) {
-      map->m_local_map.insert(std::make_pair(key, value));
+      map->local_apply(
+          map->shard_index(key),
+          [](local_map_type &local_map, const key_type &key,
+             const value_type &value) {
+            local_map.insert(std::make_pair(key, value));
+          },
+          key, value);
+    };
+    auto [dest, bank] = partitioner(key, m_comm.size(), 1024);
+    m_comm.async_sharded(dest, bank, inserter, pthis, key, value);
+  }
+
+  /**
+   * @brief Inserts a local range of key-value pairs.  Pairs are partitioned by
+   * owner in one pass and shipped in batches that the owner decodes in a
+   * single handler.  With combine, duplicate keys within a batch are reduced
+   * to their last value before sending, which matches inserting them one at a
+   * time when unique.
+   */
+  template <typename InputIt>
+  void async_insert_range(InputIt first, InputIt last, bool unique,
+                          bool combine) {
+    using batch_type = std::vector<std::pair<key_type, value_type>>;
+    size_t num_shards = m_local_maps.size();
+    // Aim for batches of about half a send buffer
+    size_t batch_size = std::max<size_t>(
+        1, m_comm.buffer_capacity() /
+               (2 * sizeof(typename batch_type::value_type)));
+
+    auto inserter = [](auto pcomm, int from, auto pmap, const batch_type &batch,
+                       bool unique) {
+      for (const auto &kv : batch) {
+        pmap->local_apply(
+            pmap->shard_index(kv.first),
+            [](local_map_type &local_map,
+               const std::pair<key_type, value_type> &kv, bool unique) {
+              if (unique) {
+                detail::insert_or_assign(local_map, kv.first, kv.second);
+              } else {
+                local_map.insert(kv);
+              }
+            },
+            kv, unique);
+      }
+    };
+
+    auto send_batch = [&](int dest, size_t shard, batch_type &batch) {
+      if (combine) {
+        auto less = [](const auto &a, const auto &b) {
+          return Compare()(a.first, b.first);
+        };
+        std::stable_sort(batch.begin(), batch.end(), less);
+        // Keep the last of each run of equal keys
+        size_t out = 0;
+        for (size_t i = 0; i < batch.size(); ++i) {
+          if (i + 1 < batch.size() && !less(batch[i], batch[i + 1])) continue;
+          if (out != i) batch[out] = std::move(batch[i]);
+          ++out;
+        }
+        batch.resize(out);
+      }
+      m_comm.async_sharded(dest, shard, inserter, pthis, batch, unique);
+      batch.clear();
     };
-    int dest = owner(key);
-    m_comm.async(dest, inserter, pthis, key, value);
+
+    std::vector<batch_type> batches(m_comm.size() * num_shards);
+    for (; first != last; ++first) {
+      auto [dest, bank] = partitioner(first->first, m_comm.size(), 1024);
+      size_t shard = bank % num_shards;
+      auto &batch = batches[dest * num_shards + shard];
+      batch.emplace_back(first->first, first->second);
+      if (batch.size() >= batch_size) {
+        send_batch(dest, shard, batch);
+      }
+    }
+    for (size_t i = 0; i < batches.size(); ++i) {
+      if (!batches[i].empty()) {
+        send_batch(i / num_shards, i % num_shards, batches[i]);
+      }
+    }
+  }
+
+  /**
+   * @brief Replaces key's value with op(value, update) on its owner, or
+   * inserts update if key is absent.  Updates are held in per-destination
+   * combining buffers where updates to the same key are merged with op, so
+   * op must be commutative, associative and stateless.  A buffer is merged
+   * when it reaches its share of reduce_buffer_capacity() entries and sent
+   * unless merging halved it; all are flushed by the next barrier.
+   * Switching to a different op type flushes the buffers first.
+   *
+   * A sample of the keys feeds a heavy-hitter sketch.  Keys making up more
+   * than hot_key_fraction() of this rank's updates are hot: their updates
+   * are combined in a local table that is only sent at the barrier, so a
+   * skewed key costs its owner one message per rank per phase.
+   */
+  template <typename ReductionOp>
+  void async_reduce(const key_type &key, const value_type &update,
+                    ReductionOp op) {
+    reduce_flusher_type flusher =
+        &self_type::template reduce_flush_all<ReductionOp>;
+    if (m_reduce_flusher != flusher) {
+      reduce_flush();
+      m_reduce_flusher = flusher;
+    }
+    if (!m_reduce_registered) {
+      m_reduce_registered = true;
+      m_comm.register_pre_barrier_callback([this]() {
+        m_reduce_registered = false;
+        reduce_flush();
+      });
+    }
+
+    if (m_hot_fraction > 0) {
+      // LCG draw, so periodic key patterns cannot alias with the sampling
+      m_hot_draw = m_hot_draw * 6364136223846793005ull + 1442695040888963407ull;
+      if ((m_hot_draw >> 32) % hot_sample_rate == 0) {
+        m_hot_sampler.insert(key);
+        if (m_hot_sampler.total() % hot_refresh_interval == 0) {
+          refresh_hot_keys<ReductionOp>();
+        }
+      }
+      if (!m_hot_keys.empty() && m_hot_keys.count(key) > 0) {
+        auto [itr, inserted] = m_hot_updates.try_emplace(key, update);
+        if (!inserted) {
+          itr->second = op(itr->second, update);
+        }
+        return;
+      }
+    }
+    reduce_buffer<ReductionOp>(key, update);
+  }
+
+  size_t reduce_buffer_capacity() const { return m_reduce_capacity; }
+
+  /**
+   * @brief Sets the total number of updates async_reduce may hold before
+   * sending.  Larger buffers catch more duplicate keys.
+   */
+  void set_reduce_buffer_capacity(size_t capacity) {
+    m_reduce_capacity = capacity;
+  }
+
+  double hot_key_fraction() const { return m_hot_fraction; }
+
+  /**
+   * @brief Sets the share of this rank's async_reduce updates above which a
+   * key is combined locally until the barrier; 0 disables detection.
+   */
+  void set_hot_key_fraction(double fraction) {
+    reduce_flush();
+    m_hot_fraction = fraction;
+    m_hot_keys.clear();
+    m_hot_sampler = heavy_hitters<key_type, Compare>(hot_sampler_capacity());
+  }
+
+  /**
+   * @brief Keys currently combined locally by async_reduce.
+   */
+  std::vector<key_type> hot_keys() const {
+    return std::vector<key_type>(m_hot_keys.begin(), m_hot_keys.end());
+  }
+
+  /**
+   * @brief Sends every buffered async_reduce update.
+   */
+  void reduce_flush() {
+    if (m_reduce_flusher != nullptr) {
+      (this->*m_reduce_flusher)();
+    }
   }
 
   template <typename Visitor, typename... VisitorArgs>
   void async_visit(const key_type &key, Visitor visitor,
                    const VisitorArgs &... args) {
-    int dest = owner(key);
+    if constexpr (carry_hash) {
+      auto visit_wrapper = [](auto pcomm, int from, auto pmap, uint32_t hash,
+                              const key_type &key,
+                              const VisitorArgs &... args) {
+        pmap->local_apply(
+            pmap->shard_index_hashed(hash),
+            [pmap, from](local_map_type &local_map, uint32_t hash,
+                         const key_type &key, const VisitorArgs &... args) {
+              auto range = local_map.equal_range_hashed(key, hash);
+              if (range.first == range.second) {
+                local_map.try_emplace_hashed(hash, key, pmap->m_default_value);
+                range = local_map.equal_range_hashed(key, hash);
+              }
+              Visitor *vis;
+              auto     guard = pmap->pin(local_map);
+              pmap->local_visit_range(range.first, range.second, *vis, from,
+                                      args...);
+            },
+            hash, key, args...);
+      };
+      uint64_t hash = partitioner.hash(key);
+      auto [dest, bank] = partitioner.place(hash, m_comm.size(), 1024);
+      m_comm.async_sharded(dest, bank, visit_wrapper, pthis,
+                           Partitioner::local_hash(hash), key,
+                           std::forward<const VisitorArgs>(args)...);
+      return;
+    }
+    auto [dest, bank] = partitioner(key, m_comm.size(), 1024);
     auto visit_wrapper = [](auto pcomm, int from, auto pmap,
                             const key_type &key, const VisitorArgs &... args) {
-      auto range = pmap->m_local_map.equal_range(key);
-      if (range.first == range.second) { // check if not in range
-        pmap->m_local_map.insert(std::make_pair(key, pmap->m_default_value));
-        range = pmap->m_local_map.equal_range(key);
-        ASSERT_DEBUG(range.first != range.second);
-      }
-      Visitor *vis;
-      pmap->local_visit(key, *vis, from, args...);
+      pmap->local_apply(
+          pmap->shard_index(key),
+          [pmap, from](local_map_type &local_map, const key_type &key,
+                       const VisitorArgs &... args) {
+            auto range = local_map.equal_range(key);
+            if (range.first == range.second) { // check if not in range
+              detail::insert_unique(local_map, key, pmap->m_default_value);
+              // Found again, since flat storage places it on the next read
+              // and must not rebuild while the visitor holds it
+              range = local_map.equal_range(key);
+            }
+            Visitor *vis;
+            auto     guard = pmap->pin(local_map);
+            pmap->local_visit_range(range.first, range.second, *vis, from,
+                                    args...);
+          },
+          key, args...);
     };
 
-    m_comm.async(dest, visit_wrapper, pthis, key,
-                 std::forward<const VisitorArgs>(args)...);
+    m_comm.async_sharded(dest, bank, visit_wrapper, pthis, key,
+                         std::forward<const VisitorArgs>(args)...);
   }
 
   template <typename Visitor, typename... VisitorArgs>
   void async_visit_if_exists(const key_type &key, Visitor visitor,
                              const VisitorArgs &... args) {
-    int dest = owner(key);
+    if constexpr (carry_hash) {
+      auto visit_wrapper = [](auto pcomm, int from, auto pmap, uint32_t hash,
+                              const key_type &key,
+                              const VisitorArgs &... args) {
+        pmap->local_apply(
+            pmap->shard_index_hashed(hash),
+            [pmap, from](local_map_type &local_map, uint32_t hash,
+                         const key_type &key, const VisitorArgs &... args) {
+              auto     range = local_map.equal_range_hashed(key, hash);
+              Visitor *vis;
+              auto     guard = pmap->pin(local_map);
+              pmap->local_visit_range(range.first, range.second, *vis, from,
+                                      args...);
+            },
+            hash, key, args...);
+      };
+      uint64_t hash = partitioner.hash(key);
+      auto [dest, bank] = partitioner.place(hash, m_comm.size(), 1024);
+      m_comm.async_sharded(dest, bank, visit_wrapper, pthis,
+                           Partitioner::local_hash(hash), key,
+                           std::forward<const VisitorArgs>(args)...);
+      return;
+    }
+    auto [dest, bank] = partitioner(key, m_comm.size(), 1024);
     auto visit_wrapper = [](auto pcomm, int from, auto pmap,
                             const key_type &key, const VisitorArgs &... args) {
-      Visitor *vis;
-      pmap->local_visit(key, *vis, from, args...);
+      pmap->local_apply(
+          pmap->shard_index(key),
+          [pmap, from](local_map_type &local_map, const key_type &key,
+                       const VisitorArgs &... args) {
+            Visitor *vis;
+            pmap->local_visit(key, *vis, from, args...);
+          },
+          key, args...);
+    };
+
+    m_comm.async_sharded(dest, bank, visit_wrapper, pthis, key,
+                         std::forward<const VisitorArgs>(args)...);
+  }
+
+  /**
+   * @brief Visits every element with key in [lo, hi).  Only the ranks the
+   * partitioner assigns part of the range are contacted, all ranks unless it
+   * provides rank_range; owners seek to lo when their storage is ordered and
+   * scan otherwise.
+   */
+  template <typename Visitor, typename... VisitorArgs>
+  void async_visit_range(const key_type &lo, const key_type &hi,
+                         Visitor visitor, const VisitorArgs &... args) {
+    auto range_wrapper = [](auto pcomm, int from, auto pmap, uint32_t shard,
+                            const key_type &lo, const key_type &hi,
+                            const VisitorArgs &... args) {
+      pmap->local_apply(
+          shard,
+          [pmap, from](local_map_type &local_map, const key_type &lo,
+                       const key_type &hi, const VisitorArgs &... args) {
+            Visitor *vis;
+            pmap->local_for_range(local_map, lo, hi, [&](auto &kv) {
+              ygm::meta::apply_optional(*vis, std::make_tuple(pmap, from),
+                                        std::forward_as_tuple(kv, args...));
+            });
+          },
+          lo, hi, args...);
     };
 
-    m_comm.async(dest, visit_wrapper, pthis, key,
-                 std::forward<const VisitorArgs>(args)...);
+    auto [first, last] = owner_range(lo, hi);
+    for (int dest = first; dest < last; ++dest) {
+      for (uint32_t shard = 0; shard < m_local_maps.size(); ++shard) {
+        m_comm.async_sharded(dest, shard, range_wrapper, pthis, shard, lo, hi,
+                             std::forward<const VisitorArgs>(args)...);
+      }
+    }
+  }
+
+  /**
+   * @brief Half-open range of ranks that may hold keys in [lo, hi).
+   */
+  std::pair<int, int> owner_range(const key_type &lo,
+                                  const key_type &hi) const {
+    if constexpr (has_rank_range<Partitioner, key_type>::value) {
+      auto [first, last] = partitioner.rank_range(lo, hi, m_comm.size());
+      return {int(first), int(last)};
+    } else {
+      return {0, m_comm.size()};
+    }
+  }
+
+  /**
+   * @brief Collectively replaces the partitioner and moves every element to
+   * its new owner.
+   */
+  void repartition(const Partitioner &p) {
+    m_comm.barrier();
+    partitioner = p;
+    std::vector<std::pair<key_type, value_type>> moving;
+    // Shards may be the roots of a mapped file, so swap their contents out
+    // rather than replacing them
+    std::vector<local_map_type> old_maps;
+    for (auto &local_map : m_local_maps) {
+      old_maps.push_back(new_local_map());
+      old_maps.back().swap(local_map);
+    }
+    for (auto &old_map : old_maps) {
+      for (auto &kv : old_map) {
+        if (is_mine(kv.first)) {
+          local_shard(kv.first).insert(kv);
+        } else {
+          moving.emplace_back(kv.first, kv.second);
+        }
+      }
+      old_map.clear();
+    }
+    async_insert_range(moving.begin(), moving.end(), false, false);
+    m_comm.barrier();
+  }
+
+  /**
+   * @brief Collectively resamples the split points of a range partitioner
+   * from up to samples_per_rank local keys per rank, typically after a load
+   * phase, and repartitions.
+   */
+  void rebalance(size_t samples_per_rank = 1024) {
+    m_comm.barrier();
+    std::vector<key_type> keys;
+    keys.reserve(local_size());
+    for (const auto &local_map : m_local_maps) {
+      for (const auto &kv : local_map) {
+        keys.push_back(kv.first);
+      }
+    }
+    repartition(Partitioner::sample(m_comm, keys.begin(), keys.end(),
+                                    samples_per_rank));
   }
 
   void async_erase(const key_type &key) {
-    int dest = owner(key);
+    auto [dest, bank] = partitioner(key, m_comm.size(), 1024);
     auto erase_wrapper = [](auto pcomm, int from, auto pmap,
-                            const key_type &key) { pmap->local_erase(key); };
+                            const key_type &key) {
+      pmap->local_apply(
+          pmap->shard_index(key),
+          [](local_map_type &local_map, const key_type &key) {
+            local_map.erase(key);
+          },
+          key);
+    };
 
-    m_comm.async(dest, erase_wrapper, pthis, key);
+    m_comm.async_sharded(dest, bank, erase_wrapper, pthis, key);
   }
 
-  size_t local_count(const key_type &key) { return m_local_map.count(key); }
+  size_t local_count(const key_type &key) {
+    return local_shard(key).count(key);
+  }
 
   template <typename Function> void for_all(Function fn) {
     m_comm.barrier();
@@ -111,17 +555,17 @@ public:
 
   void clear() {
     m_comm.barrier();
-    m_local_map.clear();
+    local_clear();
   }
 
   size_t size() {
     m_comm.barrier();
-    return m_comm.all_reduce_sum(m_local_map.size());
+    return m_comm.all_reduce_sum(local_size());
   }
 
   size_t count(const key_type &key) {
     m_comm.barrier();
-    return m_comm.all_reduce_sum(m_local_map.count(key));
+    return m_comm.all_reduce_sum(local_count(key));
   }
 
   // Doesn't swap pthis.
@@ -129,31 +573,68 @@ public:
   void swap(self_type &s) {
     m_comm.barrier();
     std::swap(m_default_value, s.m_default_value);
-    m_local_map.swap(s.m_local_map);
+    m_local_maps.swap(s.m_local_maps);
+    m_mmap.swap(s.m_mmap);
   }
 
   template <typename STLKeyContainer, typename MapKeyValue>
   void all_gather(const STLKeyContainer &keys, MapKeyValue &output) {
     ygm::ygm_ptr<MapKeyValue> preturn(&output);
 
-    auto fetcher = [](auto pcomm, int from, const key_type &key, auto pmap,
-                      auto pcont) {
-      auto returner = [](auto pcomm, int from, const key_type &key,
-                         const std::vector<value_type> &values, auto pcont) {
-        for (const auto &v : values) {
-          pcont->insert(std::make_pair(key, v));
+    auto fetcher = [](auto pcomm, int from, auto pmap,
+                      const std::vector<key_type> &keys, auto pcont) {
+      auto returner = [](auto pcomm, int from, const gather_batch_type &kvs,
+                         auto pcont) {
+        for (const auto &kv : kvs) {
+          pcont->insert(kv);
         }
       };
-      auto values = pmap->local_get(key);
-      pcomm->async(from, returner, key, values, pcont);
+      auto kvs = pmap->local_gather(keys);
+      if (!kvs.empty()) {
+        pcomm->async(from, returner, kvs, pcont);
+      }
     };
 
     m_comm.barrier();
+    for_each_owner_batch(keys, [&](int dest, const std::vector<key_type> &b) {
+      m_comm.async(dest, fetcher, pthis, b, preturn);
+    });
+    m_comm.barrier();
+  }
+
+  /**
+   * @brief Non-collective gather.  Requests are batched per owner like
+   * all_gather, but replies are returned through futures so a rank may look
+   * keys up mid-phase.  Results reflect the messages each owner has processed
+   * when the request arrives.
+   */
+  template <typename STLKeyContainer>
+  std::vector<ygm::future<gather_batch_type>>
+  async_gather(const STLKeyContainer &keys) {
+    std::vector<ygm::future<gather_batch_type>> to_return;
+    for_each_owner_batch(keys, [&](int dest, const std::vector<key_type> &b) {
+      to_return.push_back(m_comm.async_call(
+          dest,
+          [](auto pmap, const std::vector<key_type> &keys) {
+            return pmap->local_gather(keys);
+          },
+          pthis, b));
+    });
+    return to_return;
+  }
+
+  /**
+   * @brief All local key-value pairs for a batch of keys.
+   */
+  gather_batch_type local_gather(const std::vector<key_type> &keys) {
+    gather_batch_type to_return;
     for (const auto &key : keys) {
-      int o = owner(key);
-      m_comm.async(o, fetcher, key, pthis, preturn);
+      auto range = local_shard(key).equal_range(key);
+      for (auto itr = range.first; itr != range.second; ++itr) {
+        to_return.emplace_back(itr->first, itr->second);
+      }
     }
-    m_comm.barrier();
+    return to_return;
   }
 
   typename ygm::ygm_ptr<self_type> get_ygm_ptr() const { return pthis; }
@@ -163,7 +644,17 @@ public:
     std::string rank_fname = fname + std::to_string(m_comm.rank());
     std::ofstream os(rank_fname, std::ios::binary);
     cereal::JSONOutputArchive oarchive(os);
-    oarchive(m_local_map, m_default_value, m_comm.size());
+    if constexpr (std::is_same_v<local_map_type, file_map_type>) {
+      if (m_local_maps.size() == 1) {
+        oarchive(m_local_maps[0], m_default_value, m_comm.size());
+        return;
+      }
+    }
+    file_map_type merged;
+    for (const auto &local_map : m_local_maps) {
+      merged.insert(local_map.begin(), local_map.end());
+    }
+    oarchive(merged, m_default_value, m_comm.size());
   }
 
   void deserialize(const std::string &fname) {
@@ -173,8 +664,13 @@ public:
     std::ifstream is(rank_fname, std::ios::binary);
 
     cereal::JSONInputArchive iarchive(is);
-    int comm_size;
-    iarchive(m_local_map, m_default_value, comm_size);
+    int           comm_size;
+    file_map_type merged;
+    iarchive(merged, m_default_value, comm_size);
+    local_clear();
+    for (const auto &kv : merged) {
+      local_shard(kv.first).insert(kv);
+    }
 
     if (comm_size != m_comm.size()) {
       m_comm.cerr0("Attempting to deserialize map_impl using communicator of "
@@ -182,6 +678,60 @@ public:
     }
   }
 
+  /**
+   * @brief Collectively writes a binary checkpoint of the map into the single
+   * file fname.
+   */
+  void checkpoint(const std::string &fname) {
+    m_comm.barrier();
+    checkpoint_writer writer(m_comm);
+    writer.meta(m_default_value);
+    for (const auto &local_map : m_local_maps) {
+      for (const auto &kv : local_map) {
+        writer.record(kv.first, kv.second);
+      }
+    }
+    writer.write(fname);
+  }
+
+  /**
+   * @brief Collectively replaces the contents of the map with a checkpoint,
+   * which may have been written by any number of ranks.  Rank r streams the
+   * payloads of the old ranks congruent to r modulo the current size,
+   * keeping the elements it owns and sending the rest to their owners in
+   * batches of restore_batch_size, so memory stays bounded whatever the
+   * checkpoint size.  Restoring with the same ranks and partitioner sends
+   * nothing.
+   */
+  void restore(const std::string &fname) {
+    m_comm.barrier();
+    checkpoint_reader reader(m_comm, fname);
+    local_clear();
+    reader.read_meta(0, m_default_value);
+    // Handler threads may be inserting received batches, so keep nothing
+    // locally behind their back
+    bool keep_local = m_comm.handler_threads() == 0;
+    std::vector<std::pair<key_type, value_type>> moving;
+    for (int old_rank = m_comm.rank(); old_rank < reader.num_ranks();
+         old_rank += m_comm.size()) {
+      reader.for_each_record<key_type, value_type>(
+          old_rank, [&](key_type &key, value_type &value) {
+            if (keep_local && is_mine(key)) {
+              local_shard(key).insert(
+                  std::make_pair(std::move(key), std::move(value)));
+              return;
+            }
+            moving.emplace_back(std::move(key), std::move(value));
+            if (moving.size() >= restore_batch_size) {
+              async_insert_range(moving.begin(), moving.end(), false, false);
+              moving.clear();
+            }
+          });
+    }
+    async_insert_range(moving.begin(), moving.end(), false, false);
+    m_comm.barrier();
+  }
+
   int owner(const key_type &key) const {
     auto [owner, rank] = partitioner(key, m_comm.size(), 1024);
     return owner;
@@ -191,10 +741,98 @@ public:
     return owner(key) == m_comm.rank();
   }
 
+  /**
+   * @brief Calls fn on every element of local_map with key in [lo, hi).
+   */
+  template <typename Function>
+  void local_for_range(local_map_type &local_map, const key_type &lo,
+                       const key_type &hi, Function fn) {
+    auto guard = pin(local_map);
+    if constexpr (has_lower_bound<local_map_type>::value) {
+      for (auto itr = local_map.lower_bound(lo);
+           itr != local_map.end() && Compare()(itr->first, hi); ++itr) {
+        fn(*itr);
+      }
+    } else {
+      for (auto &kv : local_map) {
+        if (!Compare()(kv.first, lo) && Compare()(kv.first, hi)) {
+          fn(kv);
+        }
+      }
+    }
+  }
+
+  /**
+   * @brief Local storage holding key.  Storage is split into one shard per
+   * handler thread so that sharded messages for different banks never touch
+   * the same shard.
+   */
+  local_map_type &local_shard(const key_type &key) {
+    return m_local_maps[shard_index(key)];
+  }
+
+  const local_map_type &local_shard(const key_type &key) const {
+    return m_local_maps[shard_index(key)];
+  }
+
+  /**
+   * @brief Local storage holding the key whose carried hash is hash.
+   */
+  local_map_type &local_shard_hashed(uint32_t hash) {
+    return m_local_maps[shard_index_hashed(hash)];
+  }
+
+  size_t shard_index_hashed(uint32_t hash) const {
+    if (m_local_maps.size() == 1) {
+      return 0;
+    }
+    return Partitioner::bank(hash, 1024) % m_local_maps.size();
+  }
+
+  /**
+   * @brief Calls fn(local_map, args...) on shard, or queues the call with
+   * copies of args while a visitor holds references into the shard, see
+   * shard_queue.  Trees never move their elements and always call fn at
+   * once.
+   */
+  template <typename Function, typename... Args>
+  void local_apply(size_t shard, Function fn, const Args &... args) {
+    if constexpr (moves_elements<local_map_type>::value) {
+      if (m_shard_queues[shard].busy()) {
+        m_shard_queues[shard].defer([this, shard, fn, args...]() {
+          fn(m_local_maps[shard], args...);
+        });
+        return;
+      }
+    }
+    fn(m_local_maps[shard], args...);
+  }
+
+  /**
+   * @brief Keeps the elements of local_map in place for the guard's
+   * lifetime; operations reaching the shard meanwhile are queued.
+   */
+  shard_queue::guard pin(local_map_type &local_map) {
+    if constexpr (moves_elements<local_map_type>::value) {
+      return shard_queue::guard(
+          &m_shard_queues[&local_map - m_local_maps.data()]);
+    } else {
+      return shard_queue::guard(nullptr);
+    }
+  }
+
+  size_t shard_index(const key_type &key) const {
+    if (m_local_maps.size() == 1) {
+      return 0;
+    }
+    auto [owner, bank] = partitioner(key, m_comm.size(), 1024);
+    return bank % m_local_maps.size();
+  }
+
   std::vector<value_type> local_get(const key_type &key) {
     std::vector<value_type> to_return;
 
-    auto range = m_local_map.equal_range(key);
+    auto range = local_shard(key).equal_range(key);
     for (auto itr = range.first; itr != range.second; ++itr) {
       to_return.push_back(itr->second);
     }
@@ -205,59 +843,279 @@ public:
   template <typename Function, typename... VisitorArgs>
   void local_visit(const key_type &key, Function &fn, const int from,
                    const VisitorArgs &... args) {
-    auto range = m_local_map.equal_range(key);
-    for (auto itr = range.first; itr != range.second; ++itr) {
+    auto &local_map = local_shard(key);
+    auto  range     = local_map.equal_range(key);
+    auto  guard     = pin(local_map);
+    local_visit_range(range.first, range.second, fn, from, args...);
+  }
+
+  template <typename Iterator, typename Function, typename... VisitorArgs>
+  void local_visit_range(Iterator first, Iterator last, Function &fn,
+                         const int from, const VisitorArgs &... args) {
+    for (auto itr = first; itr != last; ++itr) {
       ygm::meta::apply_optional(fn, std::make_tuple(pthis, from),
                                 std::forward_as_tuple(*itr, args...));
     }
   }
 
-  void local_erase(const key_type &key) { m_local_map.erase(key); }
+  void local_erase(const key_type &key) { local_shard(key).erase(key); }
 
-  void local_clear() { m_local_map.clear(); }
+  void local_clear() {
+    for (auto &local_map : m_local_maps) {
+      local_map.clear();
+    }
+  }
 
-  size_t local_size() const { return m_local_map.size(); }
+  size_t local_size() const {
+    size_t to_return{0};
+    for (const auto &local_map : m_local_maps) {
+      to_return += local_map.size();
+    }
+    return to_return;
+  }
 
-  size_t local_const(const key_type &k) const { return m_local_map.count(k); }
+  size_t local_const(const key_type &k) const {
+    return local_shard(k).count(k);
+  }
 
   ygm::comm &comm() { return m_comm; }
 
   template <typename Function> void local_for_all(Function fn) {
-    std::for_each(m_local_map.begin(), m_local_map.end(), fn);
+    for (auto &local_map : m_local_maps) {
+      auto guard = pin(local_map);
+      std::for_each(local_map.begin(), local_map.end(), fn);
+    }
+  }
+
+  /**
+   * @brief Groups keys by owner, drops duplicates, and calls
+   * fn(dest, batch) with batches of about half a send buffer.
+   */
+  template <typename STLKeyContainer, typename Function>
+  void for_each_owner_batch(const STLKeyContainer &keys, Function fn) {
+    std::vector<std::vector<key_type>> per_owner(m_comm.size());
+    for (const auto &key : keys) {
+      per_owner[owner(key)].push_back(key);
+    }
+    size_t batch_size = std::max<size_t>(
+        1, m_comm.buffer_capacity() / (2 * sizeof(key_type)));
+    for (int dest = 0; dest < m_comm.size(); ++dest) {
+      auto &owned = per_owner[dest];
+      std::sort(owned.begin(), owned.end(), Compare());
+      owned.erase(std::unique(owned.begin(), owned.end(),
+                              [](const key_type &a, const key_type &b) {
+                                return !Compare()(a, b);
+                              }),
+                  owned.end());
+      for (size_t i = 0; i < owned.size(); i += batch_size) {
+        size_t end = std::min(owned.size(), i + batch_size);
+        if (i == 0 && end == owned.size()) {
+          fn(dest, owned);
+        } else {
+          fn(dest, std::vector<key_type>(owned.begin() + i,
+                                         owned.begin() + end));
+        }
+      }
+      std::vector<key_type>().swap(owned);
+    }
   }
 
   template <typename CompareFunction>
   std::vector<std::pair<key_type, value_type>> topk(size_t k,
                                                     CompareFunction cfn) {
-    using vec_type = std::vector<std::pair<key_type, value_type>>;
-    vec_type local_topk;
-    for (const auto &kv : m_local_map) {
-      local_topk.push_back(kv);
-      std::sort(local_topk.begin(), local_topk.end(), cfn);
-      if (local_topk.size() > k) {
-        local_topk.pop_back();
+    m_comm.barrier();
+    bounded_heap<std::pair<key_type, value_type>, CompareFunction> heap(k, cfn);
+    local_for_all([&heap](const auto &kv) { heap.push(kv); });
+    return distributed_topk(m_comm, std::move(heap), k, cfn);
+  }
+
+  template <typename CompareFunction>
+  std::pair<key_type, value_type> nth_element(size_t n, CompareFunction cfn) {
+    m_comm.barrier();
+    return distributed_select(m_comm, local_weighted_pairs(), n, cfn);
+  }
+
+  template <typename CompareFunction>
+  std::pair<key_type, value_type> quantile(double q, CompareFunction cfn) {
+    m_comm.barrier();
+    return distributed_quantile(m_comm, local_weighted_pairs(), q, cfn);
+  }
+
+  template <typename CompareFunction>
+  std::vector<std::pair<key_type, value_type>>
+  approx_quantiles(const std::vector<double> &qs, CompareFunction cfn) {
+    m_comm.barrier();
+    quantile_sketch<std::pair<key_type, value_type>> sketch;
+    local_for_all([&sketch, &cfn](const auto &kv) {
+      sketch.insert(std::pair<key_type, value_type>(kv), 1, cfn);
+    });
+    return distributed_approx_quantiles(m_comm, sketch, qs, cfn);
+  }
+
+protected:
+  map_impl() = delete;
+
+  using reduce_batch_type = std::vector<std::pair<key_type, value_type>>;
+  using reduce_flusher_type = void (self_type::*)();
+
+  // Entries per combining buffer before merging; at least half a send buffer
+  size_t reduce_window() const {
+    size_t batch_size = std::max<size_t>(
+        1, m_comm.buffer_capacity() /
+               (2 * sizeof(typename reduce_batch_type::value_type)));
+    return std::max(batch_size, m_reduce_capacity / m_reduce_batches.size());
+  }
+
+  // One in hot_sample_rate updates is sampled; hot keys are recomputed every
+  // hot_refresh_interval samples
+  static constexpr uint64_t hot_sample_rate = 16;
+  static constexpr uint64_t hot_refresh_interval = 1024;
+
+  size_t hot_sampler_capacity() const {
+    return m_hot_fraction > 0 ? size_t(4 / m_hot_fraction) + 1 : 1;
+  }
+
+  template <typename ReductionOp>
+  void reduce_buffer(const key_type &key, const value_type &update) {
+    size_t num_shards = m_local_maps.size();
+    if (m_reduce_batches.empty()) {
+      m_reduce_batches.resize(m_comm.size() * num_shards);
+    }
+    auto [dest, bank] = partitioner(key, m_comm.size(), 1024);
+    size_t index = dest * num_shards + bank % num_shards;
+    m_reduce_batches[index].emplace_back(key, update);
+    if (m_reduce_batches[index].size() >= reduce_window()) {
+      reduce_send<ReductionOp>(index, false);
+    }
+  }
+
+  /**
+   * @brief Replaces the hot keys with the sketch's current heavy hitters.
+   * Pending updates of keys that cooled down go to the combining buffers.
+   */
+  template <typename ReductionOp>
+  void refresh_hot_keys() {
+    auto heavy = m_hot_sampler.heavy(m_hot_fraction);
+    std::set<key_type, Compare> hot(heavy.begin(), heavy.end());
+    std::vector<std::pair<key_type, value_type>> cooled;
+    for (auto itr = m_hot_updates.begin(); itr != m_hot_updates.end();) {
+      if (hot.count(itr->first) == 0) {
+        cooled.emplace_back(itr->first, itr->second);
+        itr = m_hot_updates.erase(itr);
+      } else {
+        ++itr;
       }
     }
+    m_hot_keys.swap(hot);
+    // Buffered only now, since sending may run handlers that update
+    // m_hot_updates and m_hot_keys
+    for (const auto &[key, update] : cooled) {
+      reduce_buffer<ReductionOp>(key, update);
+    }
+  }
 
-    auto to_return = m_comm.all_reduce(
-        local_topk, [cfn, k](const vec_type &va, const vec_type &vb) {
-          vec_type out(va.begin(), va.end());
-          out.insert(out.end(), vb.begin(), vb.end());
-          std::sort(out.begin(), out.end(), cfn);
-          while (out.size() > k) {
-            out.pop_back();
-          }
-          return out;
-        });
+  /**
+   * @brief Merges equal keys of a combining buffer with ReductionOp, then
+   * sends it unless, without force, merging left it under half full.
+   */
+  template <typename ReductionOp>
+  void reduce_send(size_t index, bool force) {
+    ReductionOp *op;
+    // Sending may run handlers that call async_reduce on this map, so they
+    // must append to a fresh buffer rather than the one being sent
+    reduce_batch_type batch;
+    batch.swap(m_reduce_batches[index]);
+    std::sort(batch.begin(), batch.end(), [](const auto &a, const auto &b) {
+      return Compare()(a.first, b.first);
+    });
+    size_t out = 0;
+    for (size_t i = 0; i < batch.size(); ++i) {
+      if (out > 0 && !Compare()(batch[out - 1].first, batch[i].first)) {
+        batch[out - 1].second = (*op)(batch[out - 1].second, batch[i].second);
+      } else {
+        if (out != i) batch[out] = std::move(batch[i]);
+        ++out;
+      }
+    }
+    batch.resize(out);
+    if (batch.empty() || (!force && 2 * batch.size() < reduce_window())) {
+      m_reduce_batches[index].swap(batch);
+      return;
+    }
+
+    auto reducer = [](auto pcomm, int from, auto pmap,
+                      const reduce_batch_type &batch) {
+      for (const auto &kv : batch) {
+        pmap->local_apply(
+            pmap->shard_index(kv.first),
+            [](local_map_type                            &local_map,
+               const std::pair<key_type, value_type> &kv) {
+              ReductionOp *op;
+              auto [itr, inserted] =
+                  detail::insert_unique(local_map, kv.first, kv.second);
+              if (!inserted) {
+                itr->second = (*op)(itr->second, kv.second);
+              }
+            },
+            kv);
+      }
+    };
+    size_t num_shards = m_local_maps.size();
+    m_comm.async_sharded(index / num_shards, index % num_shards, reducer,
+                         pthis, batch);
+    // Reuse the allocation unless handlers started a new buffer meanwhile
+    if (m_reduce_batches[index].empty()) {
+      batch.clear();
+      m_reduce_batches[index].swap(batch);
+    }
+  }
+
+  template <typename ReductionOp>
+  void reduce_flush_all() {
+    // Buffering may send and run handlers that add hot updates, which must
+    // land in a table that is not being drained
+    std::map<key_type, value_type, Compare> hot_updates;
+    hot_updates.swap(m_hot_updates);
+    for (const auto &[key, update] : hot_updates) {
+      reduce_buffer<ReductionOp>(key, update);
+    }
+    for (size_t i = 0; i < m_reduce_batches.size(); ++i) {
+      reduce_send<ReductionOp>(i, true);
+    }
+  }
+
+  std::vector<std::pair<std::pair<key_type, value_type>, uint64_t>>
+  local_weighted_pairs() {
+    std::vector<std::pair<std::pair<key_type, value_type>, uint64_t>> to_return;
+    local_for_all([&to_return](const auto &kv) {
+      to_return.emplace_back(kv, 1);
+    });
     return to_return;
   }
 
-protected:
-  map_impl() = delete;
+  local_map_type new_local_map() const {
+    if constexpr (persistent) {
+      return local_map_type(m_mmap->allocator());
+    } else {
+      return local_map_type();
+    }
+  }
 
   value_type m_default_value;
-  std::multimap<key_type, value_type, Compare, Alloc> m_local_map;
+  // Declared before m_local_maps, which may point into its mapping
+  std::unique_ptr<mmap_root<local_map_type>> m_mmap;
+  shard_array<local_map_type> m_local_maps;
+  std::vector<shard_queue> m_shard_queues;
   ygm::comm m_comm;
   typename ygm::ygm_ptr<self_type> pthis;
+  std::vector<reduce_batch_type> m_reduce_batches;
+  reduce_flusher_type m_reduce_flusher = nullptr;
+  bool m_reduce_registered = false;
+  size_t m_reduce_capacity = 1024 * 1024;
+  double m_hot_fraction = 0.01;
+  uint64_t m_hot_draw = 0;
+  heavy_hitters<key_type, Compare> m_hot_sampler{hot_sampler_capacity()};
+  std::set<key_type, Compare> m_hot_keys;
+  std::map<key_type, value_type, Compare> m_hot_updates;
 };
 } // namespace ygm::container::detail
@@ -0,0 +1,500 @@
+// Copyright 2019-2021 Lawrence Livermore National Security, LLC and other YGM
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include <ygm/comm.hpp>
+
+namespace ygm::container::detail {
+
+/**
+ * @brief Pointer stored as the distance from itself to its target, so a
+ * structure built from offset_ptrs inside one mapping stays valid wherever
+ * the mapping is placed by a later process.  An offset of 1 means null.
+ */
+template <typename T>
+class offset_ptr {
+ public:
+  using element_type      = T;
+  using value_type        = std::remove_cv_t<T>;
+  using difference_type   = std::ptrdiff_t;
+  using pointer           = offset_ptr;
+  using reference         = std::add_lvalue_reference_t<T>;
+  using iterator_category = std::random_access_iterator_tag;
+
+  template <typename U>
+  using rebind = offset_ptr<U>;
+
+  offset_ptr() noexcept = default;
+  offset_ptr(std::nullptr_t) noexcept {}
+  offset_ptr(T *p) noexcept { set(p); }
+  offset_ptr(const offset_ptr &o) noexcept { set(o.get()); }
+
+  template <typename U,
+            typename = std::enable_if_t<std::is_convertible_v<U *, T *>>>
+  offset_ptr(const offset_ptr<U> &o) noexcept {
+    set(o.get());
+  }
+
+  // Allocators hand out void pointers that containers cast back
+  template <typename U, typename = void,
+            typename = std::enable_if_t<!std::is_convertible_v<U *, T *>>,
+            typename = decltype(static_cast<T *>(std::declval<U *>()))>
+  explicit offset_ptr(const offset_ptr<U> &o) noexcept {
+    set(static_cast<T *>(o.get()));
+  }
+
+  offset_ptr &operator=(const offset_ptr &o) noexcept {
+    set(o.get());
+    return *this;
+  }
+
+  offset_ptr &operator=(T *p) noexcept {
+    set(p);
+    return *this;
+  }
+
+  T *get() const noexcept {
+    if (m_offset == 1) {
+      return nullptr;
+    }
+    return reinterpret_cast<T *>(
+        const_cast<char *>(reinterpret_cast<const char *>(this)) + m_offset);
+  }
+
+  template <typename U = T, typename = std::enable_if_t<!std::is_void_v<U>>>
+  U &operator*() const noexcept {
+    return *get();
+  }
+
+  T *operator->() const noexcept { return get(); }
+
+  template <typename U = T, typename = std::enable_if_t<!std::is_void_v<U>>>
+  U &operator[](difference_type i) const noexcept {
+    return get()[i];
+  }
+
+  explicit operator bool() const noexcept { return m_offset != 1; }
+
+  template <typename U = T, typename = std::enable_if_t<!std::is_void_v<U>>>
+  static offset_ptr pointer_to(U &r) noexcept {
+    return offset_ptr(std::addressof(r));
+  }
+
+  offset_ptr &operator+=(difference_type n) noexcept {
+    set(get() + n);
+    return *this;
+  }
+  offset_ptr &operator-=(difference_type n) noexcept {
+    set(get() - n);
+    return *this;
+  }
+  offset_ptr &operator++() noexcept { return *this += 1; }
+  offset_ptr &operator--() noexcept { return *this -= 1; }
+  offset_ptr  operator++(int) noexcept {
+    offset_ptr tmp(*this);
+    ++*this;
+    return tmp;
+  }
+  offset_ptr operator--(int) noexcept {
+    offset_ptr tmp(*this);
+    --*this;
+    return tmp;
+  }
+
+  friend offset_ptr operator+(offset_ptr p, difference_type n) noexcept {
+    return p += n;
+  }
+  friend offset_ptr operator+(difference_type n, offset_ptr p) noexcept {
+    return p += n;
+  }
+  friend offset_ptr operator-(offset_ptr p, difference_type n) noexcept {
+    return p -= n;
+  }
+  friend difference_type operator-(const offset_ptr &a,
+                                   const offset_ptr &b) noexcept {
+    return a.get() - b.get();
+  }
+
+  friend bool operator==(const offset_ptr &a, const offset_ptr &b) noexcept {
+    return a.get() == b.get();
+  }
+  friend bool operator!=(const offset_ptr &a, const offset_ptr &b) noexcept {
+    return a.get() != b.get();
+  }
+  friend bool operator<(const offset_ptr &a, const offset_ptr &b) noexcept {
+    return a.get() < b.get();
+  }
+  friend bool operator>(const offset_ptr &a, const offset_ptr &b) noexcept {
+    return a.get() > b.get();
+  }
+  friend bool operator<=(const offset_ptr &a, const offset_ptr &b) noexcept {
+    return a.get() <= b.get();
+  }
+  friend bool operator>=(const offset_ptr &a, const offset_ptr &b) noexcept {
+    return a.get() >= b.get();
+  }
+  friend bool operator==(const offset_ptr &a, std::nullptr_t) noexcept {
+    return !a;
+  }
+  friend bool operator!=(const offset_ptr &a, std::nullptr_t) noexcept {
+    return bool(a);
+  }
+
+ private:
+  void set(T *p) noexcept {
+    m_offset = p == nullptr
+                   ? 1
+                   : reinterpret_cast<const char *>(p) -
+                         reinterpret_cast<const char *>(this);
+  }
+
+  std::ptrdiff_t m_offset = 1;
+};
+
+/**
+ * @brief Allocation state at the start of a mapped file: a bump pointer, one
+ * free list per power-of-two size class and the offset of a root array of
+ * objects from which a container finds its data when the file is mapped
+ * again.  Freed blocks are only reused by requests of the same class.
+ */
+struct mmap_arena_header {
+  static constexpr uint64_t magic_value = 0x4e45524150474dULL;  // YGMAREN
+  static constexpr uint64_t version     = 1;
+  static constexpr int      num_classes = 64;
+  static constexpr int      min_class   = 4;
+
+  uint64_t              magic;
+  uint64_t              format_version;
+  uint64_t              capacity;
+  uint64_t              top;
+  uint64_t              free_lists[num_classes];
+  uint64_t              root;
+  uint64_t              root_count;
+  uint64_t              root_size;
+  uint64_t              num_ranks;
+  std::atomic<uint32_t> lock;
+
+  void *allocate(size_t bytes) {
+    int    cls  = size_class(bytes);
+    size_t size = size_t(1) << cls;
+    acquire();
+    uint64_t offset = free_lists[cls];
+    if (offset != 0) {
+      std::memcpy(&free_lists[cls], base() + offset, sizeof(uint64_t));
+    } else {
+      size_t align = std::min<size_t>(size, 4096);
+      offset       = (top + align - 1) & ~uint64_t(align - 1);
+      if (offset + size > capacity) {
+        lock.store(0, std::memory_order_release);
+        throw std::bad_alloc();
+      }
+      top = offset + size;
+    }
+    lock.store(0, std::memory_order_release);
+    return base() + offset;
+  }
+
+  void deallocate(void *p, size_t bytes) {
+    if (p == nullptr) return;
+    int      cls    = size_class(bytes);
+    uint64_t offset = static_cast<char *>(p) - base();
+    acquire();
+    std::memcpy(p, &free_lists[cls], sizeof(uint64_t));
+    free_lists[cls] = offset;
+    lock.store(0, std::memory_order_release);
+  }
+
+  char *base() { return reinterpret_cast<char *>(this); }
+
+ private:
+  static int size_class(size_t bytes) {
+    int cls = min_class;
+    while ((size_t(1) << cls) < bytes) {
+      ++cls;
+    }
+    return cls;
+  }
+
+  // Handler threads allocate for their shards concurrently
+  void acquire() {
+    uint32_t expected = 0;
+    while (!lock.compare_exchange_weak(expected, 1,
+                                       std::memory_order_acquire)) {
+      expected = 0;
+    }
+  }
+};
+
+/**
+ * @brief Names the per-rank files backing a persistent container; rank r
+ * maps prefix + r.  capacity bounds each rank's data and is reserved as a
+ * sparse file, so disk is only used as the data grows.
+ */
+struct mmap_file {
+  std::string prefix;
+  size_t      capacity = size_t(64) << 30;
+};
+
+/**
+ * @brief One rank's shared mapping of a file holding an mmap_arena_header,
+ * created on first use and mapped again, at any address, by later jobs.
+ */
+class mmap_arena {
+ public:
+  mmap_arena(const std::string &path, size_t capacity) {
+    m_fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+    if (m_fd < 0) {
+      fail("open", path);
+    }
+    struct stat st;
+    if (::fstat(m_fd, &st) != 0) {
+      fail("fstat", path);
+    }
+    m_created = st.st_size == 0;
+    m_size    = std::max<size_t>(capacity, st.st_size);
+    if (m_size > size_t(st.st_size) && ::ftruncate(m_fd, m_size) != 0) {
+      fail("ftruncate", path);
+    }
+    void *addr =
+        ::mmap(nullptr, m_size, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0);
+    if (addr == MAP_FAILED) {
+      fail("mmap", path);
+    }
+    m_header = static_cast<mmap_arena_header *>(addr);
+    if (m_created) {
+      std::memset(static_cast<void *>(m_header), 0, sizeof(mmap_arena_header));
+      m_header->magic          = mmap_arena_header::magic_value;
+      m_header->format_version = mmap_arena_header::version;
+      m_header->top            = sizeof(mmap_arena_header);
+    } else if (m_header->magic != mmap_arena_header::magic_value ||
+               m_header->format_version != mmap_arena_header::version) {
+      ::munmap(addr, m_size);
+      ::close(m_fd);
+      throw std::runtime_error("Not a YGM mmap arena: " + path);
+    }
+    m_header->capacity = m_size;
+    // A job that died holding the lock leaves it set
+    m_header->lock.store(0);
+  }
+
+  ~mmap_arena() {
+    sync();
+    ::munmap(static_cast<void *>(m_header), m_size);
+    ::close(m_fd);
+  }
+
+  mmap_arena(const mmap_arena &)            = delete;
+  mmap_arena &operator=(const mmap_arena &) = delete;
+
+  mmap_arena_header *header() const { return m_header; }
+
+  // Whether the file was empty when opened
+  bool created() const { return m_created; }
+
+  // Writes dirty pages back to the file
+  void sync() { ::msync(static_cast<void *>(m_header), m_size, MS_SYNC); }
+
+ private:
+  [[noreturn]] void fail(const char *what, const std::string &path) {
+    std::string msg = std::string(what) + " " + path + ": " + strerror(errno);
+    if (m_fd >= 0) {
+      ::close(m_fd);
+    }
+    throw std::runtime_error(msg);
+  }
+
+  int                m_fd = -1;
+  size_t             m_size{0};
+  bool               m_created{false};
+  mmap_arena_header *m_header = nullptr;
+};
+
+/**
+ * @brief Allocator handing out offset_ptrs into an mmap_arena.  It holds an
+ * offset_ptr to the arena itself, so containers embedding it may live in
+ * the mapping.  A default constructed allocator is unbound and throws
+ * std::bad_alloc.
+ */
+template <typename T>
+class mmap_allocator {
+ public:
+  using value_type         = T;
+  using pointer            = offset_ptr<T>;
+  using const_pointer      = offset_ptr<const T>;
+  using void_pointer       = offset_ptr<void>;
+  using const_void_pointer = offset_ptr<const void>;
+  using size_type          = size_t;
+  using difference_type    = std::ptrdiff_t;
+  using propagate_on_container_copy_assignment = std::true_type;
+  using propagate_on_container_move_assignment = std::true_type;
+  using propagate_on_container_swap            = std::true_type;
+
+  template <typename U>
+  struct rebind {
+    using other = mmap_allocator<U>;
+  };
+
+  mmap_allocator() = default;
+
+  explicit mmap_allocator(mmap_arena_header *arena) : m_arena(arena) {}
+
+  template <typename U>
+  mmap_allocator(const mmap_allocator<U> &o) : m_arena(o.arena()) {}
+
+  pointer allocate(size_t n) {
+    if (!m_arena) {
+      throw std::bad_alloc();
+    }
+    return pointer(static_cast<T *>(m_arena->allocate(n * sizeof(T))));
+  }
+
+  void deallocate(pointer p, size_t n) {
+    m_arena->deallocate(const_cast<std::remove_cv_t<T> *>(p.get()),
+                        n * sizeof(T));
+  }
+
+  mmap_arena_header *arena() const { return m_arena.get(); }
+
+  template <typename U>
+  bool operator==(const mmap_allocator<U> &o) const {
+    return arena() == o.arena();
+  }
+  template <typename U>
+  bool operator!=(const mmap_allocator<U> &o) const {
+    return arena() != o.arena();
+  }
+
+ private:
+  offset_ptr<mmap_arena_header> m_arena;
+};
+
+template <typename Alloc>
+struct is_mmap_allocator : std::false_type {};
+
+template <typename T>
+struct is_mmap_allocator<mmap_allocator<T>> : std::true_type {};
+
+/**
+ * @brief A rank's arena together with the root array of Local objects, one
+ * per shard, holding a persistent container's local data.  The container
+ * works on the roots in place, so the file references live data at every
+ * moment and a job that dies after reattaching leaves it intact.
+ */
+template <typename Local>
+class mmap_root {
+ public:
+  mmap_root(ygm::comm &comm, const mmap_file &file, size_t count)
+      : m_arena(file.prefix + std::to_string(comm.rank()), file.capacity) {
+    auto *header = m_arena.header();
+    auto  alloc   = allocator();
+    if (header->root == 0) {
+      void *root = header->allocate(count * sizeof(Local));
+      m_roots    = static_cast<Local *>(root);
+      for (size_t i = 0; i < count; ++i) {
+        ::new (static_cast<void *>(m_roots + i)) Local(alloc);
+      }
+      header->root       = static_cast<char *>(root) - header->base();
+      header->root_count = count;
+      header->root_size  = sizeof(Local);
+      header->num_ranks  = comm.size();
+    } else {
+      m_roots = reinterpret_cast<Local *>(header->base() + header->root);
+    }
+    if (header->num_ranks != uint64_t(comm.size()) ||
+        header->root_count != count || header->root_size != sizeof(Local)) {
+      throw std::runtime_error(
+          "Persistent container file " + file.prefix +
+          std::to_string(comm.rank()) +
+          " was written by a different number of ranks, handler threads or "
+          "element type");
+    }
+  }
+
+  auto allocator() const {
+    return typename Local::allocator_type(m_arena.header());
+  }
+
+  bool created() const { return m_arena.created(); }
+
+  Local *roots() const { return m_roots; }
+
+  size_t count() const { return m_arena.header()->root_count; }
+
+  // Flushes the mapping to the file
+  void sync() { m_arena.sync(); }
+
+ private:
+  mmap_arena m_arena;
+  Local     *m_roots = nullptr;
+};
+
+/**
+ * @brief A container's local storage, one Local per shard, either owned or
+ * the roots of an mmap_root.  Swapping exchanges whole arrays, so neither
+ * kind ever moves its Locals.
+ */
+template <typename Local>
+class shard_array {
+ public:
+  shard_array() = default;
+
+  explicit shard_array(size_t count)
+      : m_owned(count), m_data(m_owned.data()), m_size(count) {}
+
+  explicit shard_array(mmap_root<Local> &root)
+      : m_data(root.roots()), m_size(root.count()) {}
+
+  shard_array(shard_array &&o) noexcept { swap(o); }
+
+  shard_array &operator=(shard_array &&o) noexcept {
+    swap(o);
+    return *this;
+  }
+
+  // Moving a vector keeps its buffer, so m_data stays valid
+  void swap(shard_array &o) noexcept {
+    m_owned.swap(o.m_owned);
+    std::swap(m_data, o.m_data);
+    std::swap(m_size, o.m_size);
+  }
+
+  size_t size() const { return m_size; }
+
+  Local       *data() { return m_data; }
+  const Local *data() const { return m_data; }
+
+  Local       &operator[](size_t i) { return m_data[i]; }
+  const Local &operator[](size_t i) const { return m_data[i]; }
+
+  Local       *begin() { return m_data; }
+  Local       *end() { return m_data + m_size; }
+  const Local *begin() const { return m_data; }
+  const Local *end() const { return m_data + m_size; }
+
+ private:
+  std::vector<Local> m_owned;
+  Local             *m_data = nullptr;
+  size_t             m_size = 0;
+};
+
+}  // namespace ygm::container::detail
@@ -0,0 +1,121 @@
+// Copyright 2019-2021 Lawrence Livermore National Security, LLC and other YGM
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: MIT
+
+#pragma once
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <type_traits>
+#include <vector>
+#include <ygm/comm.hpp>
+#include <ygm/container/detail/hash_partitioner.hpp>
+#include <ygm/container/detail/key_hash.hpp>
+
+namespace ygm::container::detail {
+
+/**
+ * @brief Places keys in contiguous Compare-ordered ranges, one per rank, so
+ * that a scan over [lo, hi) only involves the ranks owning that range.  Rank
+ * r + 1 starts at splits()[r]; without splits every key belongs to rank 0.
+ * Banks still come from the key's hash so handler threads stay balanced.
+ */
+template <typename Key, typename Compare = std::less<Key>>
+struct range_partitioner {
+  range_partitioner() = default;
+
+  explicit range_partitioner(std::vector<Key> splits)
+      : m_splits(std::move(splits)) {}
+
+  std::pair<size_t, size_t> operator()(const Key& k, size_t nranks,
+                                       size_t nbanks) const {
+    size_t rank = std::min(upper_rank(k), nranks - 1);
+    return std::make_pair(
+        rank, hash_partitioner<Key>::bank(uint32_t(key_hash<Key>{}(k)), nbanks));
+  }
+
+  /**
+   * @brief Half-open range of ranks that may hold keys in [lo, hi).
+   */
+  std::pair<size_t, size_t> rank_range(const Key& lo, const Key& hi,
+                                       size_t nranks) const {
+    if (!Compare()(lo, hi)) {
+      return {0, 0};
+    }
+    size_t first = std::min(upper_rank(lo), nranks - 1);
+    size_t last  = std::lower_bound(m_splits.begin(), m_splits.end(), hi,
+                                    Compare()) -
+                  m_splits.begin();
+    return {first, std::min(last, nranks - 1) + 1};
+  }
+
+  const std::vector<Key>& splits() const { return m_splits; }
+
+  /**
+   * @brief Collectively chooses split points giving each rank an equal share
+   * of the union of every rank's local_sample.
+   */
+  static range_partitioner sample(ygm::comm& comm,
+                                  std::vector<Key> local_sample) {
+    std::sort(local_sample.begin(), local_sample.end(), Compare());
+    auto all = comm.all_reduce(
+        local_sample, [](const std::vector<Key>& a, const std::vector<Key>& b) {
+          std::vector<Key> merged;
+          merged.reserve(a.size() + b.size());
+          std::merge(a.begin(), a.end(), b.begin(), b.end(),
+                     std::back_inserter(merged), Compare());
+          return merged;
+        });
+    std::vector<Key> splits;
+    if (!all.empty()) {
+      for (int r = 1; r < comm.size(); ++r) {
+        splits.push_back(all[all.size() * r / comm.size()]);
+      }
+    }
+    return range_partitioner(std::move(splits));
+  }
+
+  /**
+   * @brief Collectively chooses split points from up to samples_per_rank
+   * evenly spaced keys of every rank's local range of keys.
+   */
+  template <typename InputIt>
+  static range_partitioner sample(ygm::comm& comm, InputIt first,
+                                  InputIt last,
+                                  size_t  samples_per_rank = 1024) {
+    size_t n      = std::distance(first, last);
+    size_t stride = std::max<size_t>(1, n / std::max<size_t>(1, samples_per_rank));
+    std::vector<Key> local_sample;
+    for (size_t i = 0; i < n; ++i, ++first) {
+      if (i % stride == 0) {
+        local_sample.push_back(*first);
+      }
+    }
+    return sample(comm, std::move(local_sample));
+  }
+
+ private:
+  size_t upper_rank(const Key& k) const {
+    return std::upper_bound(m_splits.begin(), m_splits.end(), k, Compare()) -
+           m_splits.begin();
+  }
+
+  std::vector<Key> m_splits;
+};
+
+/**
+ * @brief Whether Partitioner can bound the ranks owning a key range.
+ */
+template <typename Partitioner, typename Key, typename = void>
+struct has_rank_range : std::false_type {};
+
+template <typename Partitioner, typename Key>
+struct has_rank_range<Partitioner, Key,
+                      std::void_t<decltype(std::declval<const Partitioner&>()
+                                               .rank_range(std::declval<Key>(),
+                                                           std::declval<Key>(),
+                                                           size_t(0)))>>
+    : std::true_type {};
+
+}  // namespace ygm::container::detail
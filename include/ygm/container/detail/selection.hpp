@@ -0,0 +1,309 @@
+// Copyright 2019-2021 Lawrence Livermore National Security, LLC and other YGM
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <algorithm>
+#include <cereal/types/utility.hpp>
+#include <cereal/types/vector.hpp>
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include <ygm/comm.hpp>
+#include <ygm/detail/assert.hpp>
+
+namespace ygm::container::detail {
+
+/**
+ * @brief Keeps the k best elements seen, best meaning first under cfn.  The
+ * heap's front is the worst element kept, so each insert is O(log k).
+ */
+template <typename T, typename Compare>
+class bounded_heap {
+ public:
+  bounded_heap(size_t k, Compare cfn) : m_k(k), m_cfn(cfn) {
+    m_heap.reserve(k);
+  }
+
+  template <typename U>
+  void push(const U &u) {
+    if (m_heap.size() < m_k) {
+      m_heap.push_back(u);
+      std::push_heap(m_heap.begin(), m_heap.end(), m_cfn);
+    } else if (m_k > 0 && m_cfn(u, m_heap.front())) {
+      std::pop_heap(m_heap.begin(), m_heap.end(), m_cfn);
+      m_heap.back() = u;
+      std::push_heap(m_heap.begin(), m_heap.end(), m_cfn);
+    }
+  }
+
+  /**
+   * @brief The kept elements, best first.
+   */
+  std::vector<T> sorted() && {
+    std::sort_heap(m_heap.begin(), m_heap.end(), m_cfn);
+    return std::move(m_heap);
+  }
+
+ private:
+  size_t         m_k;
+  Compare        m_cfn;
+  std::vector<T> m_heap;
+};
+
+/**
+ * @brief Merges two sorted vectors, keeping the first k elements.
+ */
+template <typename T, typename Compare>
+std::vector<T> merge_topk(const std::vector<T> &a, const std::vector<T> &b,
+                          size_t k, Compare cfn) {
+  std::vector<T> out;
+  out.reserve(std::min(k, a.size() + b.size()));
+  auto ia = a.begin(), ib = b.begin();
+  while (out.size() < k && (ia != a.end() || ib != b.end())) {
+    if (ib == b.end() || (ia != a.end() && !cfn(*ib, *ia))) {
+      out.push_back(*ia++);
+    } else {
+      out.push_back(*ib++);
+    }
+  }
+  return out;
+}
+
+/**
+ * @brief Global top-k: a bounded heap per rank followed by a merge reduction.
+ */
+template <typename T, typename Compare>
+std::vector<T> distributed_topk(ygm::comm &comm, bounded_heap<T, Compare> heap,
+                                size_t k, Compare cfn) {
+  return comm.all_reduce(std::move(heap).sorted(),
+                         [k, cfn](const std::vector<T> &a,
+                                  const std::vector<T> &b) {
+                           return merge_topk(a, b, k, cfn);
+                         });
+}
+
+/**
+ * @brief Collective selection of the element of global rank n (0-based) in
+ * cfn order from weighted local elements.  Each round every rank proposes its
+ * local median, the weighted median of the proposals becomes the pivot, and
+ * the side of the pivot holding rank n is kept, so O(log N) rounds of small
+ * collectives are needed.
+ *
+ * @param local (element, weight) pairs held by this rank; consumed
+ */
+template <typename T, typename Compare>
+T distributed_select(ygm::comm &comm, std::vector<std::pair<T, uint64_t>> local,
+                     uint64_t n, Compare cfn) {
+  using weighted = std::pair<T, uint64_t>;
+  auto less      = [&cfn](const weighted &a, const weighted &b) {
+    return cfn(a.first, b.first);
+  };
+
+  while (true) {
+    uint64_t local_weight{0};
+    for (const auto &w : local) local_weight += w.second;
+    uint64_t total_weight = comm.all_reduce_sum(local_weight);
+    ASSERT_RELEASE(n < total_weight);
+
+    // Local medians weighted by each rank's remaining weight
+    std::vector<weighted> proposals;
+    if (!local.empty()) {
+      auto mid = local.begin() + local.size() / 2;
+      std::nth_element(local.begin(), mid, local.end(), less);
+      proposals.emplace_back(mid->first, local_weight);
+    }
+    proposals = comm.all_reduce(
+        proposals, [](const std::vector<weighted> &a,
+                      const std::vector<weighted> &b) {
+          std::vector<weighted> out(a);
+          out.insert(out.end(), b.begin(), b.end());
+          return out;
+        });
+    std::sort(proposals.begin(), proposals.end(), less);
+    uint64_t seen{0};
+    T        pivot = proposals.back().first;
+    for (const auto &p : proposals) {
+      seen += p.second;
+      if (2 * seen >= total_weight) {
+        pivot = p.first;
+        break;
+      }
+    }
+
+    uint64_t local_less{0}, local_equal{0};
+    for (const auto &w : local) {
+      if (cfn(w.first, pivot)) {
+        local_less += w.second;
+      } else if (!cfn(pivot, w.first)) {
+        local_equal += w.second;
+      }
+    }
+    uint64_t global_less  = comm.all_reduce_sum(local_less);
+    uint64_t global_equal = comm.all_reduce_sum(local_equal);
+
+    if (n < global_less) {
+      local.erase(std::remove_if(local.begin(), local.end(),
+                                 [&](const weighted &w) {
+                                   return !cfn(w.first, pivot);
+                                 }),
+                  local.end());
+    } else if (n < global_less + global_equal) {
+      return pivot;
+    } else {
+      n -= global_less + global_equal;
+      local.erase(std::remove_if(local.begin(), local.end(),
+                                 [&](const weighted &w) {
+                                   return !cfn(pivot, w.first);
+                                 }),
+                  local.end());
+    }
+  }
+}
+
+/**
+ * @brief Collective exact quantile q in [0, 1]: the element of global rank
+ * floor(q * (N - 1)) where N is the total weight.
+ */
+template <typename T, typename Compare>
+T distributed_quantile(ygm::comm                          &comm,
+                       std::vector<std::pair<T, uint64_t>> local, double q,
+                       Compare cfn) {
+  uint64_t local_weight{0};
+  for (const auto &w : local) local_weight += w.second;
+  uint64_t total_weight = comm.all_reduce_sum(local_weight);
+  ASSERT_RELEASE(total_weight > 0);
+  uint64_t n = uint64_t(std::clamp(q, 0.0, 1.0) * (total_weight - 1));
+  return distributed_select(comm, std::move(local), n, cfn);
+}
+
+/**
+ * @brief Mergeable approximate quantile sketch.  Level h holds items of
+ * weight 2^h; a full level is sorted and every other item, starting at an
+ * alternating offset, is promoted to the next level.  Rank error is about
+ * log2(n / k) / k of the total weight.  The ordering is passed to each call
+ * rather than stored so that sketches stay default constructible for
+ * serialization.
+ */
+template <typename T>
+class quantile_sketch {
+ public:
+  quantile_sketch(size_t k = 256) : m_k(k) {}
+
+  template <typename Compare>
+  void insert(const T &t, uint64_t weight, Compare cfn) {
+    // Decompose the weight into powers of two
+    for (size_t h = 0; weight > 0; ++h, weight >>= 1) {
+      if (weight & 1) {
+        level(h).push_back(t);
+        compact(h, cfn);
+      }
+    }
+  }
+
+  template <typename Compare>
+  void merge(const quantile_sketch &o, Compare cfn) {
+    for (size_t h = 0; h < o.m_levels.size(); ++h) {
+      auto &l = level(h);
+      l.insert(l.end(), o.m_levels[h].begin(), o.m_levels[h].end());
+    }
+    for (size_t h = 0; h < m_levels.size(); ++h) {
+      compact(h, cfn);
+    }
+  }
+
+  uint64_t total_weight() const {
+    uint64_t to_return{0};
+    for (size_t h = 0; h < m_levels.size(); ++h) {
+      to_return += m_levels[h].size() << h;
+    }
+    return to_return;
+  }
+
+  /**
+   * @brief Approximate items at each quantile in qs, each in [0, 1].
+   */
+  template <typename Compare>
+  std::vector<T> quantiles(const std::vector<double> &qs, Compare cfn) const {
+    std::vector<std::pair<T, uint64_t>> items;
+    for (size_t h = 0; h < m_levels.size(); ++h) {
+      for (const auto &t : m_levels[h]) {
+        items.emplace_back(t, uint64_t(1) << h);
+      }
+    }
+    ASSERT_RELEASE(!items.empty());
+    std::sort(items.begin(), items.end(),
+              [&cfn](const auto &a, const auto &b) {
+                return cfn(a.first, b.first);
+              });
+    uint64_t       total = total_weight();
+    std::vector<T> to_return;
+    for (double q : qs) {
+      uint64_t target = uint64_t(std::clamp(q, 0.0, 1.0) * (total - 1));
+      uint64_t seen{0};
+      size_t   i = 0;
+      while (i + 1 < items.size() && seen + items[i].second <= target) {
+        seen += items[i++].second;
+      }
+      to_return.push_back(items[i].first);
+    }
+    return to_return;
+  }
+
+  template <class Archive>
+  void serialize(Archive &ar) {
+    ar(m_k, m_levels, m_offsets);
+  }
+
+ private:
+  std::vector<T> &level(size_t h) {
+    if (h >= m_levels.size()) {
+      m_levels.resize(h + 1);
+      m_offsets.resize(h + 1, 0);
+    }
+    return m_levels[h];
+  }
+
+  template <typename Compare>
+  void compact(size_t h, Compare cfn) {
+    while (h < m_levels.size() && m_levels[h].size() >= 2 * m_k) {
+      auto &l = m_levels[h];
+      std::sort(l.begin(), l.end(), cfn);
+      std::vector<T> promoted;
+      promoted.reserve(l.size() / 2);
+      for (size_t i = m_offsets[h]; i < l.size(); i += 2) {
+        promoted.push_back(l[i]);
+      }
+      m_offsets[h] ^= 1;
+      l.clear();
+      auto &next = level(h + 1);
+      next.insert(next.end(), promoted.begin(), promoted.end());
+      ++h;
+    }
+  }
+
+  size_t                      m_k;
+  std::vector<std::vector<T>> m_levels;
+  std::vector<uint8_t>        m_offsets;
+};
+
+/**
+ * @brief Collective approximate quantiles from each rank's local sketch.
+ */
+template <typename T, typename Compare>
+std::vector<T> distributed_approx_quantiles(ygm::comm                &comm,
+                                            const quantile_sketch<T> &local,
+                                            const std::vector<double> &qs,
+                                            Compare                    cfn) {
+  auto global = comm.all_reduce(
+      local, [cfn](const quantile_sketch<T> &a, const quantile_sketch<T> &b) {
+        quantile_sketch<T> out(a);
+        out.merge(b, cfn);
+        return out;
+      });
+  return global.quantiles(qs, cfn);
+}
+
+}  // namespace ygm::container::detail
@@ -5,53 +5,177 @@
 
 #pragma once
 #include <cereal/archives/json.hpp>
+#include <cereal/types/vector.hpp>
 #include <fstream>
 #include <set>
 #include <ygm/comm.hpp>
+#include <ygm/container/detail/checkpoint.hpp>
 #include <ygm/container/detail/hash_partitioner.hpp>
+#include <ygm/container/detail/mmap_allocator.hpp>
+#include <ygm/container/detail/storage.hpp>
 #include <ygm/detail/ygm_ptr.hpp>
 
 namespace ygm::container::detail {
 template <typename Key, typename Partitioner = detail::hash_partitioner<Key>,
           typename Compare = std::less<Key>,
-          class Alloc = std::allocator<const Key>>
+          class Alloc = std::allocator<const Key>,
+          typename Storage = detail::tree_storage>
 class set_impl {
 public:
-  using self_type = set_impl<Key, Partitioner, Compare, Alloc>;
+  using self_type = set_impl<Key, Partitioner, Compare, Alloc, Storage>;
   using key_type = Key;
+  using local_set_type =
+      typename Storage::template set_type<key_type, Compare, Alloc>;
+  // Serialized files always hold an ordered multiset, whatever the storage
+  using file_set_type = std::multiset<key_type, Compare>;
 
   Partitioner partitioner;
 
-  set_impl(ygm::comm &comm) : m_comm(comm), pthis(this) { m_comm.barrier(); }
+  // Most checkpoint records a rank holds before sending them to new owners
+  static constexpr size_t restore_batch_size = size_t(1) << 16;
+
+  // Whether local data lives in memory-mapped files, see mmap_file
+  static constexpr bool persistent = is_mmap_allocator<Alloc>::value;
+  static_assert(!persistent || std::is_base_of_v<hash_storage, Storage>,
+                "mmap_allocator requires hash_storage; the node and vector "
+                "based storages keep raw pointers");
+  static_assert(!persistent || std::is_trivially_copyable_v<Key>,
+                "Persistent sets need keys that own no memory");
+
+  set_impl(ygm::comm &comm) : m_comm(comm), pthis(this) {
+    m_local_sets =
+        shard_array<local_set_type>(std::max(1, m_comm.handler_threads()));
+    m_shard_queues.resize(m_local_sets.size());
+    m_comm.barrier();
+  }
+
+  /**
+   * @brief Constructs a set whose local data lives in the files named by
+   * file, reattaching to the data left there by an earlier job on the same
+   * number of ranks and handler threads, or starting empty.
+   */
+  set_impl(ygm::comm &comm, const mmap_file &file)
+      : m_comm(comm), pthis(this) {
+    static_assert(persistent, "mmap_file requires an mmap_allocator");
+    size_t num_shards = std::max(1, m_comm.handler_threads());
+    m_mmap = std::make_unique<mmap_root<local_set_type>>(m_comm, file,
+                                                         num_shards);
+    m_local_sets = shard_array<local_set_type>(*m_mmap);
+    m_shard_queues.resize(num_shards);
+    m_comm.barrier();
+  }
 
   ~set_impl() { m_comm.barrier(); }
 
+  /**
+   * @brief Collectively flushes a persistent set's files, which unmapping
+   * them at destruction also does.
+   */
+  void persist() {
+    m_comm.barrier();
+    m_mmap->sync();
+  }
+
   void async_insert_multi(const key_type &key) {
     auto inserter = [](auto mailbox, int from, auto pset, const key_type &key) {
-      pset->m_local_set.insert(key);
+      pset->local_apply(
+          pset->shard_index(key),
+          [](local_set_type &local_set, const key_type &key) {
+            local_set.insert(key);
+          },
+          key);
     };
-    int dest = owner(key);
-    m_comm.async(dest, inserter, pthis, key);
+    auto [dest, bank] = partitioner(key, m_comm.size(), 1024);
+    m_comm.async_sharded(dest, bank, inserter, pthis, key);
   }
 
   void async_insert_unique(const key_type &key) {
     auto inserter = [](auto mailbox, int from, auto pset, const key_type &key) {
-      if (pset->m_local_set.count(key) == 0) {
-        pset->m_local_set.insert(key);
+      pset->local_apply(
+          pset->shard_index(key),
+          [](local_set_type &local_set, const key_type &key) {
+            detail::insert_if_absent(local_set, key);
+          },
+          key);
+    };
+    auto [dest, bank] = partitioner(key, m_comm.size(), 1024);
+    m_comm.async_sharded(dest, bank, inserter, pthis, key);
+  }
+
+  /**
+   * @brief Inserts a local range of keys.  Keys are partitioned by owner in
+   * one pass and shipped in batches that the owner decodes in a single
+   * handler.  With combine, duplicate keys within a batch are dropped before
+   * sending, which only makes sense when unique.
+   */
+  template <typename InputIt>
+  void async_insert_range(InputIt first, InputIt last, bool unique,
+                          bool combine) {
+    using batch_type = std::vector<key_type>;
+    size_t num_shards = m_local_sets.size();
+    // Aim for batches of about half a send buffer
+    size_t batch_size =
+        std::max<size_t>(1, m_comm.buffer_capacity() / (2 * sizeof(key_type)));
+
+    auto inserter = [](auto pcomm, int from, auto pset, const batch_type &batch,
+                       bool unique) {
+      for (const auto &key : batch) {
+        pset->local_apply(
+            pset->shard_index(key),
+            [](local_set_type &local_set, const key_type &key, bool unique) {
+              if (unique) {
+                detail::insert_if_absent(local_set, key);
+              } else {
+                local_set.insert(key);
+              }
+            },
+            key, unique);
       }
     };
-    int dest = owner(key);
-    m_comm.async(dest, inserter, pthis, key);
+
+    auto send_batch = [&](int dest, size_t shard, batch_type &batch) {
+      if (combine) {
+        std::sort(batch.begin(), batch.end(), Compare());
+        batch.erase(std::unique(batch.begin(), batch.end(),
+                                [](const key_type &a, const key_type &b) {
+                                  return !Compare()(a, b);
+                                }),
+                    batch.end());
+      }
+      m_comm.async_sharded(dest, shard, inserter, pthis, batch, unique);
+      batch.clear();
+    };
+
+    std::vector<batch_type> batches(m_comm.size() * num_shards);
+    for (; first != last; ++first) {
+      auto [dest, bank] = partitioner(*first, m_comm.size(), 1024);
+      size_t shard = bank % num_shards;
+      auto &batch = batches[dest * num_shards + shard];
+      batch.push_back(*first);
+      if (batch.size() >= batch_size) {
+        send_batch(dest, shard, batch);
+      }
+    }
+    for (size_t i = 0; i < batches.size(); ++i) {
+      if (!batches[i].empty()) {
+        send_batch(i / num_shards, i % num_shards, batches[i]);
+      }
+    }
   }
 
   void async_erase(const key_type &key) {
-    int dest = owner(key);
+    auto [dest, bank] = partitioner(key, m_comm.size(), 1024);
     auto erase_wrapper = [](auto pcomm, int from, auto pset,
                             const key_type &key) {
-      pset->m_local_set.erase(key);
+      pset->local_apply(
+          pset->shard_index(key),
+          [](local_set_type &local_set, const key_type &key) {
+            local_set.erase(key);
+          },
+          key);
     };
 
-    m_comm.async(dest, erase_wrapper, pthis, key);
+    m_comm.async_sharded(dest, bank, erase_wrapper, pthis, key);
   }
 
   template <typename Function> void for_all(Function fn) {
@@ -61,34 +185,53 @@ public:
 
   void clear() {
     m_comm.barrier();
-    m_local_set.clear();
+    for (auto &local_set : m_local_sets) {
+      local_set.clear();
+    }
   }
 
   size_t size() {
     m_comm.barrier();
-    return m_comm.all_reduce_sum(m_local_set.size());
+    size_t local_size{0};
+    for (const auto &local_set : m_local_sets) {
+      local_size += local_set.size();
+    }
+    return m_comm.all_reduce_sum(local_size);
   }
 
   size_t count(const key_type &key) {
     m_comm.barrier();
-    return m_comm.all_reduce_sum(m_local_set.count(key));
+    return m_comm.all_reduce_sum(local_shard(key).count(key));
   }
 
   // Doesn't swap pthis.
   // should we check comm is equal? -- probably
   void swap(self_type &s) {
     m_comm.barrier();
-    m_local_set.swap(s.m_local_set);
+    m_local_sets.swap(s.m_local_sets);
+    m_mmap.swap(s.m_mmap);
   }
 
   typename ygm::ygm_ptr<self_type> get_ygm_ptr() const { return pthis; }
 
+  ygm::comm &comm() { return m_comm; }
+
   void serialize(const std::string &fname) {
     m_comm.barrier();
     std::string rank_fname = fname + std::to_string(m_comm.rank());
     std::ofstream os(rank_fname, std::ios::binary);
     cereal::JSONOutputArchive oarchive(os);
-    oarchive(m_local_set, m_comm.size());
+    if constexpr (std::is_same_v<local_set_type, file_set_type>) {
+      if (m_local_sets.size() == 1) {
+        oarchive(m_local_sets[0], m_comm.size());
+        return;
+      }
+    }
+    file_set_type merged;
+    for (const auto &local_set : m_local_sets) {
+      merged.insert(local_set.begin(), local_set.end());
+    }
+    oarchive(merged, m_comm.size());
   }
 
   void deserialize(const std::string &fname) {
@@ -98,8 +241,15 @@ public:
     std::ifstream is(rank_fname, std::ios::binary);
 
     cereal::JSONInputArchive iarchive(is);
-    int comm_size;
-    iarchive(m_local_set, comm_size);
+    int           comm_size;
+    file_set_type merged;
+    iarchive(merged, comm_size);
+    for (auto &local_set : m_local_sets) {
+      local_set.clear();
+    }
+    for (const auto &key : merged) {
+      local_shard(key).insert(key);
+    }
 
     if (comm_size != m_comm.size()) {
       m_comm.cerr0("Attempting to deserialize set_impl using communicator of "
@@ -107,9 +257,101 @@ public:
     }
   }
 
+  /**
+   * @brief Collectively writes a binary checkpoint of the set into the single
+   * file fname.
+   */
+  void checkpoint(const std::string &fname) {
+    m_comm.barrier();
+    checkpoint_writer writer(m_comm);
+    writer.meta();
+    for (const auto &local_set : m_local_sets) {
+      for (const auto &key : local_set) {
+        writer.record(key);
+      }
+    }
+    writer.write(fname);
+  }
+
+  /**
+   * @brief Collectively replaces the contents of the set with a checkpoint,
+   * which may have been written by any number of ranks.  Rank r streams the
+   * payloads of the old ranks congruent to r modulo the current size,
+   * keeping the keys it owns and sending the rest to their owners in bounded
+   * batches.
+   */
+  void restore(const std::string &fname) {
+    m_comm.barrier();
+    checkpoint_reader reader(m_comm, fname);
+    for (auto &local_set : m_local_sets) {
+      local_set.clear();
+    }
+    // Handler threads may be inserting received batches
+    bool                  keep_local = m_comm.handler_threads() == 0;
+    std::vector<key_type> moving;
+    for (int old_rank = m_comm.rank(); old_rank < reader.num_ranks();
+         old_rank += m_comm.size()) {
+      reader.for_each_record<key_type>(old_rank, [&](key_type &key) {
+        if (keep_local && owner(key) == m_comm.rank()) {
+          local_shard(key).insert(std::move(key));
+          return;
+        }
+        moving.push_back(std::move(key));
+        if (moving.size() >= restore_batch_size) {
+          async_insert_range(moving.begin(), moving.end(), false, false);
+          moving.clear();
+        }
+      });
+    }
+    async_insert_range(moving.begin(), moving.end(), false, false);
+    m_comm.barrier();
+  }
+
   // protected:
   template <typename Function> void local_for_all(Function fn) {
-    std::for_each(m_local_set.begin(), m_local_set.end(), fn);
+    for (auto &local_set : m_local_sets) {
+      auto guard = pin(local_set);
+      std::for_each(local_set.begin(), local_set.end(), fn);
+    }
+  }
+
+  // Local storage holding key; one shard per handler thread
+  local_set_type &local_shard(const key_type &key) {
+    return m_local_sets[shard_index(key)];
+  }
+
+  size_t shard_index(const key_type &key) const {
+    if (m_local_sets.size() == 1) {
+      return 0;
+    }
+    auto [owner, bank] = partitioner(key, m_comm.size(), 1024);
+    return bank % m_local_sets.size();
+  }
+
+  /**
+   * @brief Calls fn(local_set, args...) on shard, or queues the call with
+   * copies of args while for_all iterates the shard, see shard_queue.
+   */
+  template <typename Function, typename... Args>
+  void local_apply(size_t shard, Function fn, const Args &... args) {
+    if constexpr (moves_elements<local_set_type>::value) {
+      if (m_shard_queues[shard].busy()) {
+        m_shard_queues[shard].defer([this, shard, fn, args...]() {
+          fn(m_local_sets[shard], args...);
+        });
+        return;
+      }
+    }
+    fn(m_local_sets[shard], args...);
+  }
+
+  shard_queue::guard pin(local_set_type &local_set) {
+    if constexpr (moves_elements<local_set_type>::value) {
+      return shard_queue::guard(
+          &m_shard_queues[&local_set - m_local_sets.data()]);
+    } else {
+      return shard_queue::guard(nullptr);
+    }
   }
 
   int owner(const key_type &key) const {
@@ -118,7 +360,10 @@ public:
   }
   set_impl() = delete;
 
-  std::multiset<key_type, Compare, Alloc> m_local_set;
+  // Declared before m_local_sets, which may point into its mapping
+  std::unique_ptr<mmap_root<local_set_type>> m_mmap;
+  shard_array<local_set_type> m_local_sets;
+  std::vector<shard_queue> m_shard_queues;
   ygm::comm m_comm;
   typename ygm::ygm_ptr<self_type> pthis;
 };
@@ -0,0 +1,231 @@
+// Copyright 2019-2021 Lawrence Livermore National Security, LLC and other YGM
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <deque>
+#include <functional>
+#include <map>
+#include <set>
+#include <type_traits>
+#include <ygm/container/detail/flat_table.hpp>
+#include <ygm/container/detail/hash_table.hpp>
+#include <ygm/container/detail/key_hash.hpp>
+
+namespace ygm::container::detail {
+
+/**
+ * @brief Storage policy keeping each rank's local data in ordered trees
+ * (std::multimap / std::multiset).  Local iteration visits keys in Compare
+ * order.
+ */
+struct tree_storage {
+  template <typename Key, typename Value, typename Compare, typename Alloc>
+  using map_type = std::multimap<Key, Value, Compare, Alloc>;
+
+  template <typename Key, typename Compare, typename Alloc>
+  using set_type = std::multiset<Key, Compare, Alloc>;
+};
+
+/**
+ * @brief Storage policy keeping each rank's local data in open addressing
+ * hash tables.  Compare is ignored and local iteration order is unspecified.
+ */
+struct hash_storage {
+  template <typename Key, typename Value, typename Compare, typename Alloc>
+  using map_type = hash_multimap<Key, Value, local_key_hash<Key>,
+                                 std::equal_to<Key>, Alloc>;
+
+  template <typename Key, typename Compare, typename Alloc>
+  using set_type =
+      hash_multiset<Key, local_key_hash<Key>, std::equal_to<Key>, Alloc>;
+};
+
+/**
+ * @brief hash_storage whose containers carry the low 32 bits of each key's
+ * partitioning hash in their messages, so the owner picks the shard and
+ * probes its table without hashing the key again.  Requires the default
+ * hash_partitioner.
+ */
+struct carried_hash_storage : hash_storage {
+  static constexpr bool carry_hash = true;
+};
+
+template <typename Storage, typename = void>
+struct carries_hash : std::false_type {};
+
+template <typename Storage>
+struct carries_hash<Storage, std::void_t<decltype(Storage::carry_hash)>>
+    : std::bool_constant<Storage::carry_hash> {};
+
+/**
+ * @brief Whether local storage Map is ordered and can seek to a key.
+ */
+template <typename Map, typename = void>
+struct has_lower_bound : std::false_type {};
+
+template <typename Map>
+struct has_lower_bound<
+    Map, std::void_t<decltype(std::declval<Map &>().lower_bound(
+             std::declval<const typename Map::key_type &>()))>>
+    : std::true_type {};
+
+/**
+ * @brief Storage policy keeping each rank's local data in sorted flat arrays.
+ * Inserts are appended and merged in bulk on the next read, typically the
+ * for_all or query phase after a barrier, giving the smallest footprint for
+ * data that is built once and then read.  Lookups after each insert are
+ * expensive; prefer tree_storage or hash_storage for mixed workloads.
+ */
+struct flat_storage {
+  template <typename Key, typename Value, typename Compare, typename Alloc>
+  using map_type = flat_multimap<Key, Value, Compare, Alloc>;
+
+  template <typename Key, typename Compare, typename Alloc>
+  using set_type = flat_multiset<Key, Compare, Alloc>;
+};
+
+/**
+ * @brief Whether local storage Map moves its elements when it changes, as
+ * hash tables do when they grow and flat tables when they rebuild.
+ */
+template <typename Map>
+struct moves_elements : std::false_type {};
+
+template <typename... Params>
+struct moves_elements<open_hash_table<Params...>> : std::true_type {};
+
+template <typename... Params>
+struct moves_elements<flat_table<Params...>> : std::true_type {};
+
+/**
+ * @brief Operations held back from a shard while visitors hold references
+ * into it.  A visitor's own messages to the shard run immediately when the
+ * shard is local, so while it is pinned they are queued instead and run in
+ * arrival order once the last pin is released; later arrivals queue behind
+ * them until the queue drains.
+ */
+class shard_queue {
+ public:
+  class guard {
+   public:
+    explicit guard(shard_queue *queue) : m_queue(queue) {
+      if (m_queue) m_queue->m_pins++;
+    }
+    ~guard() {
+      if (m_queue) m_queue->unpin();
+    }
+    guard(const guard &) = delete;
+    guard &operator=(const guard &) = delete;
+
+   private:
+    shard_queue *m_queue;
+  };
+
+  bool busy() const { return m_pins > 0 || !m_ops.empty(); }
+
+  void defer(std::function<void()> op) { m_ops.push_back(std::move(op)); }
+
+ private:
+  void unpin() {
+    if (--m_pins > 0) return;
+    // An operation that pins and releases the shard drains the rest itself
+    while (m_pins == 0 && !m_ops.empty()) {
+      auto op = std::move(m_ops.front());
+      m_ops.pop_front();
+      op();
+    }
+  }
+
+  int                               m_pins = 0;
+  std::deque<std::function<void()>> m_ops;
+};
+
+/**
+ * @brief Inserts (key, value) unless key is already present, locating the
+ * position once.
+ *
+ * @return Iterator to the element with key and whether it was inserted
+ */
+template <typename Key, typename Value, typename Compare, typename Alloc>
+std::pair<typename std::multimap<Key, Value, Compare, Alloc>::iterator, bool>
+insert_unique(std::multimap<Key, Value, Compare, Alloc> &m, const Key &key,
+              const Value &value) {
+  auto itr = m.lower_bound(key);
+  if (itr != m.end() && !m.key_comp()(key, itr->first)) {
+    return {itr, false};
+  }
+  return {m.emplace_hint(itr, key, value), true};
+}
+
+template <typename Key, typename Value, typename... Params>
+auto insert_unique(open_hash_table<Key, std::pair<const Key, Value>,
+                                   Params...> &m,
+                   const Key &key, const Value &value) {
+  return m.try_emplace(key, value);
+}
+
+template <typename Key, typename Compare, typename Alloc>
+std::pair<typename std::multiset<Key, Compare, Alloc>::iterator, bool>
+insert_unique(std::multiset<Key, Compare, Alloc> &s, const Key &key) {
+  auto itr = s.lower_bound(key);
+  if (itr != s.end() && !s.key_comp()(key, *itr)) {
+    return {itr, false};
+  }
+  return {s.emplace_hint(itr, key), true};
+}
+
+template <typename Key, typename... Params>
+auto insert_unique(open_hash_table<Key, const Key, Params...> &s,
+                   const Key &key) {
+  return s.try_emplace(key);
+}
+
+template <typename Key, typename Value, typename... Params>
+auto insert_unique(flat_table<Key, std::pair<const Key, Value>, Params...> &m,
+                   const Key &key, const Value &value) {
+  return m.try_emplace(key, value);
+}
+
+template <typename Key, typename... Params>
+auto insert_unique(flat_table<Key, const Key, Params...> &s, const Key &key) {
+  return s.try_emplace(key);
+}
+
+/**
+ * @brief Sets the value of key, inserting it if absent.  Flat storage defers
+ * the lookup to its next rebuild.
+ */
+template <typename Map, typename Key, typename Value>
+void insert_or_assign(Map &m, const Key &key, const Value &value) {
+  auto [itr, inserted] = insert_unique(m, key, value);
+  if (!inserted) {
+    itr->second = value;
+  }
+}
+
+template <typename Key, typename Value, typename... Params>
+void insert_or_assign(
+    flat_table<Key, std::pair<const Key, Value>, Params...> &m, const Key &key,
+    const Value &value) {
+  m.assign(key, value);
+}
+
+/**
+ * @brief Inserts key into a set unless already present.  Flat storage defers
+ * the lookup to its next rebuild.
+ */
+template <typename Set, typename Key>
+void insert_if_absent(Set &s, const Key &key) {
+  insert_unique(s, key);
+}
+
+template <typename Key, typename... Params>
+void insert_if_absent(flat_table<Key, const Key, Params...> &s,
+                      const Key &key) {
+  s.insert_if_absent(key);
+}
+
+}  // namespace ygm::container::detail
@@ -0,0 +1,293 @@
+// Copyright 2019-2021 Lawrence Livermore National Security, LLC and other YGM
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <cereal/types/vector.hpp>
+#include <cstdint>
+#include <map>
+#include <unordered_map>
+#include <vector>
+#include <ygm/comm.hpp>
+#include <ygm/container/detail/hash_partitioner.hpp>
+#include <ygm/detail/ygm_ptr.hpp>
+#include <ygm/meta/functional.hpp>
+
+namespace ygm::container {
+
+/**
+ * @brief Distributed union-find.  Each item's parent and rank live on the
+ * item's owner.  Unions walk both items to their roots with messages and link
+ * by (rank, item) order, so parent chains always increase in that order and
+ * never form cycles, however unions interleave.  Each walk compresses the
+ * path it followed once it reaches the root.
+ *
+ * Items are added implicitly by the first union or find that names them.
+ */
+template <typename Item, typename Partitioner = detail::hash_partitioner<Item>>
+class disjoint_set {
+ public:
+  using self_type  = disjoint_set<Item, Partitioner>;
+  using value_type = Item;
+  using path_type  = std::vector<value_type>;
+
+  disjoint_set(ygm::comm &comm) : m_comm(comm), pthis(this) {
+    m_comm.barrier();
+  }
+
+  ~disjoint_set() { m_comm.barrier(); }
+
+  void async_union(const value_type &a, const value_type &b) {
+    m_comm.async(owner(a), walk_a_functor(), pthis, a, b, path_type());
+  }
+
+  /**
+   * @brief Calls visitor(item, root, args...) on the owner of item's root.
+   */
+  template <typename Visitor, typename... VisitorArgs>
+  void async_find(const value_type &item, Visitor visitor,
+                  const VisitorArgs &...args) {
+    m_comm.async(owner(item), find_functor<Visitor, VisitorArgs...>(), pthis,
+                 item, item, path_type(),
+                 std::forward<const VisitorArgs>(args)...);
+  }
+
+  /**
+   * @brief Collective lookup of the roots of items.
+   */
+  template <typename STLKeyContainer>
+  std::map<value_type, value_type> all_find(const STLKeyContainer &items) {
+    m_comm.barrier();
+    auto reply = [](auto pdset, int from, const value_type &item,
+                    const value_type &root, int requester) {
+      auto store = [](auto pcomm, int from, auto pdset,
+                      const value_type &item, const value_type &root) {
+        pdset->m_find_results[item] = root;
+      };
+      pdset->m_comm.async(requester, store, pdset, item, root);
+    };
+    for (const auto &item : items) {
+      async_find(item, reply, m_comm.rank());
+    }
+    m_comm.barrier();
+    std::map<value_type, value_type> to_return;
+    to_return.swap(m_find_results);
+    return to_return;
+  }
+
+  /**
+   * @brief Collectively points every item directly at its root by pointer
+   * jumping; O(log depth) rounds.
+   */
+  void all_compress() {
+    auto query = [](auto pcomm, int from, auto pdset,
+                    const value_type &parent, const value_type &child) {
+      value_type grandparent = pdset->m_local.at(parent).parent;
+      if (grandparent != parent) {
+        auto update = [](auto pcomm, int from, auto pdset,
+                         const value_type &child,
+                         const value_type &grandparent) {
+          pdset->m_local.at(child).parent = grandparent;
+          ++pdset->m_compress_updates;
+        };
+        pdset->m_comm.async(from, update, pdset, child, grandparent);
+      }
+    };
+
+    while (true) {
+      m_comm.barrier();
+      m_compress_updates = 0;
+      for (const auto &[item, node] : m_local) {
+        if (node.parent != item) {
+          m_comm.async(owner(node.parent), query, pthis, node.parent, item);
+        }
+      }
+      m_comm.barrier();
+      if (m_comm.all_reduce_sum(m_compress_updates) == 0) {
+        break;
+      }
+    }
+  }
+
+  /**
+   * @brief Calls fn(item, root) on every item, compressing first.
+   */
+  template <typename Function>
+  void for_all(Function fn) {
+    all_compress();
+    for (const auto &[item, node] : m_local) {
+      fn(item, node.parent);
+    }
+  }
+
+  size_t size() {
+    m_comm.barrier();
+    return m_comm.all_reduce_sum(m_local.size());
+  }
+
+  size_t num_sets() {
+    m_comm.barrier();
+    size_t local_roots{0};
+    for (const auto &[item, node] : m_local) {
+      if (node.parent == item) {
+        ++local_roots;
+      }
+    }
+    return m_comm.all_reduce_sum(local_roots);
+  }
+
+  void clear() {
+    m_comm.barrier();
+    m_local.clear();
+  }
+
+  int owner(const value_type &item) const {
+    auto [dest, bank] = partitioner(item, m_comm.size(), 1024);
+    return dest;
+  }
+
+  ygm::comm &comm() { return m_comm; }
+
+ private:
+  struct node_type {
+    value_type parent;
+    uint32_t   rank;
+  };
+
+  node_type &local_node(const value_type &item) {
+    return m_local.try_emplace(item, node_type{item, 0}).first->second;
+  }
+
+  static bool rank_less(uint32_t rank_a, const value_type &a, uint32_t rank_b,
+                        const value_type &b) {
+    return rank_a < rank_b || (rank_a == rank_b && a < b);
+  }
+
+  /**
+   * @brief Points each item on path except the last, whose parent already is
+   * root, at root.
+   */
+  void compress(const path_type &path, const value_type &root) {
+    auto set_parent = [](auto pcomm, int from, auto pdset,
+                         const value_type &item, const value_type &root) {
+      pdset->m_local.at(item).parent = root;
+    };
+    for (size_t i = 0; i + 1 < path.size(); ++i) {
+      m_comm.async(owner(path[i]), set_parent, pthis, path[i], root);
+    }
+  }
+
+  // Walks a to its root ra, then walks b carrying (ra, rank of ra)
+  struct walk_a_functor {
+    template <typename Comm, typename Ptr>
+    void operator()(Comm pcomm, int from, Ptr pdset, const value_type &a,
+                    const value_type &b, path_type path) const {
+      // Copy the node; sends may process messages that insert items
+      node_type node = pdset->local_node(a);
+      if (node.parent != a) {
+        path.push_back(a);
+        pdset->m_comm.async(pdset->owner(node.parent), walk_a_functor(),
+                            pdset, node.parent, b, path);
+      } else {
+        pdset->compress(path, a);
+        pdset->m_comm.async(pdset->owner(b), walk_b_functor(), pdset, b, a,
+                            node.rank, path_type());
+      }
+    }
+  };
+
+  // Walks b to its root rb and links the lower of ra and rb under the other
+  struct walk_b_functor {
+    template <typename Comm, typename Ptr>
+    void operator()(Comm pcomm, int from, Ptr pdset, const value_type &b,
+                    const value_type &ra, uint32_t rank_a,
+                    path_type path) const {
+      node_type node = pdset->local_node(b);
+      if (node.parent != b) {
+        path.push_back(b);
+        pdset->m_comm.async(pdset->owner(node.parent), walk_b_functor(),
+                            pdset, node.parent, ra, rank_a, path);
+        return;
+      }
+      // Link before sending anything, since sends may process messages that
+      // change b
+      bool link_here = b != ra && !rank_less(rank_a, ra, node.rank, b);
+      if (link_here) {
+        // ra's rank only grows, so ra stays above b in (rank, item) order
+        pdset->local_node(b).parent = ra;
+      }
+      pdset->compress(path, b);
+      if (b == ra) {
+        return;
+      }
+      if (!link_here) {
+        pdset->m_comm.async(pdset->owner(ra), link_functor(), pdset, ra, b,
+                            node.rank);
+      } else if (node.rank == rank_a) {
+        pdset->m_comm.async(pdset->owner(ra), bump_functor(), pdset, ra,
+                            rank_a);
+      }
+    }
+  };
+
+  // Links ra under rb if ra is still a root below rb, else retries the union
+  struct link_functor {
+    template <typename Comm, typename Ptr>
+    void operator()(Comm pcomm, int from, Ptr pdset, const value_type &ra,
+                    const value_type &rb, uint32_t rank_b) const {
+      auto &node = pdset->local_node(ra);
+      if (node.parent == ra && rank_less(node.rank, ra, rank_b, rb)) {
+        node.parent = rb;
+        if (node.rank == rank_b) {
+          pdset->m_comm.async(pdset->owner(rb), bump_functor(), pdset, rb,
+                              rank_b);
+        }
+      } else {
+        walk_a_functor()(pcomm, from, pdset, ra, rb, path_type());
+      }
+    }
+  };
+
+  // Union by rank: raises a root's rank after an equal-rank link
+  struct bump_functor {
+    template <typename Comm, typename Ptr>
+    void operator()(Comm pcomm, int from, Ptr pdset, const value_type &root,
+                    uint32_t rank) const {
+      auto &node = pdset->local_node(root);
+      if (node.parent == root && node.rank == rank) {
+        node.rank = rank + 1;
+      }
+    }
+  };
+
+  template <typename Visitor, typename... VisitorArgs>
+  struct find_functor {
+    template <typename Comm, typename Ptr>
+    void operator()(Comm pcomm, int from, Ptr pdset, const value_type &x,
+                    const value_type &item, path_type path,
+                    const VisitorArgs &...args) const {
+      value_type parent = pdset->local_node(x).parent;
+      if (parent != x) {
+        path.push_back(x);
+        pdset->m_comm.async(pdset->owner(parent), find_functor(), pdset,
+                            parent, item, path, args...);
+      } else {
+        pdset->compress(path, x);
+        Visitor *vis;
+        ygm::meta::apply_optional(*vis, std::make_tuple(pdset, from),
+                                  std::forward_as_tuple(item, x, args...));
+      }
+    }
+  };
+
+  Partitioner                               partitioner;
+  ygm::comm                                 m_comm;
+  std::unordered_map<value_type, node_type> m_local;
+  std::map<value_type, value_type>          m_find_results;
+  size_t                                    m_compress_updates = 0;
+  typename ygm::ygm_ptr<self_type>          pthis;
+};
+
+}  // namespace ygm::container
@@ -5,26 +5,43 @@
 
 #pragma once
 
+#include <ygm/container/detail/from_local.hpp>
+#include <ygm/container/detail/gather_future.hpp>
 #include <ygm/container/detail/map_impl.hpp>
 namespace ygm::container {
 
 template <typename Key, typename Value,
           typename Partitioner = detail::hash_partitioner<Key>,
           typename Compare = std::less<Key>,
-          class Alloc = std::allocator<std::pair<const Key, Value>>>
+          class Alloc = std::allocator<std::pair<const Key, Value>>,
+          typename Storage = detail::tree_storage>
 class map {
  public:
-  using self_type = map<Key, Value, Partitioner, Compare, Alloc>;
+  using self_type = map<Key, Value, Partitioner, Compare, Alloc, Storage>;
   using value_type = Value;
   using key_type = Key;
-  using impl_type =
-      detail::map_impl<key_type, value_type, Partitioner, Compare, Alloc>;
+  using impl_type = detail::map_impl<key_type, value_type, Partitioner,
+                                     Compare, Alloc, Storage>;
   map() = delete;
 
   map(ygm::comm& comm) : m_impl(comm) {}
 
   map(ygm::comm& comm, const value_type& dv) : m_impl(comm, dv) {}
 
+  map(ygm::comm& comm, const Partitioner& partitioner)
+      : m_impl(comm, partitioner) {}
+
+  // Keeps local data in per-rank memory-mapped files; needs an mmap_allocator
+  map(ygm::comm& comm, const detail::mmap_file& file) : m_impl(comm, file) {}
+
+  // Collectively builds the map from every rank's local range of pairs
+  template <typename InputIt>
+  map(ygm::comm& comm, from_local_t, InputIt first, InputIt last)
+      : m_impl(comm) {
+    async_insert_range(first, last);
+    m_impl.comm().barrier();
+  }
+
   void async_insert(const std::pair<key_type, value_type>& kv) {
     async_insert(kv.first, kv.second);
   }
@@ -36,6 +53,11 @@ class map {
     async_insert(key, value);
   }
 
+  template <typename InputIt>
+  void async_insert_range(InputIt first, InputIt last, bool combine = true) {
+    m_impl.async_insert_range(first, last, true, combine);
+  }
+
   template <typename Visitor, typename... VisitorArgs>
   void async_visit(const key_type& key, Visitor visitor,
                    const VisitorArgs&... args) {
@@ -49,6 +71,45 @@ class map {
                                  std::forward<const VisitorArgs>(args)...);
   }
 
+  template <typename ReductionOp>
+  void async_reduce(const key_type& key, const value_type& value,
+                    ReductionOp op) {
+    m_impl.async_reduce(key, value, op);
+  }
+
+  size_t reduce_buffer_capacity() const {
+    return m_impl.reduce_buffer_capacity();
+  }
+
+  void set_reduce_buffer_capacity(size_t capacity) {
+    m_impl.set_reduce_buffer_capacity(capacity);
+  }
+
+  double hot_key_fraction() const { return m_impl.hot_key_fraction(); }
+
+  void set_hot_key_fraction(double fraction) {
+    m_impl.set_hot_key_fraction(fraction);
+  }
+
+  std::vector<key_type> hot_keys() const { return m_impl.hot_keys(); }
+
+  // Visits every element with key in [lo, hi), contacting only the ranks
+  // that may own part of the range
+  template <typename Visitor, typename... VisitorArgs>
+  void async_visit_range(const key_type& lo, const key_type& hi,
+                         Visitor visitor, const VisitorArgs&... args) {
+    m_impl.async_visit_range(lo, hi, visitor,
+                             std::forward<const VisitorArgs>(args)...);
+  }
+
+  void repartition(const Partitioner& partitioner) {
+    m_impl.repartition(partitioner);
+  }
+
+  void rebalance(size_t samples_per_rank = 1024) {
+    m_impl.rebalance(samples_per_rank);
+  }
+
   void async_erase(const key_type& key) { m_impl.async_erase(key); }
 
   size_t local_count(const key_type& key) { return m_impl.local_count(key); }
@@ -70,6 +131,9 @@ class map {
 
   void serialize(const std::string& fname) { m_impl.serialize(fname); }
   void deserialize(const std::string& fname) { m_impl.deserialize(fname); }
+  void checkpoint(const std::string& fname) { m_impl.checkpoint(fname); }
+  void restore(const std::string& fname) { m_impl.restore(fname); }
+  void persist() { m_impl.persist(); }
 
   int owner(const key_type& key) const { return m_impl.owner(key); }
 
@@ -94,6 +158,14 @@ class map {
     return to_return;
   }
 
+  // Non-collective all_gather; get() on the result waits for the replies
+  template <typename STLKeyContainer>
+  auto async_gather(const STLKeyContainer& keys) {
+    using batch_type = typename impl_type::gather_batch_type;
+    return detail::gather_future<std::map<key_type, value_type>, batch_type>(
+        m_impl.async_gather(keys));
+  }
+
   ygm::comm& comm() { return m_impl.comm(); }
 
   template <typename CompareFunction>
@@ -102,6 +174,25 @@ class map {
     return m_impl.topk(k, cfn);
   }
 
+  // Collective exact selection of the element of global rank n under cfn
+  template <typename CompareFunction>
+  std::pair<key_type, value_type> nth_element(size_t n, CompareFunction cfn) {
+    return m_impl.nth_element(n, cfn);
+  }
+
+  // Collective exact quantile, q in [0, 1]
+  template <typename CompareFunction>
+  std::pair<key_type, value_type> quantile(double q, CompareFunction cfn) {
+    return m_impl.quantile(q, cfn);
+  }
+
+  // Collective approximate quantiles from mergeable per-rank sketches
+  template <typename CompareFunction>
+  std::vector<std::pair<key_type, value_type>> approx_quantiles(
+      const std::vector<double>& qs, CompareFunction cfn) {
+    return m_impl.approx_quantiles(qs, cfn);
+  }
+
  private:
   impl_type m_impl;
 };
@@ -109,20 +200,36 @@ class map {
 template <typename Key, typename Value,
           typename Partitioner = detail::hash_partitioner<Key>,
           typename Compare = std::less<Key>,
-          class Alloc = std::allocator<std::pair<const Key, Value>>>
+          class Alloc = std::allocator<std::pair<const Key, Value>>,
+          typename Storage = detail::tree_storage>
 class multimap {
  public:
-  using self_type = multimap<Key, Value, Partitioner, Compare, Alloc>;
+  using self_type = multimap<Key, Value, Partitioner, Compare, Alloc, Storage>;
   using value_type = Value;
   using key_type = Key;
-  using impl_type =
-      detail::map_impl<key_type, value_type, Partitioner, Compare, Alloc>;
+  using impl_type = detail::map_impl<key_type, value_type, Partitioner,
+                                     Compare, Alloc, Storage>;
   multimap() = delete;
 
   multimap(ygm::comm& comm) : m_impl(comm) {}
 
   multimap(ygm::comm& comm, const value_type& dv) : m_impl(comm, dv) {}
 
+  multimap(ygm::comm& comm, const Partitioner& partitioner)
+      : m_impl(comm, partitioner) {}
+
+  // Keeps local data in per-rank memory-mapped files; needs an mmap_allocator
+  multimap(ygm::comm& comm, const detail::mmap_file& file)
+      : m_impl(comm, file) {}
+
+  // Collectively builds the multimap from every rank's local range of pairs
+  template <typename InputIt>
+  multimap(ygm::comm& comm, from_local_t, InputIt first, InputIt last)
+      : m_impl(comm) {
+    async_insert_range(first, last);
+    m_impl.comm().barrier();
+  }
+
   void async_insert(const std::pair<key_type, value_type>& kv) {
     async_insert(kv.first, kv.second);
   }
@@ -130,6 +237,11 @@ class multimap {
     m_impl.async_insert_multi(key, value);
   }
 
+  template <typename InputIt>
+  void async_insert_range(InputIt first, InputIt last) {
+    m_impl.async_insert_range(first, last, false, false);
+  }
+
   template <typename Visitor, typename... VisitorArgs>
   void async_visit(const key_type& key, Visitor visitor,
                    const VisitorArgs&... args) {
@@ -143,6 +255,23 @@ class multimap {
                                  std::forward<const VisitorArgs>(args)...);
   }
 
+  // Visits every element with key in [lo, hi), contacting only the ranks
+  // that may own part of the range
+  template <typename Visitor, typename... VisitorArgs>
+  void async_visit_range(const key_type& lo, const key_type& hi,
+                         Visitor visitor, const VisitorArgs&... args) {
+    m_impl.async_visit_range(lo, hi, visitor,
+                             std::forward<const VisitorArgs>(args)...);
+  }
+
+  void repartition(const Partitioner& partitioner) {
+    m_impl.repartition(partitioner);
+  }
+
+  void rebalance(size_t samples_per_rank = 1024) {
+    m_impl.rebalance(samples_per_rank);
+  }
+
   void async_erase(const key_type& key) { m_impl.async_erase(key); }
 
   size_t local_count(const key_type& key) { return m_impl.local_count(key); }
@@ -164,6 +293,9 @@ class multimap {
 
   void serialize(const std::string& fname) { m_impl.serialize(fname); }
   void deserialize(const std::string& fname) { m_impl.deserialize(fname); }
+  void checkpoint(const std::string& fname) { m_impl.checkpoint(fname); }
+  void restore(const std::string& fname) { m_impl.restore(fname); }
+  void persist() { m_impl.persist(); }
 
   int owner(const key_type& key) const { return m_impl.owner(key); }
 
@@ -189,6 +321,14 @@ class multimap {
     return to_return;
   }
 
+  // Non-collective all_gather; get() on the result waits for the replies
+  template <typename STLKeyContainer>
+  auto async_gather(const STLKeyContainer& keys) {
+    using batch_type = typename impl_type::gather_batch_type;
+    return detail::gather_future<std::multimap<key_type, value_type>,
+                                 batch_type>(m_impl.async_gather(keys));
+  }
+
   ygm::comm& comm() { return m_impl.comm(); }
 
   template <typename CompareFunction>
@@ -197,6 +337,25 @@ class multimap {
     return m_impl.topk(k, cfn);
   }
 
+  // Collective exact selection of the element of global rank n under cfn
+  template <typename CompareFunction>
+  std::pair<key_type, value_type> nth_element(size_t n, CompareFunction cfn) {
+    return m_impl.nth_element(n, cfn);
+  }
+
+  // Collective exact quantile, q in [0, 1]
+  template <typename CompareFunction>
+  std::pair<key_type, value_type> quantile(double q, CompareFunction cfn) {
+    return m_impl.quantile(q, cfn);
+  }
+
+  // Collective approximate quantiles from mergeable per-rank sketches
+  template <typename CompareFunction>
+  std::vector<std::pair<key_type, value_type>> approx_quantiles(
+      const std::vector<double>& qs, CompareFunction cfn) {
+    return m_impl.approx_quantiles(qs, cfn);
+  }
+
  private:
   impl_type m_impl;
 };
@@ -0,0 +1,131 @@
+// Copyright 2019-2021 Lawrence Livermore National Security, LLC and other YGM
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <queue>
+#include <utility>
+#include <vector>
+#include <ygm/comm.hpp>
+#include <ygm/container/detail/hash_partitioner.hpp>
+#include <ygm/detail/ygm_ptr.hpp>
+
+namespace ygm::container {
+
+/**
+ * @brief Distributed priority queue for bucketed best-first algorithms such
+ * as delta-stepping.  Entries live in a min-heap on the owner of their item.
+ * Priorities are grouped into buckets of width delta, and pop_batch removes
+ * the globally lowest nonempty bucket, found with one min all_reduce.
+ * Priorities must be non-negative.
+ */
+template <typename Item, typename Priority = double,
+          typename Partitioner = detail::hash_partitioner<Item>>
+class priority_queue {
+ public:
+  using self_type     = priority_queue<Item, Priority, Partitioner>;
+  using value_type    = Item;
+  using priority_type = Priority;
+  using entry_type    = std::pair<priority_type, value_type>;
+
+  static constexpr uint64_t no_bucket = std::numeric_limits<uint64_t>::max();
+
+  priority_queue(ygm::comm &comm, priority_type delta)
+      : m_comm(comm), m_delta(delta), pthis(this) {
+    m_comm.barrier();
+  }
+
+  ~priority_queue() { m_comm.barrier(); }
+
+  /**
+   * @brief Pushes item with priority onto the heap of item's owner.
+   */
+  void async_push(const value_type &item, const priority_type &priority) {
+    int dest = owner(item);
+    if (dest == m_comm.rank()) {
+      local_push(item, priority);
+    } else {
+      auto pusher = [](auto pcomm, int from, auto ppq, const value_type &item,
+                       const priority_type &priority) {
+        ppq->local_push(item, priority);
+      };
+      m_comm.async(dest, pusher, pthis, item, priority);
+    }
+  }
+
+  void local_push(const value_type &item, const priority_type &priority) {
+    m_heap.emplace(priority, item);
+  }
+
+  /**
+   * @brief Collectively removes every entry in the lowest nonempty bucket.
+   * Each rank receives the entries it owns, in priority order.  All ranks get
+   * an empty batch once the queue is empty.
+   */
+  std::vector<std::pair<value_type, priority_type>> pop_batch() {
+    m_comm.barrier();
+    uint64_t local_bucket = m_heap.empty() ? no_bucket : bucket(m_heap.top());
+    // Merge-based reduction; some MPIs mishandle MPI_MIN on unsigned long
+    m_current_bucket = m_comm.all_reduce(
+        local_bucket, [](uint64_t a, uint64_t b) { return std::min(a, b); });
+
+    std::vector<std::pair<value_type, priority_type>> to_return;
+    while (!m_heap.empty() && bucket(m_heap.top()) == m_current_bucket) {
+      to_return.emplace_back(m_heap.top().second, m_heap.top().first);
+      m_heap.pop();
+    }
+    return to_return;
+  }
+
+  /**
+   * @brief Bucket returned by the last pop_batch, or no_bucket.
+   */
+  uint64_t current_bucket() const { return m_current_bucket; }
+
+  bool empty() {
+    m_comm.barrier();
+    return m_comm.all_reduce_max(m_heap.size()) == 0;
+  }
+
+  size_t size() {
+    m_comm.barrier();
+    return m_comm.all_reduce_sum(m_heap.size());
+  }
+
+  size_t local_size() const { return m_heap.size(); }
+
+  int owner(const value_type &item) const {
+    auto [dest, bank] = partitioner(item, m_comm.size(), 1024);
+    return dest;
+  }
+
+  ygm::comm &comm() { return m_comm; }
+
+ private:
+  uint64_t bucket(const entry_type &e) const { return e.first / m_delta; }
+
+  // Orders only by priority so items need no operator<
+  struct entry_greater {
+    bool operator()(const entry_type &a, const entry_type &b) const {
+      return a.first > b.first;
+    }
+  };
+
+  using heap_type =
+      std::priority_queue<entry_type, std::vector<entry_type>, entry_greater>;
+
+  Partitioner                      partitioner;
+  ygm::comm                        m_comm;
+  priority_type                    m_delta;
+  uint64_t                         m_current_bucket = no_bucket;
+  heap_type                        m_heap;
+  typename ygm::ygm_ptr<self_type> pthis;
+};
+
+}  // namespace ygm::container
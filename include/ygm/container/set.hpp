@@ -4,18 +4,21 @@
 // SPDX-License-Identifier: MIT
 
 #pragma once
+#include <ygm/container/detail/from_local.hpp>
 #include <ygm/container/detail/set_impl.hpp>
 
 namespace ygm::container {
 
 template <typename Key, typename Partitioner = detail::hash_partitioner<Key>,
           typename Compare = std::less<Key>,
-          class Alloc = std::allocator<const Key>>
+          class Alloc = std::allocator<const Key>,
+          typename Storage = detail::tree_storage>
 class multiset {
  public:
-  using self_type = multiset<Key, Partitioner, Compare, Alloc>;
+  using self_type = multiset<Key, Partitioner, Compare, Alloc, Storage>;
   using key_type = Key;
-  using impl_type = detail::set_impl<key_type, Partitioner, Compare, Alloc>;
+  using impl_type =
+      detail::set_impl<key_type, Partitioner, Compare, Alloc, Storage>;
 
   Partitioner partitioner;
 
@@ -23,8 +26,25 @@ class multiset {
 
   multiset(ygm::comm& comm) : m_impl(comm) {}
 
+  // Keeps local data in per-rank memory-mapped files; needs an mmap_allocator
+  multiset(ygm::comm& comm, const detail::mmap_file& file)
+      : m_impl(comm, file) {}
+
+  // Collectively builds the multiset from every rank's local range of keys
+  template <typename InputIt>
+  multiset(ygm::comm& comm, from_local_t, InputIt first, InputIt last)
+      : m_impl(comm) {
+    async_insert_range(first, last);
+    m_impl.comm().barrier();
+  }
+
   void async_insert(const key_type& key) { m_impl.async_insert_multi(key); }
 
+  template <typename InputIt>
+  void async_insert_range(InputIt first, InputIt last) {
+    m_impl.async_insert_range(first, last, false, false);
+  }
+
   void async_erase(const key_type& key) { m_impl.async_erase(key); }
 
   template <typename Function>
@@ -42,6 +62,9 @@ class multiset {
 
   void serialize(const std::string& fname) { m_impl.serialize(fname); }
   void deserialize(const std::string& fname) { m_impl.deserialize(fname); }
+  void checkpoint(const std::string& fname) { m_impl.checkpoint(fname); }
+  void restore(const std::string& fname) { m_impl.restore(fname); }
+  void persist() { m_impl.persist(); }
 
   typename ygm::ygm_ptr<self_type> get_ygm_ptr() const {
     return m_impl.get_ygm_ptr();
@@ -59,12 +82,14 @@ class multiset {
 };
 template <typename Key, typename Partitioner = detail::hash_partitioner<Key>,
           typename Compare = std::less<Key>,
-          class Alloc = std::allocator<const Key>>
+          class Alloc = std::allocator<const Key>,
+          typename Storage = detail::tree_storage>
 class set {
  public:
-  using self_type = set<Key, Partitioner, Compare, Alloc>;
+  using self_type = set<Key, Partitioner, Compare, Alloc, Storage>;
   using key_type = Key;
-  using impl_type = detail::set_impl<key_type, Partitioner, Compare, Alloc>;
+  using impl_type =
+      detail::set_impl<key_type, Partitioner, Compare, Alloc, Storage>;
 
   Partitioner partitioner;
 
@@ -72,8 +97,24 @@ class set {
 
   set(ygm::comm& comm) : m_impl(comm) {}
 
+  // Keeps local data in per-rank memory-mapped files; needs an mmap_allocator
+  set(ygm::comm& comm, const detail::mmap_file& file) : m_impl(comm, file) {}
+
+  // Collectively builds the set from every rank's local range of keys
+  template <typename InputIt>
+  set(ygm::comm& comm, from_local_t, InputIt first, InputIt last)
+      : m_impl(comm) {
+    async_insert_range(first, last);
+    m_impl.comm().barrier();
+  }
+
   void async_insert(const key_type& key) { m_impl.async_insert_unique(key); }
 
+  template <typename InputIt>
+  void async_insert_range(InputIt first, InputIt last, bool combine = true) {
+    m_impl.async_insert_range(first, last, true, combine);
+  }
+
   void async_erase(const key_type& key) { m_impl.async_erase(key); }
 
   template <typename Function>
@@ -91,6 +132,9 @@ class set {
 
   void serialize(const std::string& fname) { m_impl.serialize(fname); }
   void deserialize(const std::string& fname) { m_impl.deserialize(fname); }
+  void checkpoint(const std::string& fname) { m_impl.checkpoint(fname); }
+  void restore(const std::string& fname) { m_impl.restore(fname); }
+  void persist() { m_impl.persist(); }
 
   typename ygm::ygm_ptr<self_type> get_ygm_ptr() const {
     return m_impl.get_ygm_ptr();
@@ -0,0 +1,251 @@
+// Copyright 2019-2021 Lawrence Livermore National Security, LLC and other YGM
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <algorithm>
+#include <cereal/types/tuple.hpp>
+#include <cereal/types/vector.hpp>
+#include <tuple>
+#include <vector>
+#include <ygm/comm.hpp>
+#include <ygm/detail/ygm_ptr.hpp>
+#include <ygm/meta/functional.hpp>
+
+namespace ygm::container {
+
+/**
+ * @brief Immutable, globally sorted array distributed in contiguous blocks:
+ * rank r holds global indices [offset(r), offset(r + 1)).  Built collectively
+ * by a sample sort of items held on each rank, e.g. by bag::sort.
+ */
+template <typename Item, typename Compare = std::less<Item>>
+class sorted_array {
+ public:
+  using self_type  = sorted_array<Item, Compare>;
+  using value_type = Item;
+
+  /**
+   * @brief Collectively sample sorts the union of every rank's local_items.
+   */
+  sorted_array(ygm::comm &comm, std::vector<value_type> local_items,
+               Compare cfn = Compare())
+      : m_comm(comm), m_cfn(cfn), pthis(this) {
+    m_comm.barrier();
+    sample_sort(std::move(local_items));
+  }
+
+  ~sorted_array() { m_comm.barrier(); }
+
+  size_t size() const { return m_offsets.back(); }
+
+  size_t local_size() const { return m_local.size(); }
+
+  /**
+   * @brief Global index of this rank's first element.
+   */
+  size_t local_offset() const { return m_offsets[m_comm.rank()]; }
+
+  int owner(size_t index) const {
+    return std::upper_bound(m_offsets.begin(), m_offsets.end(), index) -
+           m_offsets.begin() - 1;
+  }
+
+  bool is_mine(size_t index) const { return owner(index) == m_comm.rank(); }
+
+  const value_type &local_at(size_t index) const {
+    return m_local[index - local_offset()];
+  }
+
+  /**
+   * @brief Calls visitor(index, value, args...) on the owner of index.
+   */
+  template <typename Visitor, typename... VisitorArgs>
+  void async_visit(size_t index, Visitor visitor,
+                   const VisitorArgs &...args) {
+    auto visit_wrapper = [](auto pcomm, int from, auto parr, size_t index,
+                            const VisitorArgs &...args) {
+      Visitor *vis;
+      ygm::meta::apply_optional(
+          *vis, std::make_tuple(parr, from),
+          std::forward_as_tuple(index, parr->local_at(index), args...));
+    };
+    m_comm.async(owner(index), visit_wrapper, pthis, index,
+                 std::forward<const VisitorArgs>(args)...);
+  }
+
+  /**
+   * @brief Collective count of elements ordered before value.
+   */
+  size_t lower_bound(const value_type &value) {
+    m_comm.barrier();
+    size_t local = std::lower_bound(m_local.begin(), m_local.end(), value,
+                                    m_cfn) -
+                   m_local.begin();
+    return m_comm.all_reduce_sum(local);
+  }
+
+  /**
+   * @brief Collective count of elements not ordered after value.
+   */
+  size_t upper_bound(const value_type &value) {
+    m_comm.barrier();
+    size_t local = std::upper_bound(m_local.begin(), m_local.end(), value,
+                                    m_cfn) -
+                   m_local.begin();
+    return m_comm.all_reduce_sum(local);
+  }
+
+  /**
+   * @brief Calls fn(index, value) on every element, in order on each rank.
+   */
+  template <typename Function>
+  void for_all(Function fn) {
+    m_comm.barrier();
+    local_for_all(fn);
+  }
+
+  template <typename Function>
+  void local_for_all(Function fn) {
+    size_t index = local_offset();
+    for (const auto &value : m_local) {
+      fn(index++, value);
+    }
+  }
+
+  ygm::comm &comm() { return m_comm; }
+
+ private:
+  // Samples carry their origin (rank, local index) so that runs of equal
+  // items can still be split across ranks.
+  using sample_type = std::tuple<value_type, int, size_t>;
+
+  static constexpr size_t samples_per_rank = 64;
+
+  bool sample_less(const sample_type &a, const sample_type &b) const {
+    if (m_cfn(std::get<0>(a), std::get<0>(b))) return true;
+    if (m_cfn(std::get<0>(b), std::get<0>(a))) return false;
+    return std::tie(std::get<1>(a), std::get<2>(a)) <
+           std::tie(std::get<1>(b), std::get<2>(b));
+  }
+
+  /**
+   * @brief Number of sorted local items ordered before splitter s.
+   */
+  size_t count_less(const std::vector<value_type> &sorted,
+                    const sample_type   &s) const {
+    const auto &value = std::get<0>(s);
+    size_t lb = std::lower_bound(sorted.begin(), sorted.end(), value, m_cfn) -
+                sorted.begin();
+    size_t ub = std::upper_bound(sorted.begin() + lb, sorted.end(), value,
+                                 m_cfn) -
+                sorted.begin();
+    if (m_comm.rank() < std::get<1>(s)) return ub;
+    if (m_comm.rank() > std::get<1>(s)) return lb;
+    return std::clamp(std::get<2>(s), lb, ub);
+  }
+
+  void sample_sort(std::vector<value_type> items) {
+    int nranks = m_comm.size();
+    std::sort(items.begin(), items.end(), m_cfn);
+
+    // Regular samples of the local data, merged into a global sorted sample
+    std::vector<sample_type> samples;
+    size_t num_samples = std::min(items.size(), samples_per_rank);
+    for (size_t i = 0; i < num_samples; ++i) {
+      size_t idx = (2 * i + 1) * items.size() / (2 * num_samples);
+      samples.emplace_back(items[idx], m_comm.rank(), idx);
+    }
+    samples = m_comm.all_reduce(samples, [this](const auto &a, const auto &b) {
+      std::vector<sample_type> out;
+      out.reserve(a.size() + b.size());
+      std::merge(a.begin(), a.end(), b.begin(), b.end(),
+                 std::back_inserter(out),
+                 [this](const auto &x, const auto &y) {
+                   return sample_less(x, y);
+                 });
+      return out;
+    });
+
+    // Destination d receives local items [bounds[d], bounds[d + 1])
+    std::vector<size_t> bounds(nranks + 1, 0);
+    for (int d = 1; d < nranks; ++d) {
+      bounds[d] = samples.empty()
+                      ? 0
+                      : count_less(items, samples[d * samples.size() / nranks]);
+    }
+    bounds[nranks] = items.size();
+
+    auto receiver = [](auto pcomm, int from, auto parr,
+                       const std::vector<value_type> &run) {
+      parr->m_run_starts.push_back(parr->m_local.size());
+      parr->m_local.insert(parr->m_local.end(), run.begin(), run.end());
+    };
+
+    size_t batch_size = std::max<size_t>(
+        1, m_comm.buffer_capacity() / (2 * sizeof(value_type)));
+    m_run_starts.push_back(m_local.size());
+    m_local.insert(m_local.end(), items.begin() + bounds[m_comm.rank()],
+                   items.begin() + bounds[m_comm.rank() + 1]);
+    for (int i = 1; i < nranks; ++i) {
+      int dest = (m_comm.rank() + i) % nranks;
+      for (size_t b = bounds[dest]; b < bounds[dest + 1]; b += batch_size) {
+        std::vector<value_type> run(
+            items.begin() + b,
+            items.begin() + std::min(bounds[dest + 1], b + batch_size));
+        m_comm.async(dest, receiver, pthis, run);
+      }
+    }
+    std::vector<value_type>().swap(items);
+    m_comm.barrier();
+
+    merge_runs();
+
+    std::vector<size_t> sizes(nranks, 0);
+    sizes[m_comm.rank()] = m_local.size();
+    sizes = m_comm.all_reduce(sizes, [](const auto &a, const auto &b) {
+      std::vector<size_t> out(a);
+      for (size_t i = 0; i < out.size(); ++i) out[i] += b[i];
+      return out;
+    });
+    m_offsets.assign(nranks + 1, 0);
+    for (int r = 0; r < nranks; ++r) {
+      m_offsets[r + 1] = m_offsets[r] + sizes[r];
+    }
+  }
+
+  /**
+   * @brief Bottom-up pairwise merge of the sorted runs received.
+   */
+  void merge_runs() {
+    std::vector<size_t> bounds(m_run_starts);
+    bounds.push_back(m_local.size());
+    while (bounds.size() > 2) {
+      size_t              runs = bounds.size() - 1;
+      std::vector<size_t> next;
+      for (size_t i = 0; i + 1 < runs; i += 2) {
+        std::inplace_merge(m_local.begin() + bounds[i],
+                           m_local.begin() + bounds[i + 1],
+                           m_local.begin() + bounds[i + 2], m_cfn);
+        next.push_back(bounds[i]);
+      }
+      if (runs % 2 == 1) {
+        next.push_back(bounds[runs - 1]);
+      }
+      next.push_back(bounds[runs]);
+      bounds.swap(next);
+    }
+    std::vector<size_t>().swap(m_run_starts);
+  }
+
+  ygm::comm                        m_comm;
+  Compare                          m_cfn;
+  std::vector<value_type>          m_local;
+  std::vector<size_t>              m_run_starts;
+  std::vector<size_t>              m_offsets;
+  typename ygm::ygm_ptr<self_type> pthis;
+};
+
+}  // namespace ygm::container
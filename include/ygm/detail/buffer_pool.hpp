@@ -0,0 +1,217 @@
+// Copyright 2019-2021 Lawrence Livermore National Security, LLC and other YGM
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <sys/mman.h>
+#include <algorithm>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <vector>
+#include <ygm/detail/assert.hpp>
+
+namespace ygm::detail {
+
+/**
+ * @brief Fixed-capacity message buffer.  Buffers are owned by a buffer_pool
+ * and passed around as raw handles; the free list is threaded through the
+ * buffers themselves.
+ */
+class comm_buffer {
+ public:
+  char       *data() { return m_data; }
+  const char *data() const { return m_data; }
+  size_t      size() const { return m_size; }
+  size_t      capacity() const { return m_capacity; }
+  bool        empty() const { return m_size == 0; }
+
+  void clear() { m_size = 0; }
+
+  void resize(size_t size) {
+    ASSERT_RELEASE(size <= m_capacity);
+    m_size = size;
+  }
+
+  void append(const char *src, size_t count) {
+    ASSERT_DEBUG(m_size + count <= m_capacity);
+    std::memcpy(m_data + m_size, src, count);
+    m_size += count;
+  }
+
+ private:
+  friend class buffer_pool;
+
+  char        *m_data     = nullptr;
+  size_t       m_size     = 0;
+  size_t       m_capacity = 0;
+  bool         m_pooled   = false;
+  comm_buffer *m_next     = nullptr;
+};
+
+/**
+ * @brief Slab allocator for comm_buffers.  Buffers of the comm's capacity are
+ * carved out of large anonymous mappings that are first touched by the
+ * allocating thread, keeping them local to the rank's NUMA domain.  Define
+ * YGM_USE_HUGE_PAGES to back slabs with explicit huge pages; otherwise
+ * transparent huge pages are requested where available.  Larger one-off
+ * buffers (large messages) are heap allocated and released on free.
+ */
+class buffer_pool {
+ public:
+  buffer_pool(size_t buffer_capacity) : m_buffer_capacity(buffer_capacity) {
+    m_buffers_per_slab = std::max(size_t(1), slab_bytes / m_buffer_capacity);
+  }
+
+  ~buffer_pool() {
+    for (auto &slab : m_slabs) {
+      munmap(slab.first, slab.second);
+    }
+  }
+
+  buffer_pool(const buffer_pool &) = delete;
+  buffer_pool &operator=(const buffer_pool &) = delete;
+
+  /**
+   * @brief Allocates a buffer of the pool's capacity.  Thread safe.
+   */
+  comm_buffer *allocate() {
+    std::scoped_lock lock(m_mutex);
+    if (m_free_list == nullptr) {
+      ++m_misses;
+      allocate_slab();
+    } else {
+      ++m_hits;
+    }
+    comm_buffer *to_return = m_free_list;
+    m_free_list            = to_return->m_next;
+    to_return->m_next      = nullptr;
+    to_return->m_size      = 0;
+    add_bytes_in_use(m_buffer_capacity);
+    return to_return;
+  }
+
+  /**
+   * @brief Allocates a buffer of arbitrary capacity outside of the slabs.
+   * Thread safe.
+   */
+  comm_buffer *allocate_large(size_t capacity) {
+    comm_buffer *to_return = new comm_buffer();
+    to_return->m_data      = new char[capacity];
+    to_return->m_capacity  = capacity;
+    std::scoped_lock lock(m_mutex);
+    add_bytes_in_use(capacity);
+    return to_return;
+  }
+
+  /**
+   * @brief Returns a buffer to the pool, or releases it if it was allocated
+   * with allocate_large().  Thread safe.
+   */
+  void free(comm_buffer *b) {
+    if (!b->m_pooled) {
+      std::scoped_lock lock(m_mutex);
+      m_bytes_in_use -= b->m_capacity;
+      delete[] b->m_data;
+      delete b;
+      return;
+    }
+    b->m_size = 0;
+    std::scoped_lock lock(m_mutex);
+    m_bytes_in_use -= m_buffer_capacity;
+    b->m_next   = m_free_list;
+    m_free_list = b;
+  }
+
+  // Counters are updated under m_mutex by whichever thread allocates or
+  // frees, so reads take it too
+  int64_t hits() const {
+    std::scoped_lock lock(m_mutex);
+    return m_hits;
+  }
+  int64_t misses() const {
+    std::scoped_lock lock(m_mutex);
+    return m_misses;
+  }
+  int64_t bytes_in_use() const {
+    std::scoped_lock lock(m_mutex);
+    return m_bytes_in_use;
+  }
+  int64_t peak_bytes_in_use() const {
+    std::scoped_lock lock(m_mutex);
+    return m_peak_bytes_in_use;
+  }
+  int64_t reserved_bytes() const {
+    std::scoped_lock lock(m_mutex);
+    return m_reserved_bytes;
+  }
+
+  void reset_counters() {
+    std::scoped_lock lock(m_mutex);
+    m_hits              = 0;
+    m_misses            = 0;
+    m_peak_bytes_in_use = m_bytes_in_use;
+  }
+
+ private:
+  static constexpr size_t slab_bytes = 2 * 1024 * 1024;
+
+  void add_bytes_in_use(size_t bytes) {
+    m_bytes_in_use += bytes;
+    m_peak_bytes_in_use = std::max(m_peak_bytes_in_use, m_bytes_in_use);
+  }
+
+  /**
+   * @brief Maps a new slab and pushes its buffers onto the free list.  Called
+   * with m_mutex held.
+   */
+  void allocate_slab() {
+    size_t length = m_buffers_per_slab * m_buffer_capacity;
+    void  *slab   = MAP_FAILED;
+#if defined(YGM_USE_HUGE_PAGES) && defined(MAP_HUGETLB)
+    slab = mmap(nullptr, length, PROT_READ | PROT_WRITE,
+                MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+#endif
+    if (slab == MAP_FAILED) {
+      slab = mmap(nullptr, length, PROT_READ | PROT_WRITE,
+                  MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+      ASSERT_RELEASE(slab != MAP_FAILED);
+#if defined(MADV_HUGEPAGE)
+      madvise(slab, length, MADV_HUGEPAGE);
+#endif
+    }
+    // First touch from this rank places the pages in its NUMA domain
+    std::memset(slab, 0, length);
+    m_slabs.emplace_back(slab, length);
+    m_reserved_bytes += length;
+
+    char *base = reinterpret_cast<char *>(slab);
+    for (size_t i = 0; i < m_buffers_per_slab; ++i) {
+      m_headers.emplace_back();
+      comm_buffer &b = m_headers.back();
+      b.m_data       = base + i * m_buffer_capacity;
+      b.m_capacity   = m_buffer_capacity;
+      b.m_pooled     = true;
+      b.m_next       = m_free_list;
+      m_free_list    = &b;
+    }
+  }
+
+  size_t m_buffer_capacity;
+  size_t m_buffers_per_slab;
+
+  mutable std::mutex                     m_mutex;
+  comm_buffer                           *m_free_list = nullptr;
+  std::deque<comm_buffer>                m_headers;
+  std::vector<std::pair<void *, size_t>> m_slabs;
+
+  int64_t m_hits              = 0;
+  int64_t m_misses            = 0;
+  int64_t m_bytes_in_use      = 0;
+  int64_t m_peak_bytes_in_use = 0;
+  int64_t m_reserved_bytes    = 0;
+};
+
+}  // namespace ygm::detail
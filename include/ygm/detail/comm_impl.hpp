@@ -5,13 +5,21 @@
 
 #pragma once
 
+#include <algorithm>
 #include <atomic>
 #include <deque>
 #include <memory>
 #include <mutex>
 #include <thread>
+#include <unordered_map>
 #include <vector>
 
+#include <ygm/detail/buffer_pool.hpp>
+#include <ygm/detail/future.hpp>
+#include <ygm/detail/handler_pool.hpp>
+#if defined(__cpp_impl_coroutine)
+#include <ygm/detail/coroutine.hpp>
+#endif
 #include <ygm/detail/mpi.hpp>
 #include <ygm/detail/ygm_cereal_archive.hpp>
 #include <ygm/meta/functional.hpp>
@@ -20,7 +28,8 @@ namespace ygm {
 
 class comm::impl {
  public:
-  impl(MPI_Comm c, int buffer_capacity) {
+  impl(MPI_Comm c, int buffer_capacity, size_t credit_budget)
+      : m_buffer_pool(buffer_capacity) {
     ASSERT_MPI(MPI_Comm_dup(c, &m_comm_async));
     ASSERT_MPI(MPI_Comm_dup(c, &m_comm_barrier));
     ASSERT_MPI(MPI_Comm_dup(c, &m_comm_other));
@@ -28,11 +37,26 @@ class comm::impl {
     ASSERT_MPI(MPI_Comm_rank(m_comm_async, &m_comm_rank));
     m_buffer_capacity = buffer_capacity;
 
+    // Credits must cover at least two full buffers so that a sender starved of
+    // credits always has enough outstanding bytes to trigger a return.
+    m_credit_budget = credit_budget;
+    if (m_credit_budget == 0) {
+      m_credit_budget = 8 * m_buffer_capacity;
+    }
+    m_credit_budget = std::max(m_credit_budget, 2 * m_buffer_capacity);
+
     // Allocate send buffers
     for (int i = 0; i < m_comm_size; ++i) {
       m_vec_send_buffers.push_back(allocate_buffer());
     }
 
+    // Initialize flow control credits
+    m_send_credits = std::make_unique<std::atomic<int64_t>[]>(m_comm_size);
+    for (int i = 0; i < m_comm_size; ++i) {
+      m_send_credits[i] = m_credit_budget;
+    }
+    m_credits_to_return.resize(m_comm_size, 0);
+
     // launch listener thread
     m_listener = std::thread(&impl::listen, this);
   }
@@ -43,6 +67,10 @@ class comm::impl {
     MPI_Send(NULL, 0, MPI_BYTE, m_comm_rank, 0, m_comm_async);
     // Join listener thread.
     m_listener.join();
+    // Return send buffers to the pool before it is destroyed.
+    for (auto buffer : m_vec_send_buffers) {
+      free_buffer(buffer);
+    }
     // Free cloned communicator.
     ASSERT_RELEASE(MPI_Barrier(m_comm_async) == MPI_SUCCESS);
     MPI_Comm_free(&m_comm_async);
@@ -50,40 +78,107 @@ class comm::impl {
     MPI_Comm_free(&m_comm_other);
   }
 
-  int size() const { return m_comm_size; }
-  int rank() const { return m_comm_rank; }
+  int    size() const { return m_comm_size; }
+  int    rank() const { return m_comm_rank; }
+  size_t buffer_capacity() const { return m_buffer_capacity; }
+  MPI_Comm get_mpi_comm() const { return m_comm_other; }
 
   template <typename... SendArgs>
   void async(int dest, const SendArgs &... args) {
     ASSERT_DEBUG(dest < m_comm_size);
-    if (dest == m_comm_rank) {
+    if (t_staged_messages != nullptr) {
+      // Called from a handler thread, sent once the phase completes
+      t_staged_messages->emplace_back(
+          dest, pack_lambda(std::forward<const SendArgs>(args)...));
+      return;
+    }
+    if (dest == m_comm_rank &&
+        m_process_depth < m_max_process_depth) {
       local_receive(std::forward<const SendArgs>(args)...);
     } else {
-      m_send_count++;
-      std::vector<char> data =
-          pack_lambda(std::forward<const SendArgs>(args)...);
-      m_local_bytes_sent += data.size();
-
-      if (data.size() < m_buffer_capacity) {
-        // check if buffer doesn't have enough space
-        if (data.size() + m_vec_send_buffers[dest]->size() >
-            m_buffer_capacity) {
-          async_flush(dest);
-        }
-
-        // add data to the to dest buffer
-        m_vec_send_buffers[dest]->insert(m_vec_send_buffers[dest]->end(),
-                                         data.begin(), data.end());
-      } else {  // Large message
-        send_large_message(data, dest);
-      }
+      send_packed(dest, pack_lambda(std::forward<const SendArgs>(args)...));
     }
     // check if listener has queued receives to process
-    if (receive_queue_peek_size() > 0) {
+    if (m_process_depth < m_max_process_depth && local_work_pending()) {
       receive_queue_process();
     }
   }
 
+  /**
+   * @brief Sends a message tagged with a shard.  When handler threads are
+   * enabled, the receiver executes it on the thread owning the shard,
+   * concurrently with messages for other shards.
+   */
+  template <typename AsyncFunction, typename... SendArgs>
+  void async_sharded(int dest, uint32_t shard, AsyncFunction fn,
+                     const SendArgs &... args) {
+    if (!m_handler_pool) {
+      async(dest, fn, std::forward<const SendArgs>(args)...);
+      return;
+    }
+    auto envelope = [](impl *pimpl, int from, uint32_t shard,
+                       const std::vector<char> &msg) {
+      pimpl->queue_sharded(from, shard, msg);
+    };
+    async(dest, envelope, shard,
+          pack_lambda(fn, std::forward<const SendArgs>(args)...));
+  }
+
+  int handler_threads() const {
+    return m_handler_pool ? m_handler_pool->size() : 0;
+  }
+
+  void set_handler_threads(int num_threads) {
+    barrier();
+    m_handler_pool.reset();
+    m_sharded_batches.clear();
+    m_staged_messages.clear();
+    if (num_threads > 0) {
+      m_handler_pool = std::make_unique<detail::handler_pool>(num_threads);
+      m_sharded_batches.resize(num_threads);
+      m_staged_messages.resize(num_threads);
+    }
+    barrier();
+  }
+
+  template <typename AsyncFunction, typename... SendArgs>
+  auto async_call(int dest, AsyncFunction fn, const SendArgs &... args) {
+    using result_type = std::decay_t<decltype(ygm::meta::apply_optional(
+        fn, std::make_tuple(this, dest), std::make_tuple(args...)))>;
+    static_assert(!std::is_void<result_type>::value,
+                  "async_call requires a function returning a value");
+
+    auto     state = std::make_shared<detail::call_state<result_type>>();
+    uint64_t id    = m_next_call_id++;
+    m_pending_calls[id] = state;
+
+    auto caller = [](impl *pimpl, int from, uint64_t id,
+                     const SendArgs &... args) {
+      AsyncFunction *pfn;
+      result_type    result = ygm::meta::apply_optional(
+          *pfn, std::make_tuple(pimpl, from), std::forward_as_tuple(args...));
+      auto replier = [](impl *pimpl, int from, uint64_t id,
+                        const result_type &result) {
+        pimpl->resolve_call(id, result);
+      };
+      pimpl->async(from, replier, id, result);
+    };
+    async(dest, caller, id, std::forward<const SendArgs>(args)...);
+
+    return future<result_type>(this, state);
+  }
+
+  /**
+   * @brief Flushes all send buffers and processes received messages.  Used
+   * to make progress while waiting on a future.
+   */
+  void progress() {
+    async_flush_all();
+    if (!receive_queue_process()) {
+      std::this_thread::yield();
+    }
+  }
+
   // //
   // // Blocking barrier
   // void barrier() {
@@ -107,6 +202,7 @@ class comm::impl {
   void wait_local_idle() {
     receive_queue_process();
     do {
+      run_pre_barrier_callbacks();
       async_flush_all();
       std::this_thread::yield();
     } while (receive_queue_process());
@@ -117,7 +213,9 @@ class comm::impl {
       wait_local_idle();
       MPI_Request req = MPI_REQUEST_NULL;
       int64_t     first_all_count{-1};
-      int64_t     first_local_count = m_send_count - m_recv_count;
+      int64_t     first_send_count  = m_send_count;
+      int64_t     first_recv_count  = m_recv_count;
+      int64_t     first_local_count = first_send_count - first_recv_count;
       ASSERT_MPI(MPI_Iallreduce(&first_local_count, &first_all_count, 1,
                                 MPI_INT64_T, MPI_SUM, m_comm_barrier, &req));
 
@@ -126,13 +224,17 @@ class comm::impl {
         ASSERT_MPI(MPI_Test(&req, &test_flag, MPI_STATUS_IGNORE));
         if (test_flag) {
           if (first_all_count == 0) {
-            // double check
-            int64_t second_all_count{-1};
-            int64_t second_local_count = m_send_count - m_recv_count;
-            ASSERT_MPI(MPI_Allreduce(&second_local_count, &second_all_count, 1,
-                                     MPI_INT64_T, MPI_SUM, m_comm_barrier));
-            if (second_all_count == 0) {
-              ASSERT_RELEASE(first_local_count == second_local_count);
+            // double check.  Ranks snapshot at different times, so a chain
+            // of forwarded messages can balance both sums; only finish if
+            // no rank sent or received anything between the two checks.
+            int64_t second_all[2]{-1, -1};
+            int64_t second_local[2]{
+                m_send_count - m_recv_count,
+                m_send_count != first_send_count ||
+                    m_recv_count != first_recv_count};
+            ASSERT_MPI(MPI_Allreduce(second_local, second_all, 2, MPI_INT64_T,
+                                     MPI_SUM, m_comm_barrier));
+            if (second_all[0] == 0 && second_all[1] == 0) {
               return;
             }
           }
@@ -183,6 +285,7 @@ class comm::impl {
       if (m_vec_send_buffers[dest]->size() == 0) return;
       auto buffer = allocate_buffer();
       std::swap(buffer, m_vec_send_buffers[dest]);
+      wait_send_credits(dest, buffer->size());
       ASSERT_MPI(MPI_Send(buffer->data(), buffer->size(), MPI_BYTE, dest, 0,
                           m_comm_async));
       free_buffer(buffer);
@@ -201,10 +304,52 @@ class comm::impl {
 
   void reset_bytes_sent_counter() { m_local_bytes_sent = 0; }
 
+  int64_t local_bytes_received() const { return m_local_bytes_received; }
+
+  void reset_bytes_received_counter() { m_local_bytes_received = 0; }
+
   int64_t local_rpc_calls() const { return m_local_rpc_calls; }
 
   void reset_rpc_call_counter() { m_local_rpc_calls = 0; }
 
+  void register_pre_barrier_callback(const std::function<void()> &fn) {
+    m_pre_barrier_callbacks.push_back(fn);
+  }
+
+  void run_pre_barrier_callbacks() {
+    while (!m_pre_barrier_callbacks.empty()) {
+      auto fn = std::move(m_pre_barrier_callbacks.front());
+      m_pre_barrier_callbacks.pop_front();
+      fn();
+    }
+  }
+
+  int max_process_depth() const { return m_max_process_depth; }
+
+  void set_max_process_depth(int depth) {
+    ASSERT_RELEASE(depth > 0);
+    m_max_process_depth = depth;
+  }
+
+  int64_t local_buffer_pool_hits() const { return m_buffer_pool.hits(); }
+
+  int64_t local_buffer_pool_misses() const { return m_buffer_pool.misses(); }
+
+  int64_t local_peak_buffer_bytes() const {
+    return m_buffer_pool.peak_bytes_in_use();
+  }
+
+  void reset_buffer_pool_counters() { m_buffer_pool.reset_counters(); }
+
+  double local_credit_wait_time() const { return m_credit_wait_time; }
+
+  int64_t local_credit_waits() const { return m_credit_waits; }
+
+  void reset_credit_wait_counters() {
+    m_credit_wait_time = 0;
+    m_credit_waits     = 0;
+  }
+
   template <typename T>
   T all_reduce_sum(const T &t) const {
     T to_return;
@@ -323,19 +468,26 @@ class comm::impl {
   void listen() {
     while (true) {
       auto recv_buffer = allocate_buffer();
-      recv_buffer->resize(m_buffer_capacity);  // TODO:  does this clear?
+      recv_buffer->resize(m_buffer_capacity);
       MPI_Status status;
       ASSERT_MPI(MPI_Recv(recv_buffer->data(), m_buffer_capacity, MPI_BYTE,
                           MPI_ANY_SOURCE, MPI_ANY_TAG, m_comm_async, &status));
       int tag = status.MPI_TAG;
 
-      if (tag == large_message_announce_tag) {
+      if (tag == credit_return_tag) {
+        int64_t credits = *(reinterpret_cast<int64_t *>(recv_buffer->data()));
+        m_send_credits[status.MPI_SOURCE] += credits;
+        free_buffer(recv_buffer);
+      } else if (tag == large_message_announce_tag) {
         // Determine size and source of message
         size_t size = *(reinterpret_cast<size_t *>(recv_buffer->data()));
         int    src  = status.MPI_SOURCE;
 
+        free_buffer(recv_buffer);
+
         // Allocate large buffer
-        auto large_recv_buff = std::make_shared<std::vector<char>>(size);
+        auto large_recv_buff = m_buffer_pool.allocate_large(size);
+        large_recv_buff->resize(size);
 
         // Receive large message
         receive_large_message(large_recv_buff, src, size);
@@ -351,7 +503,10 @@ class comm::impl {
         recv_buffer->resize(count);
 
         // Check for kill signal
-        if (status.MPI_SOURCE == m_comm_rank) break;
+        if (status.MPI_SOURCE == m_comm_rank) {
+          free_buffer(recv_buffer);
+          break;
+        }
 
         // Add buffer to receive queue
         receive_queue_push_back(recv_buffer, status.MPI_SOURCE);
@@ -368,6 +523,7 @@ class comm::impl {
   void send_large_message(const std::vector<char> &msg, const int dest) {
     // Announce the large message and its size
     size_t size = msg.size();
+    wait_send_credits(dest, size);
     ASSERT_MPI(MPI_Send(&size, 8, MPI_BYTE, dest, large_message_announce_tag,
                         m_comm_async));
 
@@ -382,47 +538,83 @@ class comm::impl {
    * @param src Source of message
    * @param msg Buffer to hold message
    */
-  void receive_large_message(std::shared_ptr<std::vector<char>> msg,
-                             const int src, const size_t size) {
+  void receive_large_message(detail::comm_buffer *msg, const int src,
+                             const size_t size) {
     ASSERT_MPI(MPI_Recv(msg->data(), size, MPI_BYTE, src, large_message_tag,
                         m_comm_async, MPI_STATUS_IGNORE));
   }
 
   /**
-   * @brief Allocates buffer; checks free pool first.
+   * @brief Number of credits charged for a message of a given size.  Capped
+   * at half the budget so large messages can always make progress.
+   */
+  int64_t credit_cost(size_t bytes) const {
+    return std::min(bytes, m_credit_budget / 2);
+  }
+
+  /**
+   * @brief Blocks until enough credits are available to send to dest,
+   * processing incoming messages while waiting.
    *
-   * @return std::shared_ptr<std::vector<char>>
+   * @param dest Destination for message
+   * @param bytes Size of message to send
    */
-  std::shared_ptr<std::vector<char>> allocate_buffer() {
-    std::scoped_lock lock(m_vec_free_buffers_mutex);
-    if (m_vec_free_buffers.empty()) {
-      auto to_return = std::make_shared<std::vector<char>>();
-      to_return->reserve(m_buffer_capacity);
-      return to_return;
-    } else {
-      auto to_return = m_vec_free_buffers.back();
-      m_vec_free_buffers.pop_back();
-      return to_return;
+  void wait_send_credits(int dest, size_t bytes) {
+    int64_t cost = credit_cost(bytes);
+    if (m_send_credits[dest] < cost) {
+      ++m_credit_waits;
+      bool   outermost = (m_credit_wait_depth++ == 0);
+      double start     = MPI_Wtime();
+      while (m_send_credits[dest] < cost) {
+        if (!receive_queue_process()) {
+          std::this_thread::yield();
+        }
+      }
+      if (outermost) {
+        m_credit_wait_time += MPI_Wtime() - start;
+      }
+      --m_credit_wait_depth;
     }
+    m_send_credits[dest] -= cost;
   }
 
   /**
-   * @brief Frees a previously allocated buffer.  Adds buffer to free pool.
+   * @brief Returns credits for a processed buffer to its sender.  Credits are
+   * batched until half the budget is owed.
    *
-   * @param b buffer to free
+   * @param src Rank that sent the buffer
+   * @param bytes Size of processed buffer
    */
-  void free_buffer(std::shared_ptr<std::vector<char>> b) {
-    b->clear();
-    std::scoped_lock lock(m_vec_free_buffers_mutex);
-    m_vec_free_buffers.push_back(b);
+  void return_credits(int src, size_t bytes) {
+    m_credits_to_return[src] += credit_cost(bytes);
+    if (m_credits_to_return[src] >= int64_t(m_credit_budget / 2)) {
+      int64_t credits          = m_credits_to_return[src];
+      m_credits_to_return[src] = 0;
+      ASSERT_MPI(MPI_Send(&credits, 1, MPI_INT64_T, src, credit_return_tag,
+                          m_comm_async));
+    }
   }
 
+  /**
+   * @brief Allocates buffer of m_buffer_capacity from the buffer pool.
+   *
+   * @return detail::comm_buffer*
+   */
+  detail::comm_buffer *allocate_buffer() { return m_buffer_pool.allocate(); }
+
+  /**
+   * @brief Frees a previously allocated buffer.  Returns buffer to the pool.
+   *
+   * @param b buffer to free
+   */
+  void free_buffer(detail::comm_buffer *b) { m_buffer_pool.free(b); }
+
   size_t receive_queue_peek_size() const { return m_receive_queue.size(); }
 
-  std::pair<std::shared_ptr<std::vector<char>>, int> receive_queue_try_pop() {
+  std::pair<detail::comm_buffer *, int> receive_queue_try_pop() {
     std::scoped_lock lock(m_receive_queue_mutex);
     if (m_receive_queue.empty()) {
-      return std::make_pair(std::shared_ptr<std::vector<char>>(), int(-1));
+      return std::make_pair(nullptr, int(-1));
     } else {
       auto to_return = m_receive_queue.front();
       m_receive_queue.pop_front();
@@ -430,7 +622,7 @@ class comm::impl {
     }
   }
 
-  void receive_queue_push_back(std::shared_ptr<std::vector<char>> b, int from) {
+  void receive_queue_push_back(detail::comm_buffer *b, int from) {
     size_t current_size = 0;
     {
       std::scoped_lock lock(m_receive_queue_mutex);
@@ -448,8 +640,10 @@ class comm::impl {
     ASSERT_DEBUG(sizeof(Lambda) == 1);
     // Question: should this be std::forward(...)
     // \pp was: (l)(this, m_comm_rank, args...);
+    ++m_process_depth;
     ygm::meta::apply_optional(l, std::make_tuple(this, m_comm_rank),
                               std::make_tuple(args...));
+    --m_process_depth;
     return 1;
   }
 
@@ -482,28 +676,158 @@ class comm::impl {
   // this is used to fix address space randomization
   static void reference() {}
 
+  /**
+   * @brief Sends a packed message, buffering it for dest or deferring it when
+   * sent to self.
+   *
+   * @param dest Destination for message
+   * @param data Packed message
+   */
+  void send_packed(int dest, const std::vector<char> &data) {
+    m_send_count++;
+    if (dest == m_comm_rank) {
+      // Too deeply nested, defer to an outer processing loop
+      m_deferred_local.insert(m_deferred_local.end(), data.begin(),
+                              data.end());
+      return;
+    }
+    m_local_bytes_sent += data.size();
+
+    if (data.size() < m_buffer_capacity) {
+      // check if buffer doesn't have enough space.  Loop because handlers
+      // run while waiting for credits may refill the buffer.
+      while (data.size() + m_vec_send_buffers[dest]->size() >
+             m_buffer_capacity) {
+        async_flush(dest);
+      }
+
+      // add data to the to dest buffer
+      m_vec_send_buffers[dest]->append(data.data(), data.size());
+    } else {  // Large message
+      send_large_message(data, dest);
+    }
+  }
+
+  bool local_work_pending() const {
+    return receive_queue_peek_size() > 0 || !m_deferred_local.empty() ||
+           m_sharded_pending;
+  }
+
+  /**
+   * @brief Queues a sharded message for the handler thread owning its shard.
+   */
+  void queue_sharded(int from, uint32_t shard, const std::vector<char> &msg) {
+    auto &batch = m_sharded_batches[shard % m_sharded_batches.size()];
+    cereal::YGMOutputArchive oarchive(batch);
+    oarchive(from);
+    batch.insert(batch.end(), msg.begin(), msg.end());
+    m_sharded_pending = true;
+  }
+
+  /**
+   * @brief Executes queued sharded messages on the handler threads, then sends
+   * the messages those handlers produced.
+   */
+  void process_sharded() {
+    m_sharded_pending = false;
+    m_handler_pool->run([this](int t) {
+      t_staged_messages = &m_staged_messages[t];
+      auto                   &batch = m_sharded_batches[t];
+      cereal::YGMInputArchive iarchive(batch.data(), batch.size());
+      while (!iarchive.empty()) {
+        int from;
+        iarchive(from);
+        execute_message(iarchive, from);
+      }
+      batch.clear();
+      t_staged_messages = nullptr;
+    });
+    // Sending may process further phases, which stage into m_staged_messages
+    for (size_t t = 0; t < m_staged_messages.size(); ++t) {
+      staged_messages staged;
+      staged.swap(m_staged_messages[t]);
+      for (const auto &dest_data : staged) {
+        send_packed(dest_data.first, dest_data.second);
+      }
+    }
+  }
+
+  /**
+   * @brief Stores the reply to an async_call in its future's state.
+   *
+   * @param id Identifier of the call being answered
+   * @param value Value returned by the remote function
+   */
+  template <typename T>
+  void resolve_call(uint64_t id, const T &value) {
+    auto itr = m_pending_calls.find(id);
+    ASSERT_RELEASE(itr != m_pending_calls.end());
+    auto state = std::static_pointer_cast<detail::call_state<T>>(itr->second);
+    m_pending_calls.erase(itr);
+    state->value = value;
+    state->ready = true;
+    if (state->resume != nullptr) {
+      state->resume(state->resume_arg);
+    }
+  }
+
+  /**
+   * @brief Executes every message packed in a buffer.
+   *
+   * @param data Packed messages
+   * @param size Size of packed messages in bytes
+   * @param from Rank the messages came from
+   */
+  void process_messages(char *data, size_t size, int from) {
+    cereal::YGMInputArchive iarchive(data, size);
+    while (!iarchive.empty()) {
+      execute_message(iarchive, from);
+      m_recv_count++;
+    }
+  }
+
+  /**
+   * @brief Unpacks and executes the next message in an archive.
+   */
+  void execute_message(cereal::YGMInputArchive &iarchive, int from) {
+    int64_t iptr;
+    iarchive(iptr);
+    iptr += (int64_t)&reference;
+    void (*fun_ptr)(impl *, int, cereal::YGMInputArchive &);
+    memcpy(&fun_ptr, &iptr, sizeof(uint64_t));
+    fun_ptr(this, from, iarchive);
+  }
+
   bool receive_queue_process() {
     bool received = false;
+    ++m_process_depth;
     while (true) {
       auto buffer_source = receive_queue_try_pop();
       auto buffer        = buffer_source.first;
-      if (buffer == nullptr) break;
-      int from = buffer_source.second;
-      received = true;
-      cereal::YGMInputArchive iarchive(buffer->data(), buffer->size());
-      while (!iarchive.empty()) {
-        int64_t iptr;
-        iarchive(iptr);
-        iptr += (int64_t)&reference;
-        void (*fun_ptr)(impl *, int, cereal::YGMInputArchive &);
-        memcpy(&fun_ptr, &iptr, sizeof(uint64_t));
-        fun_ptr(this, from, iarchive);
-        m_recv_count++;
+      int  from          = buffer_source.second;
+      if (buffer != nullptr) {
+        m_local_bytes_received += buffer->size();
+        process_messages(buffer->data(), buffer->size(), from);
+        return_credits(from, buffer->size());
+        free_buffer(buffer);
+      } else if (!m_deferred_local.empty()) {
+        // Messages to self deferred because the processing depth was exceeded
+        std::vector<char> deferred;
+        deferred.swap(m_deferred_local);
+        process_messages(deferred.data(), deferred.size(), m_comm_rank);
+        if (m_deferred_local.empty()) {
+          // Keep the allocation for future deferrals
+          deferred.clear();
+          deferred.swap(m_deferred_local);
+        }
+      } else if (m_sharded_pending) {
+        process_sharded();
+      } else {
+        break;
       }
-
-      // Only keep buffers of size m_buffer_capacity in pool of buffers
-      if (buffer->size() == m_buffer_capacity) free_buffer(buffer);
+      received = true;
     }
+    --m_process_depth;
     return received;
   }
 
@@ -514,33 +838,66 @@ class comm::impl {
   int      m_comm_rank;
   size_t   m_buffer_capacity;
 
-  std::vector<std::shared_ptr<std::vector<char>>> m_vec_send_buffers;
-
-  std::mutex                                      m_vec_free_buffers_mutex;
-  std::vector<std::shared_ptr<std::vector<char>>> m_vec_free_buffers;
+  detail::buffer_pool                m_buffer_pool;
+  std::vector<detail::comm_buffer *> m_vec_send_buffers;
 
-  std::deque<std::pair<std::shared_ptr<std::vector<char>>, int>>
-             m_receive_queue;
-  std::mutex m_receive_queue_mutex;
+  std::deque<std::pair<detail::comm_buffer *, int>> m_receive_queue;
+  std::mutex                                         m_receive_queue_mutex;
 
   std::thread m_listener;
 
+  // Nesting depth of message processing on the user thread.  Messages that
+  // would exceed m_max_process_depth are left for an outer processing loop.
+  int               m_process_depth     = 0;
+  int               m_max_process_depth = 8;
+  std::vector<char> m_deferred_local;
+
+  std::deque<std::function<void()>> m_pre_barrier_callbacks;
+
+  // Optional handler threads executing sharded messages.  Each thread owns
+  // the shards congruent to its index and a list of messages its handlers
+  // sent during the current phase.
+  using staged_messages = std::vector<std::pair<int, std::vector<char>>>;
+  std::unique_ptr<detail::handler_pool>  m_handler_pool;
+  std::vector<std::vector<char>>         m_sharded_batches;
+  std::vector<staged_messages>           m_staged_messages;
+  bool                                   m_sharded_pending = false;
+  inline static thread_local staged_messages *t_staged_messages = nullptr;
+
+  // Flow control:  bytes this rank may still send to each destination, and
+  // bytes processed from each source not yet returned as credits.
+  size_t                                  m_credit_budget;
+  std::unique_ptr<std::atomic<int64_t>[]> m_send_credits;
+  std::vector<int64_t>                    m_credits_to_return;
+  double                                  m_credit_wait_time  = 0;
+  int64_t                                 m_credit_waits      = 0;
+  int                                     m_credit_wait_depth = 0;
+
+  // States of async_calls awaiting a reply, keyed by call id
+  std::unordered_map<uint64_t, std::shared_ptr<void>> m_pending_calls;
+  uint64_t                                            m_next_call_id = 0;
+
   int64_t m_recv_count = 0;
   int64_t m_send_count = 0;
 
-  int64_t m_local_rpc_calls  = 0;
-  int64_t m_local_bytes_sent = 0;
+  int64_t m_local_rpc_calls      = 0;
+  int64_t m_local_bytes_sent     = 0;
+  int64_t m_local_bytes_received = 0;
 
+  int credit_return_tag          = 32765;
   int large_message_announce_tag = 32766;
   int large_message_tag          = 32767;
 };
 
-inline comm::comm(int *argc, char ***argv, int buffer_capacity = 16 * 1024) {
+inline comm::comm(int *argc, char ***argv, int buffer_capacity = 16 * 1024,
+                  size_t credit_budget = 0) {
   pimpl_if = std::make_shared<detail::mpi_init_finalize>(argc, argv);
-  pimpl    = std::make_shared<comm::impl>(MPI_COMM_WORLD, buffer_capacity);
+  pimpl    = std::make_shared<comm::impl>(MPI_COMM_WORLD, buffer_capacity,
+                                       credit_budget);
 }
 
-inline comm::comm(MPI_Comm mcomm, int buffer_capacity = 16 * 1024) {
+inline comm::comm(MPI_Comm mcomm, int buffer_capacity = 16 * 1024,
+                  size_t credit_budget = 0) {
   pimpl_if.reset();
   int flag(0);
   ASSERT_MPI(MPI_Initialized(&flag));
@@ -552,13 +909,19 @@ inline comm::comm(MPI_Comm mcomm, int buffer_capacity = 16 * 1024) {
   if (provided != MPI_THREAD_MULTIPLE) {
     throw std::runtime_error("ERROR: MPI_THREAD_MULTIPLE not provided");
   }
-  pimpl = std::make_shared<comm::impl>(mcomm, buffer_capacity);
+  pimpl = std::make_shared<comm::impl>(mcomm, buffer_capacity, credit_budget);
 }
 
 inline comm::~comm() {
-  ASSERT_RELEASE(MPI_Barrier(MPI_COMM_WORLD) == MPI_SUCCESS);
+  // A comm built on a user communicator may span only part of
+  // MPI_COMM_WORLD; impl's destructor already synchronizes its own ranks
+  if (pimpl_if) {
+    ASSERT_RELEASE(MPI_Barrier(MPI_COMM_WORLD) == MPI_SUCCESS);
+  }
   pimpl.reset();
-  ASSERT_RELEASE(MPI_Barrier(MPI_COMM_WORLD) == MPI_SUCCESS);
+  if (pimpl_if) {
+    ASSERT_RELEASE(MPI_Barrier(MPI_COMM_WORLD) == MPI_SUCCESS);
+  }
   pimpl_if.reset();
 }
 
@@ -569,8 +932,39 @@ inline void comm::async(int dest, AsyncFunction fn, const SendArgs &... args) {
   pimpl->async(dest, fn, std::forward<const SendArgs>(args)...);
 }
 
+template <typename AsyncFunction, typename... SendArgs>
+inline void comm::async_sharded(int dest, uint32_t shard, AsyncFunction fn,
+                                const SendArgs &... args) {
+  static_assert(std::is_empty<AsyncFunction>::value,
+                "Only stateless lambdas are supported");
+  pimpl->async_sharded(dest, shard, fn, std::forward<const SendArgs>(args)...);
+}
+
+template <typename AsyncFunction, typename... SendArgs>
+inline auto comm::async_call(int dest, AsyncFunction fn,
+                             const SendArgs &... args) {
+  static_assert(std::is_empty<AsyncFunction>::value,
+                "Only stateless lambdas are supported");
+  return pimpl->async_call(dest, fn, std::forward<const SendArgs>(args)...);
+}
+
+#if defined(__cpp_impl_coroutine)
+template <typename AsyncFunction, typename... SendArgs>
+inline auto comm::remote(int dest, AsyncFunction fn,
+                         const SendArgs &... args) {
+  using future_type = decltype(async_call(dest, fn, args...));
+  return detail::remote_awaitable<future_type>(
+      async_call(dest, fn, std::forward<const SendArgs>(args)...));
+}
+#endif
+
 inline int comm::size() const { return pimpl->size(); }
 inline int comm::rank() const { return pimpl->rank(); }
+inline size_t comm::buffer_capacity() const {
+  return pimpl->buffer_capacity();
+}
+
+inline MPI_Comm comm::get_mpi_comm() const { return pimpl->get_mpi_comm(); }
 
 inline int64_t comm::local_bytes_sent() const {
   return pimpl->local_bytes_sent();
@@ -584,6 +978,18 @@ inline void comm::reset_bytes_sent_counter() {
   pimpl->reset_bytes_sent_counter();
 }
 
+inline int64_t comm::local_bytes_received() const {
+  return pimpl->local_bytes_received();
+}
+
+inline int64_t comm::global_bytes_received() const {
+  return all_reduce_sum(local_bytes_received());
+}
+
+inline void comm::reset_bytes_received_counter() {
+  pimpl->reset_bytes_received_counter();
+}
+
 inline int64_t comm::local_rpc_calls() const {
   return pimpl->local_rpc_calls();
 }
@@ -594,12 +1000,80 @@ inline int64_t comm::global_rpc_calls() const {
 
 inline void comm::reset_rpc_call_counter() { pimpl->reset_rpc_call_counter(); }
 
+inline int comm::handler_threads() const { return pimpl->handler_threads(); }
+
+inline void comm::set_handler_threads(int num_threads) {
+  pimpl->set_handler_threads(num_threads);
+}
+
+inline int comm::max_process_depth() const {
+  return pimpl->max_process_depth();
+}
+
+inline void comm::set_max_process_depth(int depth) {
+  pimpl->set_max_process_depth(depth);
+}
+
+inline void comm::register_pre_barrier_callback(
+    const std::function<void()> &fn) {
+  pimpl->register_pre_barrier_callback(fn);
+}
+
+inline int64_t comm::local_buffer_pool_hits() const {
+  return pimpl->local_buffer_pool_hits();
+}
+
+inline int64_t comm::local_buffer_pool_misses() const {
+  return pimpl->local_buffer_pool_misses();
+}
+
+inline int64_t comm::local_peak_buffer_bytes() const {
+  return pimpl->local_peak_buffer_bytes();
+}
+
+inline int64_t comm::global_peak_buffer_bytes() const {
+  return all_reduce_max(local_peak_buffer_bytes());
+}
+
+inline void comm::reset_buffer_pool_counters() {
+  pimpl->reset_buffer_pool_counters();
+}
+
+inline double comm::local_credit_wait_time() const {
+  return pimpl->local_credit_wait_time();
+}
+
+inline double comm::global_credit_wait_time() const {
+  return all_reduce_sum(local_credit_wait_time());
+}
+
+inline int64_t comm::local_credit_waits() const {
+  return pimpl->local_credit_waits();
+}
+
+inline int64_t comm::global_credit_waits() const {
+  return all_reduce_sum(local_credit_waits());
+}
+
+inline void comm::reset_credit_wait_counters() {
+  pimpl->reset_credit_wait_counters();
+}
+
 inline void comm::barrier() { pimpl->barrier(); }
 
 inline void comm::async_flush(int rank) { pimpl->async_flush(rank); }
 
 inline void comm::async_flush_all() { pimpl->async_flush_all(); }
 
+template <typename T>
+inline T &future<T>::get() {
+  ASSERT_RELEASE(valid());
+  while (!m_state->ready) {
+    m_pimpl->progress();
+  }
+  return m_state->value;
+}
+
 template <typename T>
 inline T comm::all_reduce_sum(const T &t) const {
   return pimpl->all_reduce_sum(t);
@@ -0,0 +1,118 @@
+// Copyright 2019-2021 Lawrence Livermore National Security, LLC and other YGM
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <array>
+#include <coroutine>
+#include <exception>
+#include <new>
+#include <utility>
+#include <vector>
+
+namespace ygm {
+
+namespace detail {
+
+/**
+ * @brief Recycles coroutine frames by size class.  Tasks only run on the user
+ * thread, so the pool needs no locking.
+ */
+class frame_pool {
+ public:
+  static void *allocate(size_t size) {
+    size_t sclass = size_class(size);
+    if (sclass >= num_classes) {
+      return ::operator new(size);
+    }
+    auto &free_list = free_lists()[sclass];
+    if (free_list.empty()) {
+      return ::operator new((sclass + 1) * granularity);
+    }
+    void *to_return = free_list.back();
+    free_list.pop_back();
+    return to_return;
+  }
+
+  static void deallocate(void *p, size_t size) {
+    size_t sclass = size_class(size);
+    if (sclass >= num_classes) {
+      ::operator delete(p);
+    } else {
+      free_lists()[sclass].push_back(p);
+    }
+  }
+
+ private:
+  static constexpr size_t granularity = 64;
+  static constexpr size_t num_classes = 64;
+
+  static size_t size_class(size_t size) {
+    return (size + granularity - 1) / granularity - 1;
+  }
+
+  static std::array<std::vector<void *>, num_classes> &free_lists() {
+    static std::array<std::vector<void *>, num_classes> lists;
+    return lists;
+  }
+};
+
+/**
+ * @brief Awaits the future returned by comm::async_call, suspending the
+ * awaiting coroutine until the reply is processed.
+ */
+template <typename Future>
+class remote_awaitable {
+ public:
+  remote_awaitable(Future f) : m_future(std::move(f)) {}
+
+  bool await_ready() const { return m_future.ready(); }
+
+  void await_suspend(std::coroutine_handle<> handle) {
+    m_future.set_continuation(&resume, handle.address());
+  }
+
+  auto await_resume() { return std::move(m_future.get()); }
+
+ private:
+  static void resume(void *address) {
+    std::coroutine_handle<>::from_address(address).resume();
+  }
+
+  Future m_future;
+};
+
+}  // namespace detail
+
+/**
+ * @brief Fire-and-forget coroutine for multi-step distributed algorithms.
+ * Starts running immediately and is resumed from message processing when the
+ * replies it awaits arrive; comm::barrier() returns once all tasks are done
+ * awaiting.  Frames are allocated from a pool.
+ */
+class task {
+ public:
+  struct promise_type {
+    task get_return_object() { return task(); }
+
+    std::suspend_never initial_suspend() noexcept { return {}; }
+
+    std::suspend_never final_suspend() noexcept { return {}; }
+
+    void return_void() {}
+
+    void unhandled_exception() { throw; }
+
+    static void *operator new(size_t size) {
+      return detail::frame_pool::allocate(size);
+    }
+
+    static void operator delete(void *p, size_t size) {
+      detail::frame_pool::deallocate(p, size);
+    }
+  };
+};
+
+}  // namespace ygm
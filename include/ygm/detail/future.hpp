@@ -0,0 +1,59 @@
+// Copyright 2019-2021 Lawrence Livermore National Security, LLC and other YGM
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <memory>
+
+namespace ygm {
+
+namespace detail {
+template <typename T>
+struct call_state {
+  bool ready = false;
+  T    value;
+
+  // Optional continuation invoked once value is ready
+  void (*resume)(void *) = nullptr;
+  void *resume_arg       = nullptr;
+};
+}  // namespace detail
+
+/**
+ * @brief Handle to the reply of a comm::async_call.  Replies travel back
+ * through the normal send buffers and are resolved while messages are
+ * processed; get() drives progress until its reply has arrived.
+ *
+ * @tparam T Type returned by the remote function
+ */
+template <typename T>
+class future {
+ public:
+  future() = default;
+
+  future(comm::impl *pimpl, std::shared_ptr<detail::call_state<T>> state)
+      : m_pimpl(pimpl), m_state(state) {}
+
+  bool valid() const { return bool(m_state); }
+
+  bool ready() const { return valid() && m_state->ready; }
+
+  T &get();
+
+  /**
+   * @brief Registers a function to call with arg once the reply has been
+   * processed.  Used to resume coroutines awaiting this future.
+   */
+  void set_continuation(void (*fn)(void *), void *arg) {
+    m_state->resume     = fn;
+    m_state->resume_arg = arg;
+  }
+
+ private:
+  comm::impl                            *m_pimpl = nullptr;
+  std::shared_ptr<detail::call_state<T>> m_state;
+};
+
+}  // namespace ygm
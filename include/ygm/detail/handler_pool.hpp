@@ -0,0 +1,97 @@
+// Copyright 2019-2021 Lawrence Livermore National Security, LLC and other YGM
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace ygm::detail {
+
+/**
+ * @brief Fixed set of threads that execute one phase of work at a time.  The
+ * calling thread participates as thread 0, so a pool of size 1 spawns no
+ * threads.
+ */
+class handler_pool {
+ public:
+  handler_pool(int num_threads) : m_num_threads(num_threads) {
+    for (int i = 1; i < m_num_threads; ++i) {
+      m_threads.emplace_back(&handler_pool::work, this, i);
+    }
+  }
+
+  ~handler_pool() {
+    {
+      std::scoped_lock lock(m_mutex);
+      m_stop = true;
+    }
+    m_start_cv.notify_all();
+    for (auto &t : m_threads) {
+      t.join();
+    }
+  }
+
+  handler_pool(const handler_pool &) = delete;
+  handler_pool &operator=(const handler_pool &) = delete;
+
+  int size() const { return m_num_threads; }
+
+  /**
+   * @brief Runs fn(thread_index) on every thread of the pool and returns once
+   * all have finished.
+   */
+  void run(std::function<void(int)> fn) {
+    {
+      std::scoped_lock lock(m_mutex);
+      m_phase_fn = fn;
+      m_running  = m_num_threads - 1;
+      ++m_generation;
+    }
+    m_start_cv.notify_all();
+    fn(0);
+    std::unique_lock lock(m_mutex);
+    m_done_cv.wait(lock, [this] { return m_running == 0; });
+  }
+
+ private:
+  void work(int index) {
+    uint64_t seen_generation = 0;
+    while (true) {
+      std::function<void(int)> fn;
+      {
+        std::unique_lock lock(m_mutex);
+        m_start_cv.wait(lock, [this, seen_generation] {
+          return m_stop || m_generation != seen_generation;
+        });
+        if (m_stop) return;
+        seen_generation = m_generation;
+        fn              = m_phase_fn;
+      }
+      fn(index);
+      {
+        std::scoped_lock lock(m_mutex);
+        --m_running;
+      }
+      m_done_cv.notify_one();
+    }
+  }
+
+  int                      m_num_threads;
+  std::vector<std::thread> m_threads;
+
+  std::mutex               m_mutex;
+  std::condition_variable  m_start_cv;
+  std::condition_variable  m_done_cv;
+  std::function<void(int)> m_phase_fn;
+  uint64_t                 m_generation = 0;
+  int                      m_running    = 0;
+  bool                     m_stop       = false;
+};
+
+}  // namespace ygm::detail
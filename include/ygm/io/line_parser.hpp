@@ -0,0 +1,254 @@
+// Copyright 2019-2021 Lawrence Livermore National Security, LLC and other YGM
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cereal/types/string.hpp>
+#include <cereal/types/utility.hpp>
+#include <cereal/types/vector.hpp>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <ygm/comm.hpp>
+
+namespace ygm::io {
+
+/**
+ * @brief Reads the lines of a list of text files in parallel.  The files are
+ * treated as one byte stream cut into equal ranges, one per rank, whatever
+ * the number and sizes of the files, and each line is read by the rank whose
+ * range holds its first byte; a rank finishes a line straddling the end of
+ * its range and skips the tail of one straddling its start.  Lines exclude
+ * their '\n', and the end of a file ends its last line.
+ *
+ * Constructing a line_parser is collective; for_all is not and may be
+ * called repeatedly.
+ */
+class line_parser {
+ public:
+  /**
+   * @param paths Files, or directories whose regular files are all read
+   * @param use_mmap Map each file instead of reading it into a buffer
+   * @param buffer_size Bytes per read; grows to fit longer lines
+   */
+  line_parser(ygm::comm &comm, const std::vector<std::string> &paths,
+              bool use_mmap = false, size_t buffer_size = size_t(16) << 20)
+      : m_comm(comm), m_use_mmap(use_mmap), m_buffer_size(buffer_size) {
+    // Rank 0 lists and sizes the files, sparing the filesystem the same
+    // metadata requests from every rank
+    std::vector<std::pair<std::string, uint64_t>> files;
+    if (m_comm.rank0()) {
+      files = list_files(paths);
+    }
+    m_files = m_comm.all_reduce(
+        files, [](const auto &a, const auto &b) { return a.empty() ? b : a; });
+
+    uint64_t total = 0;
+    for (const auto &file : m_files) {
+      total += file.second;
+    }
+    m_begin = total * m_comm.rank() / m_comm.size();
+    m_end   = total * (m_comm.rank() + 1) / m_comm.size();
+  }
+
+  /**
+   * @brief Calls fn(line) for every line in this rank's share.  fn receives
+   * a std::string_view, valid only during the call, if it accepts one, and
+   * otherwise a const std::string &.
+   */
+  template <typename Function>
+  void for_all(Function fn) {
+    uint64_t file_start = 0;
+    for (const auto &[path, size] : m_files) {
+      uint64_t file_end = file_start + size;
+      uint64_t begin    = std::max(m_begin, file_start);
+      uint64_t end      = std::min(m_end, file_end);
+      if (begin < end) {
+        if (m_use_mmap) {
+          for_lines_mapped(path, size, begin - file_start, end - file_start,
+                           fn);
+        } else {
+          for_lines_buffered(path, size, begin - file_start,
+                             end - file_start, fn);
+        }
+      }
+      file_start = file_end;
+    }
+  }
+
+  // Bytes of input in this rank's share, before adjusting for lines
+  // straddling its ends
+  uint64_t local_bytes() const { return m_end - m_begin; }
+
+  const std::vector<std::pair<std::string, uint64_t>> &files() const {
+    return m_files;
+  }
+
+ private:
+  static std::vector<std::pair<std::string, uint64_t>> list_files(
+      const std::vector<std::string> &paths) {
+    std::vector<std::pair<std::string, uint64_t>> files;
+    for (const auto &path : paths) {
+      if (std::filesystem::is_directory(path)) {
+        std::vector<std::string> entries;
+        for (const auto &entry : std::filesystem::directory_iterator(path)) {
+          if (entry.is_regular_file()) {
+            entries.push_back(entry.path().string());
+          }
+        }
+        std::sort(entries.begin(), entries.end());
+        for (const auto &entry : entries) {
+          files.emplace_back(entry, std::filesystem::file_size(entry));
+        }
+      } else {
+        files.emplace_back(path, std::filesystem::file_size(path));
+      }
+    }
+    return files;
+  }
+
+  template <typename Function>
+  void emit(Function &fn, const char *data, size_t length) {
+    if constexpr (std::is_invocable_v<Function &, std::string_view>) {
+      fn(std::string_view(data, length));
+    } else {
+      m_line.assign(data, length);
+      fn(static_cast<const std::string &>(m_line));
+    }
+  }
+
+  /**
+   * @brief Reads the lines starting in [begin, end) of a file of size bytes
+   * with pread, one buffer at a time.
+   */
+  template <typename Function>
+  void for_lines_buffered(const std::string &path, uint64_t size,
+                          uint64_t begin, uint64_t end, Function &fn) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+      throw std::runtime_error("open " + path + ": " + strerror(errno));
+    }
+    ::posix_fadvise(fd, begin, 0, POSIX_FADV_SEQUENTIAL);
+    m_buffer.resize(std::max<size_t>(m_buffer_size, 2));
+
+    // Read from the byte before begin to learn whether a line starts at it
+    uint64_t position = begin == 0 ? 0 : begin - 1;
+    size_t   filled   = 0;  // bytes in m_buffer from position
+    size_t   cursor   = 0;  // next unscanned byte in m_buffer
+    bool     skipping = begin != 0;
+
+    auto refill = [&]() {
+      // Keep the unfinished line at the front of the buffer
+      if (cursor > 0) {
+        std::memmove(m_buffer.data(), m_buffer.data() + cursor,
+                     filled - cursor);
+        position += cursor;
+        filled -= cursor;
+        cursor = 0;
+      }
+      if (filled == m_buffer.size()) {
+        m_buffer.resize(2 * m_buffer.size());
+      }
+      size_t  want = std::min<uint64_t>(m_buffer.size() - filled,
+                                        size - position - filled);
+      ssize_t got =
+          ::pread(fd, m_buffer.data() + filled, want, position + filled);
+      if (got < 0) {
+        ::close(fd);
+        throw std::runtime_error("pread " + path + ": " + strerror(errno));
+      }
+      filled += got;
+      return got > 0;
+    };
+
+    while (true) {
+      if (cursor == filled && !refill()) {
+        break;
+      }
+      if (skipping) {
+        // Bytes up to and including the next '\n' belong to a line started
+        // by an earlier rank
+        auto *nl = static_cast<const char *>(
+            std::memchr(m_buffer.data() + cursor, '\n', filled - cursor));
+        cursor   = nl ? nl - m_buffer.data() + 1 : filled;
+        skipping = nl == nullptr;
+        continue;
+      }
+      if (position + cursor >= end) {
+        break;
+      }
+      auto *start = m_buffer.data() + cursor;
+      auto *nl    = static_cast<const char *>(
+          std::memchr(start, '\n', filled - cursor));
+      if (nl != nullptr) {
+        emit(fn, start, nl - start);
+        cursor = nl - m_buffer.data() + 1;
+      } else if (position + filled == size) {
+        // Last line of the file, without a '\n'
+        emit(fn, start, filled - cursor);
+        cursor = filled;
+      } else if (!refill()) {
+        break;
+      }
+    }
+    ::close(fd);
+  }
+
+  /**
+   * @brief Reads the lines starting in [begin, end) of a file of size bytes
+   * from a read-only mapping of the whole file.
+   */
+  template <typename Function>
+  void for_lines_mapped(const std::string &path, uint64_t size,
+                        uint64_t begin, uint64_t end, Function &fn) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+      throw std::runtime_error("open " + path + ": " + strerror(errno));
+    }
+    void *addr = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (addr == MAP_FAILED) {
+      throw std::runtime_error("mmap " + path + ": " + strerror(errno));
+    }
+    ::madvise(addr, size, MADV_SEQUENTIAL);
+
+    const char *data = static_cast<const char *>(addr);
+    const char *last = data + size;
+    const char *pos  = data + begin;
+    if (begin != 0 && data[begin - 1] != '\n') {
+      auto *nl = static_cast<const char *>(std::memchr(pos, '\n', last - pos));
+      pos      = nl ? nl + 1 : last;
+    }
+    while (pos < data + end) {
+      auto *nl = static_cast<const char *>(std::memchr(pos, '\n', last - pos));
+      auto *line_end = nl ? nl : last;
+      emit(fn, pos, line_end - pos);
+      pos = nl ? nl + 1 : last;
+    }
+    ::munmap(addr, size);
+  }
+
+  ygm::comm                                    &m_comm;
+  bool                                          m_use_mmap;
+  size_t                                        m_buffer_size;
+  std::vector<std::pair<std::string, uint64_t>> m_files;
+  uint64_t                                      m_begin{0};
+  uint64_t                                      m_end{0};
+  std::vector<char>                             m_buffer;
+  std::string                                   m_line;
+};
+
+}  // namespace ygm::io
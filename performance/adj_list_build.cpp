@@ -0,0 +1,79 @@
+// Copyright 2019-2021 Lawrence Livermore National Security, LLC and other YGM
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: MIT
+
+#include <random>
+#include <ygm/comm.hpp>
+#include <ygm/container/adj_list.hpp>
+#include <ygm/container/map.hpp>
+#include <ygm/utility.hpp>
+
+// Builds and iterates a skewed random graph stored in adj_list and in
+// multimap.  Sources are drawn as n * x^3 for uniform x, so low ids are hubs.
+
+template <typename Generator>
+uint64_t skewed_vertex(Generator &gen, uint64_t num_vertices) {
+  double x = std::uniform_real_distribution<double>(0, 1)(gen);
+  return uint64_t(x * x * x * num_vertices) % num_vertices;
+}
+
+int main(int argc, char **argv) {
+  ygm::comm world(&argc, &argv);
+
+  if (argc < 4) {
+    world.cerr0(
+        "Please provide the global number of vertices and edges, and the "
+        "delegate threshold");
+    exit(EXIT_FAILURE);
+  }
+
+  uint64_t num_vertices = atoll(argv[1]);
+  uint64_t num_edges    = atoll(argv[2]);
+  size_t   threshold    = atoll(argv[3]);
+  uint64_t local_edges  = num_edges / world.size();
+  world.cout0("Vertices: ", num_vertices, ", edges: ", num_edges,
+              ", delegate threshold: ", threshold);
+
+  {
+    ygm::container::adj_list<uint64_t> graph(world, threshold);
+    std::mt19937_64                    gen(world.rank());
+    world.barrier();
+    ygm::timer build_timer{};
+    for (uint64_t i = 0; i < local_edges; ++i) {
+      graph.async_insert_edge(skewed_vertex(gen, num_vertices),
+                              gen() % num_vertices);
+    }
+    graph.finalize();
+    world.cout0("adj_list build: ", build_timer.elapsed(), " s, ",
+                graph.delegates().size(), " delegates");
+
+    ygm::timer iter_timer{};
+    uint64_t   checksum{0};
+    graph.for_all_edges(
+        [&checksum](uint64_t u, uint64_t v) { checksum += u ^ v; });
+    world.cout0("adj_list for_all_edges: ", iter_timer.elapsed(), " s");
+  }
+
+  {
+    ygm::container::multimap<uint64_t, uint64_t> graph(world);
+    std::mt19937_64                              gen(world.rank());
+    world.barrier();
+    ygm::timer build_timer{};
+    for (uint64_t i = 0; i < local_edges; ++i) {
+      graph.async_insert(skewed_vertex(gen, num_vertices),
+                         gen() % num_vertices);
+    }
+    world.barrier();
+    world.cout0("multimap build: ", build_timer.elapsed(), " s");
+
+    ygm::timer iter_timer{};
+    uint64_t   checksum{0};
+    graph.for_all(
+        [&checksum](const auto &kv) { checksum += kv.first ^ kv.second; });
+    world.barrier();
+    world.cout0("multimap for_all: ", iter_timer.elapsed(), " s");
+  }
+
+  return 0;
+}
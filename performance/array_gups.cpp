@@ -0,0 +1,61 @@
+// Copyright 2019-2021 Lawrence Livermore National Security, LLC and other YGM
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: MIT
+
+#include <random>
+#include <ygm/comm.hpp>
+#include <ygm/container/array.hpp>
+#include <ygm/container/map.hpp>
+#include <ygm/utility.hpp>
+
+// GUPS-style random xor updates to a table of a global number of uint64_t
+// elements, stored in array and in map<uint64_t, uint64_t>.
+
+int main(int argc, char **argv) {
+  ygm::comm world(&argc, &argv);
+
+  if (argc < 3) {
+    world.cerr0("Please provide the table size and updates per rank");
+    exit(EXIT_FAILURE);
+  }
+
+  size_t table_size = atoll(argv[1]);
+  size_t updates    = atoll(argv[2]);
+  world.cout0("Table size: ", table_size, ", updates per rank: ", updates);
+  size_t global_updates = updates * world.size();
+
+  {
+    ygm::container::array<uint64_t> arr(world, table_size);
+    std::mt19937_64                 gen(world.rank());
+    world.barrier();
+    ygm::timer timer{};
+    for (size_t i = 0; i < updates; ++i) {
+      uint64_t r = gen();
+      arr.async_reduce(r % table_size, r,
+                       [](uint64_t a, uint64_t b) { return a ^ b; });
+    }
+    world.barrier();
+    double elapsed = timer.elapsed();
+    world.cout0("array: ", elapsed, " s, ", global_updates / elapsed / 1e9,
+                " GUPS");
+  }
+
+  {
+    ygm::container::map<uint64_t, uint64_t> m(world);
+    std::mt19937_64                         gen(world.rank());
+    world.barrier();
+    ygm::timer timer{};
+    for (size_t i = 0; i < updates; ++i) {
+      uint64_t r = gen();
+      m.async_visit(r % table_size,
+                    [](auto &kv, uint64_t r) { kv.second ^= r; }, r);
+    }
+    world.barrier();
+    double elapsed = timer.elapsed();
+    world.cout0("map: ", elapsed, " s, ", global_updates / elapsed / 1e9,
+                " GUPS");
+  }
+
+  return 0;
+}
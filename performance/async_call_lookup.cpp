@@ -0,0 +1,89 @@
+// Copyright 2019-2021 Lawrence Livermore National Security, LLC and other YGM
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: MIT
+
+#include <random>
+#include <vector>
+#include <ygm/comm.hpp>
+#include <ygm/detail/ygm_ptr.hpp>
+#include <ygm/utility.hpp>
+
+// Measures latency and throughput of remote lookups into a distributed table
+// using comm::async_call.
+
+int main(int argc, char **argv) {
+  ygm::comm world(&argc, &argv);
+
+  if (argc < 2) {
+    world.cerr0("Please provide the number of lookups per rank");
+    exit(EXIT_FAILURE);
+  }
+
+  size_t lookups_per_rank = atoll(argv[1]);
+  size_t table_size       = 1024 * 1024;
+
+  std::vector<uint64_t>               table(table_size);
+  ygm::ygm_ptr<std::vector<uint64_t>> ptable(&table);
+  for (size_t i = 0; i < table_size; ++i) {
+    table[i] = world.rank() * table_size + i;
+  }
+  world.barrier();
+
+  auto lookup = [](auto ptable, size_t index) { return (*ptable)[index]; };
+
+  std::mt19937                          gen(world.rank());
+  std::uniform_int_distribution<int>    rank_dist(0, world.size() - 1);
+  std::uniform_int_distribution<size_t> index_dist(0, table_size - 1);
+
+  //
+  // Latency:  rank 0 waits on each lookup before issuing the next
+  {
+    size_t num_round_trips = std::min(lookups_per_rank, size_t(10000));
+    int    dest            = world.size() - 1;
+
+    world.barrier();
+    ygm::timer latency_timer{};
+    if (world.rank0()) {
+      for (size_t i = 0; i < num_round_trips; ++i) {
+        size_t index = index_dist(gen);
+        auto   f     = world.async_call(dest, lookup, ptable, index);
+        ASSERT_RELEASE(f.get() == dest * table_size + index);
+      }
+    }
+    world.barrier();
+    double elapsed = latency_timer.elapsed();
+    world.cout0("Round trips: ", num_round_trips);
+    world.cout0("Average latency (us): ", 1e6 * elapsed / num_round_trips);
+  }
+
+  //
+  // Throughput:  all ranks issue lookups, resolved by barrier
+  {
+    std::vector<ygm::future<uint64_t>> futures;
+    std::vector<uint64_t>              expected;
+    futures.reserve(lookups_per_rank);
+    expected.reserve(lookups_per_rank);
+
+    world.barrier();
+    ygm::timer throughput_timer{};
+    for (size_t i = 0; i < lookups_per_rank; ++i) {
+      int    dest  = rank_dist(gen);
+      size_t index = index_dist(gen);
+      expected.push_back(dest * table_size + index);
+      futures.push_back(world.async_call(dest, lookup, ptable, index));
+    }
+    world.barrier();
+    double elapsed = throughput_timer.elapsed();
+
+    for (size_t i = 0; i < lookups_per_rank; ++i) {
+      ASSERT_RELEASE(futures[i].get() == expected[i]);
+    }
+
+    world.cout0("Time: ", elapsed);
+    world.cout0("Lookups per second: ",
+                lookups_per_rank * world.size() / elapsed);
+  }
+
+  return 0;
+}
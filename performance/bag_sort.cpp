@@ -0,0 +1,49 @@
+// Copyright 2019-2021 Lawrence Livermore National Security, LLC and other YGM
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: MIT
+
+#include <random>
+#include <string>
+#include <ygm/comm.hpp>
+#include <ygm/container/bag.hpp>
+#include <ygm/utility.hpp>
+
+// Times bag::sort of random 64-bit values.  For weak scaling pass "weak" and
+// a per-rank count; for strong scaling pass "strong" and a global count, then
+// run across increasing numbers of ranks.
+
+int main(int argc, char **argv) {
+  ygm::comm world(&argc, &argv);
+
+  if (argc < 3) {
+    world.cerr0("Usage: bag_sort <weak|strong> <number of values>");
+    exit(EXIT_FAILURE);
+  }
+
+  std::string mode  = argv[1];
+  size_t      count = atoll(argv[2]);
+  size_t      per_rank =
+      mode == "weak" ? count : (count + world.size() - 1) / world.size();
+  world.cout0("Mode: ", mode, ", ranks: ", world.size(),
+              ", values per rank: ", per_rank);
+
+  ygm::container::bag<uint64_t> b(world);
+  std::mt19937_64               gen(world.rank());
+  for (size_t i = 0; i < per_rank; ++i) {
+    b.async_insert(gen());
+  }
+  world.barrier();
+
+  ygm::timer sort_timer{};
+  auto       sorted  = b.sort();
+  double     elapsed = sort_timer.elapsed();
+
+  size_t max_block = world.all_reduce_max(sorted.local_size());
+  world.cout0("sort: ", elapsed, " s, ", sorted.size() / elapsed,
+              " values/s");
+  world.cout0("Largest block relative to average: ",
+              double(max_block) * world.size() / sorted.size());
+
+  return 0;
+}
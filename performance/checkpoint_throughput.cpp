@@ -0,0 +1,93 @@
+// Copyright 2019-2021 Lawrence Livermore National Security, LLC and other YGM
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: MIT
+
+#include <filesystem>
+#include <random>
+#include <string>
+#include <ygm/comm.hpp>
+#include <ygm/container/map.hpp>
+#include <ygm/utility.hpp>
+
+// Saves and reloads a map<uint64_t, uint64_t> with the per-rank JSON files of
+// serialize/deserialize and with the single binary file of
+// checkpoint/restore, reporting time, bytes on disk and throughput.
+
+int main(int argc, char **argv) {
+  ygm::comm world(&argc, &argv);
+
+  if (argc < 3) {
+    world.cerr0(
+        "Please provide the number of entries per rank and a path prefix for "
+        "the files");
+    exit(EXIT_FAILURE);
+  }
+
+  size_t      num_entries = atoll(argv[1]);
+  std::string prefix      = argv[2];
+  world.cout0("Entries per rank: ", num_entries, ", prefix: ", prefix);
+
+  ygm::container::map<uint64_t, uint64_t> m(world);
+  std::mt19937_64                         gen(world.rank());
+  for (size_t i = 0; i < num_entries; ++i) {
+    m.async_insert(gen(), gen());
+  }
+  world.barrier();
+  size_t size = m.size();
+
+  auto report = [&](const char *name, double save_time, double load_time,
+                    uint64_t bytes) {
+    double mib = double(bytes) / (1 << 20);
+    world.cout0(name, ": ", mib, " MiB, save ", save_time, " s (",
+                mib / save_time, " MiB/s), load ", load_time, " s (",
+                mib / load_time, " MiB/s)");
+  };
+
+  {
+    std::string fname = prefix + "json";
+    world.barrier();
+    ygm::timer timer{};
+    m.serialize(fname);
+    world.barrier();
+    double   save_time = timer.elapsed();
+    uint64_t bytes     = world.all_reduce_sum(uint64_t(
+        std::filesystem::file_size(fname + std::to_string(world.rank()))));
+
+    ygm::container::map<uint64_t, uint64_t> reloaded(world);
+    timer.reset();
+    reloaded.deserialize(fname);
+    world.barrier();
+    double load_time = timer.elapsed();
+    if (reloaded.size() != size) {
+      world.cerr0("JSON reload lost entries");
+    }
+    report("JSON serialize", save_time, load_time, bytes);
+    std::filesystem::remove(fname + std::to_string(world.rank()));
+  }
+
+  {
+    std::string fname = prefix + "ckpt";
+    world.barrier();
+    ygm::timer timer{};
+    m.checkpoint(fname);
+    world.barrier();
+    double   save_time = timer.elapsed();
+    uint64_t bytes     = std::filesystem::file_size(fname);
+
+    ygm::container::map<uint64_t, uint64_t> reloaded(world);
+    timer.reset();
+    reloaded.restore(fname);
+    double load_time = timer.elapsed();
+    if (reloaded.size() != size) {
+      world.cerr0("Checkpoint restore lost entries");
+    }
+    report("Binary checkpoint", save_time, load_time, bytes);
+    world.barrier();
+    if (world.rank0()) {
+      std::filesystem::remove(fname);
+    }
+  }
+
+  return 0;
+}
@@ -0,0 +1,98 @@
+// Copyright 2019-2021 Lawrence Livermore National Security, LLC and other YGM
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: MIT
+
+#include <random>
+#include <utility>
+#include <vector>
+#include <ygm/comm.hpp>
+#include <ygm/container/disjoint_set.hpp>
+#include <ygm/container/map.hpp>
+#include <ygm/utility.hpp>
+
+// Connected components of a random graph with a global number of vertices
+// and edges, by disjoint_set and by min-label propagation on map with a
+// barrier per round.
+
+static size_t label_changes = 0;
+
+int main(int argc, char **argv) {
+  ygm::comm world(&argc, &argv);
+
+  if (argc < 3) {
+    world.cerr0("Please provide the global number of vertices and edges");
+    exit(EXIT_FAILURE);
+  }
+
+  uint64_t num_vertices = atoll(argv[1]);
+  uint64_t num_edges    = atoll(argv[2]);
+  world.cout0("Vertices: ", num_vertices, ", edges: ", num_edges);
+
+  std::mt19937_64                         gen(world.rank());
+  std::uniform_int_distribution<uint64_t> dist(0, num_vertices - 1);
+  std::vector<std::pair<uint64_t, uint64_t>> edges(num_edges / world.size());
+  for (auto &edge : edges) {
+    edge = {dist(gen), dist(gen)};
+  }
+
+  {
+    ygm::container::disjoint_set<uint64_t> dset(world);
+    world.barrier();
+    ygm::timer timer{};
+    for (uint64_t v = world.rank(); v < num_vertices; v += world.size()) {
+      dset.async_union(v, v);
+    }
+    for (const auto &[u, v] : edges) {
+      dset.async_union(u, v);
+    }
+    world.barrier();
+    double union_time = timer.elapsed();
+    dset.all_compress();
+    double total_time = timer.elapsed();
+    world.cout0("disjoint_set: ", total_time, " s (unions ", union_time,
+                " s), ", dset.num_sets(), " components");
+  }
+
+  {
+    ygm::container::map<uint64_t, uint64_t> labels(world);
+    world.barrier();
+    ygm::timer timer{};
+    for (uint64_t v = world.rank(); v < num_vertices; v += world.size()) {
+      labels.async_insert(v, v);
+    }
+    world.barrier();
+
+    // Pushes u's label to v, and v's to u, keeping the minimum
+    auto push = [](auto pmap, int from, auto &kv, uint64_t neighbor) {
+      auto lower = [](auto &kv, uint64_t label) {
+        if (label < kv.second) {
+          kv.second = label;
+          ++label_changes;
+        }
+      };
+      pmap->async_visit(neighbor, lower, kv.second);
+    };
+
+    size_t rounds = 0;
+    do {
+      label_changes = 0;
+      for (const auto &[u, v] : edges) {
+        labels.async_visit(u, push, v);
+        labels.async_visit(v, push, u);
+      }
+      world.barrier();
+      ++rounds;
+    } while (world.all_reduce_sum(label_changes) > 0);
+
+    size_t local_components{0};
+    labels.for_all([&local_components](const auto &kv) {
+      local_components += kv.first == kv.second;
+    });
+    world.cout0("map label propagation: ", timer.elapsed(), " s, ", rounds,
+                " rounds, ", world.all_reduce_sum(local_components),
+                " components");
+  }
+
+  return 0;
+}
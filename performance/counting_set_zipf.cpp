@@ -0,0 +1,84 @@
+// Copyright 2019-2021 Lawrence Livermore National Security, LLC and other YGM
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: MIT
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+#include <ygm/comm.hpp>
+#include <ygm/container/counting_set.hpp>
+#include <ygm/utility.hpp>
+
+// Counts Zipf-distributed keys with counting_set under several cache
+// geometries.  Reports insert time up to a barrier, the time of the first
+// size(), which flushes the caches, the time of a second size() with empty
+// caches, the global hit rate and the flush messages sent.
+
+int main(int argc, char **argv) {
+  ygm::comm world(&argc, &argv);
+
+  if (argc < 4) {
+    world.cerr0(
+        "Please provide the number of distinct keys, inserts per rank and the "
+        "Zipf exponent");
+    exit(EXIT_FAILURE);
+  }
+
+  size_t num_keys = atoll(argv[1]);
+  size_t inserts  = atoll(argv[2]);
+  double exponent = atof(argv[3]);
+  world.cout0("Keys: ", num_keys, ", inserts per rank: ", inserts,
+              ", exponent: ", exponent);
+
+  std::vector<double> cdf(num_keys);
+  double              total = 0;
+  for (size_t i = 0; i < num_keys; ++i) {
+    total += 1.0 / std::pow(double(i + 1), exponent);
+    cdf[i] = total;
+  }
+  std::mt19937_64                        gen(world.rank());
+  std::uniform_real_distribution<double> dist(0, total);
+  std::vector<uint64_t>                  keys(inserts);
+  for (auto &key : keys) {
+    key = std::lower_bound(cdf.begin(), cdf.end(), dist(gen)) - cdf.begin();
+  }
+
+  struct geometry {
+    size_t capacity;
+    size_t ways;
+  };
+  for (auto [capacity, ways] :
+       {geometry{0, 1}, geometry{1024 * 1024, 1}, geometry{64 * 1024, 8},
+        geometry{4096, 1}, geometry{4096, 8}}) {
+    ygm::container::counting_set<uint64_t> cset(world, capacity, ways);
+    world.barrier();
+    ygm::timer timer{};
+    for (auto key : keys) {
+      cset.async_insert(key);
+    }
+    world.barrier();
+    double insert_time = timer.elapsed();
+
+    const auto &stats  = cset.cache_stats();
+    uint64_t    hits   = world.all_reduce_sum(stats.hits);
+    uint64_t    misses = world.all_reduce_sum(stats.misses);
+
+    timer.reset();
+    size_t   distinct   = cset.size();
+    double   flush_time = timer.elapsed();
+    uint64_t flushes    = world.all_reduce_sum(stats.flushes);
+    timer.reset();
+    cset.size();
+    double empty_flush_time = timer.elapsed();
+
+    world.cout0("capacity ", capacity, ", ways ", ways, ": insert ",
+                insert_time, " s, first size() ", flush_time, " s, second size() ",
+                empty_flush_time, " s, hit rate ",
+                double(hits) / double(hits + misses), ", flushes ", flushes,
+                ", distinct ", distinct);
+  }
+
+  return 0;
+}
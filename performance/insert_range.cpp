@@ -0,0 +1,73 @@
+// Copyright 2019-2021 Lawrence Livermore National Security, LLC and other YGM
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: MIT
+
+#include <random>
+#include <vector>
+#include <ygm/comm.hpp>
+#include <ygm/container/map.hpp>
+#include <ygm/container/set.hpp>
+#include <ygm/utility.hpp>
+
+// Compares inserting a local vector element by element with
+// async_insert_range.
+
+int main(int argc, char **argv) {
+  ygm::comm world(&argc, &argv);
+
+  if (argc < 2) {
+    world.cerr0("Please provide the number of keys per rank");
+    exit(EXIT_FAILURE);
+  }
+
+  size_t keys_per_rank = atoll(argv[1]);
+  world.cout0("Keys per rank: ", keys_per_rank);
+
+  std::mt19937_64                            gen(world.rank());
+  std::vector<std::pair<uint64_t, uint64_t>> local_pairs;
+  std::vector<uint64_t>                      local_keys;
+  for (size_t i = 0; i < keys_per_rank; ++i) {
+    local_pairs.emplace_back(gen(), i);
+    local_keys.push_back(local_pairs.back().first);
+  }
+
+  {
+    ygm::container::map<uint64_t, uint64_t> m(world);
+    world.barrier();
+    ygm::timer t{};
+    for (const auto &kv : local_pairs) {
+      m.async_insert(kv.first, kv.second);
+    }
+    world.barrier();
+    world.cout0("map per-element: ", t.elapsed(), " s");
+  }
+  {
+    ygm::container::map<uint64_t, uint64_t> m(world);
+    world.barrier();
+    ygm::timer t{};
+    m.async_insert_range(local_pairs.begin(), local_pairs.end());
+    world.barrier();
+    world.cout0("map insert_range: ", t.elapsed(), " s");
+  }
+  {
+    ygm::container::set<uint64_t> s(world);
+    world.barrier();
+    ygm::timer t{};
+    for (const auto &key : local_keys) {
+      s.async_insert(key);
+    }
+    world.barrier();
+    world.cout0("set per-element: ", t.elapsed(), " s");
+  }
+  {
+    ygm::container::set<uint64_t> s(world);
+    world.barrier();
+    ygm::timer t{};
+    s.async_insert_range(local_keys.begin(), local_keys.end());
+    world.barrier();
+    world.cout0("set insert_range: ", t.elapsed(), " s");
+  }
+
+  return 0;
+}
@@ -0,0 +1,121 @@
+// Copyright 2019-2021 Lawrence Livermore National Security, LLC and other YGM
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: MIT
+
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <ygm/comm.hpp>
+#include <ygm/container/bag.hpp>
+#include <ygm/io/line_parser.hpp>
+#include <ygm/utility.hpp>
+
+// Writes a skewed set of text files, half the bytes in one file and the rest
+// spread over many small ones, then reads them with line_parser, buffered
+// and mapped, reporting ingest rate in GB/s.  A one-file-per-rank assignment
+// is timed for comparison, and a last pass feeds every line into a bag.
+
+static uint64_t line_count = 0;
+static uint64_t byte_count = 0;
+
+int main(int argc, char **argv) {
+  ygm::comm world(&argc, &argv);
+
+  if (argc < 4) {
+    world.cerr0(
+        "Please provide the total MB of input, the number of files and a "
+        "directory for them");
+    exit(EXIT_FAILURE);
+  }
+
+  uint64_t    total_bytes = uint64_t(atof(argv[1]) * 1e6);
+  int         num_files   = std::max(2, atoi(argv[2]));
+  std::string dir         = argv[3];
+  world.cout0("Input: ", total_bytes / 1e6, " MB in ", num_files,
+              " files under ", dir);
+
+  std::vector<std::string> paths;
+  for (int f = 0; f < num_files; ++f) {
+    paths.push_back(dir + "/input" + std::to_string(f));
+  }
+  // Each rank writes its share of the files
+  std::filesystem::create_directories(dir);
+  for (int f = world.rank(); f < num_files; f += world.size()) {
+    uint64_t bytes = f == 0 ? total_bytes / 2
+                            : total_bytes / 2 / (num_files - 1);
+    std::mt19937_64 gen(f);
+    std::ofstream   os(paths[f], std::ios::binary);
+    std::string     line;
+    for (uint64_t written = 0; written < bytes; written += line.size() + 1) {
+      line = std::to_string(gen()) + "\t" + std::to_string(gen() % 1000000);
+      os << line << '\n';
+    }
+  }
+  world.barrier();
+
+  auto report = [&](const char *name, double elapsed) {
+    world.cout0(name, ": ", elapsed, " s, ",
+                world.all_reduce_sum(byte_count) / elapsed / 1e9, " GB/s, ",
+                world.all_reduce_sum(line_count), " lines, slowest rank ",
+                world.all_reduce_max(byte_count) /
+                    (double(world.all_reduce_sum(byte_count)) / world.size()),
+                "x mean bytes");
+  };
+  auto count = [](std::string_view line) {
+    ++line_count;
+    byte_count += line.size() + 1;
+  };
+
+  for (bool use_mmap : {false, true}) {
+    line_count = 0;
+    byte_count = 0;
+    world.barrier();
+    ygm::timer           timer{};
+    ygm::io::line_parser parser(world, paths, use_mmap);
+    parser.for_all(count);
+    world.barrier();
+    report(use_mmap ? "line_parser, mmap" : "line_parser, buffered",
+           timer.elapsed());
+  }
+
+  {
+    line_count = 0;
+    byte_count = 0;
+    world.barrier();
+    ygm::timer timer{};
+    for (int f = world.rank(); f < num_files; f += world.size()) {
+      std::ifstream is(paths[f]);
+      std::string   line;
+      while (std::getline(is, line)) {
+        count(line);
+      }
+    }
+    world.barrier();
+    report("One file per rank, getline", timer.elapsed());
+  }
+
+  {
+    line_count = 0;
+    byte_count = 0;
+    world.barrier();
+    ygm::timer                       timer{};
+    ygm::container::bag<std::string> lines(world);
+    ygm::io::line_parser             parser(world, paths);
+    parser.for_all([&lines, &count](std::string_view line) {
+      count(line);
+      lines.async_insert(std::string(line));
+    });
+    world.barrier();
+    report("line_parser into bag", timer.elapsed());
+  }
+
+  world.barrier();
+  for (int f = world.rank(); f < num_files; f += world.size()) {
+    std::filesystem::remove(paths[f]);
+  }
+  return 0;
+}
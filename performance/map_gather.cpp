@@ -0,0 +1,60 @@
+// Copyright 2019-2021 Lawrence Livermore National Security, LLC and other YGM
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: MIT
+
+#include <random>
+#include <vector>
+#include <ygm/comm.hpp>
+#include <ygm/container/map.hpp>
+#include <ygm/utility.hpp>
+
+// Times map::all_gather and map::async_gather of a global number of random
+// keys, 10M in the reference runs, drawn with repetition from the stored keys.
+
+int main(int argc, char **argv) {
+  ygm::comm world(&argc, &argv);
+
+  if (argc < 2) {
+    world.cerr0("Please provide the global number of keys to gather");
+    exit(EXIT_FAILURE);
+  }
+
+  size_t num_gather = atoll(argv[1]);
+  size_t num_stored = std::max<size_t>(world.size(), num_gather / 4);
+  world.cout0("Gathered keys: ", num_gather);
+  world.cout0("Stored keys: ", num_stored);
+
+  ygm::container::map<uint64_t, uint64_t> m(world);
+  for (uint64_t i = world.rank(); i < num_stored; i += world.size()) {
+    m.async_insert(i, i);
+  }
+  world.barrier();
+
+  std::mt19937_64                         gen(world.rank());
+  std::uniform_int_distribution<uint64_t> dist(0, num_stored - 1);
+  std::vector<uint64_t>                   keys(num_gather / world.size());
+  for (auto &key : keys) {
+    key = dist(gen);
+  }
+
+  world.barrier();
+  ygm::timer gather_timer{};
+  auto       gathered = m.all_gather(keys);
+  double     elapsed  = gather_timer.elapsed();
+  world.cout0("all_gather: ", elapsed, " s, ", num_gather / elapsed,
+              " keys/s");
+  world.cout0("Unique keys on rank 0: ", gathered.size());
+
+  world.barrier();
+  ygm::timer async_timer{};
+  auto       request = m.async_gather(keys);
+  auto       results = request.get();
+  world.barrier();
+  elapsed = async_timer.elapsed();
+  world.cout0("async_gather: ", elapsed, " s, ", num_gather / elapsed,
+              " keys/s");
+  ASSERT_RELEASE(results.size() == gathered.size());
+
+  return 0;
+}
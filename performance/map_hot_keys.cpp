@@ -0,0 +1,87 @@
+// Copyright 2019-2021 Lawrence Livermore National Security, LLC and other YGM
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: MIT
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+#include <ygm/comm.hpp>
+#include <ygm/container/map.hpp>
+#include <ygm/utility.hpp>
+
+// Sums Zipf-distributed updates into a map<uint64_t, uint64_t> and reports
+// the time and the receive imbalance, the largest bytes received by a rank
+// over the mean.  Compares async_visit with async_reduce using the smallest
+// combining buffers, with and without hot-key detection, and async_reduce
+// with default buffers.
+
+int main(int argc, char **argv) {
+  ygm::comm world(&argc, &argv);
+
+  if (argc < 4) {
+    world.cerr0(
+        "Please provide the number of distinct keys, updates per rank and the "
+        "Zipf exponent");
+    exit(EXIT_FAILURE);
+  }
+
+  size_t num_keys = atoll(argv[1]);
+  size_t updates  = atoll(argv[2]);
+  double exponent = atof(argv[3]);
+  world.cout0("Keys: ", num_keys, ", updates per rank: ", updates,
+              ", exponent: ", exponent);
+
+  std::vector<double> cdf(num_keys);
+  double              total = 0;
+  for (size_t i = 0; i < num_keys; ++i) {
+    total += 1.0 / std::pow(double(i + 1), exponent);
+    cdf[i] = total;
+  }
+  std::mt19937_64                        gen(world.rank());
+  std::uniform_real_distribution<double> dist(0, total);
+  std::vector<uint64_t>                  keys(updates);
+  for (auto &key : keys) {
+    key = std::lower_bound(cdf.begin(), cdf.end(), dist(gen)) - cdf.begin();
+  }
+
+  auto run = [&](const char *name, auto update, auto configure) {
+    ygm::container::map<uint64_t, uint64_t> m(world);
+    configure(m);
+    world.barrier();
+    world.reset_bytes_received_counter();
+    ygm::timer timer{};
+    for (auto key : keys) {
+      update(m, key);
+    }
+    world.barrier();
+    double  elapsed  = timer.elapsed();
+    int64_t received = world.local_bytes_received();
+    int64_t max      = world.all_reduce_max(received);
+    double  mean     = double(world.all_reduce_sum(received)) / world.size();
+    uint64_t local_sum{0};
+    m.for_all([&local_sum](const auto &kv) { local_sum += kv.second; });
+    world.cout0(name, ": ", elapsed, " s, receive imbalance ", max / mean,
+                ", ", max >> 20, " MiB max, count ",
+                world.all_reduce_sum(local_sum));
+  };
+
+  auto visit = [](auto &m, uint64_t key) {
+    m.async_visit(key, [](auto &kv) { kv.second += 1; });
+  };
+  auto reduce = [](auto &m, uint64_t key) {
+    m.async_reduce(key, uint64_t(1), std::plus<uint64_t>());
+  };
+
+  run("async_visit", visit, [](auto &m) {});
+  run("async_reduce, small buffers", reduce, [](auto &m) {
+    m.set_reduce_buffer_capacity(0);
+    m.set_hot_key_fraction(0);
+  });
+  run("async_reduce, small buffers, hot keys", reduce,
+      [](auto &m) { m.set_reduce_buffer_capacity(0); });
+  run("async_reduce, default buffers, hot keys", reduce, [](auto &m) {});
+
+  return 0;
+}
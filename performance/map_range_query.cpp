@@ -0,0 +1,110 @@
+// Copyright 2019-2021 Lawrence Livermore National Security, LLC and other YGM
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: MIT
+
+#include <random>
+#include <vector>
+#include <ygm/comm.hpp>
+#include <ygm/container/map.hpp>
+#include <ygm/utility.hpp>
+
+// Counts the keys of a map<uint64_t, uint64_t> falling in random ranges, each
+// covering the given fraction of the key space.  Compares filtering a full
+// for_all per query, async_visit_range on a hash partitioned map, which
+// reaches every rank, and async_visit_range on a map whose range partitioner
+// was sampled from the keys, which reaches only the owners of each range.
+
+static uint64_t matched = 0;
+
+int main(int argc, char **argv) {
+  ygm::comm world(&argc, &argv);
+
+  if (argc < 4) {
+    world.cerr0(
+        "Please provide the number of keys per rank, the number of queries and "
+        "the fraction of the key space covered by each query");
+    exit(EXIT_FAILURE);
+  }
+
+  size_t num_keys    = atoll(argv[1]);
+  size_t num_queries = atoll(argv[2]);
+  double fraction    = atof(argv[3]);
+  world.cout0("Keys per rank: ", num_keys, ", queries: ", num_queries,
+              ", fraction: ", fraction);
+
+  const uint64_t        key_space = uint64_t(1) << 40;
+  std::mt19937_64       gen(world.rank());
+  std::vector<uint64_t> keys(num_keys);
+  for (auto &key : keys) {
+    key = gen() % key_space;
+  }
+  // Every rank draws the same queries
+  std::mt19937_64                          query_gen(42);
+  uint64_t                                 width = fraction * key_space;
+  std::vector<std::pair<uint64_t, uint64_t>> queries(num_queries);
+  for (auto &[lo, hi] : queries) {
+    lo = query_gen() % (key_space - width);
+    hi = lo + width;
+  }
+
+  auto report = [&](const char *name, double elapsed) {
+    world.cout0(name, ": ", elapsed, " s, ", elapsed / num_queries * 1e6,
+                " us per query, matched ", world.all_reduce_sum(matched));
+  };
+
+  using hash_map = ygm::container::map<uint64_t, uint64_t>;
+  using range_partitioner =
+      ygm::container::detail::range_partitioner<uint64_t>;
+  using range_map =
+      ygm::container::map<uint64_t, uint64_t, range_partitioner>;
+
+  {
+    hash_map m(world);
+    for (auto key : keys) {
+      m.async_insert(key, key);
+    }
+    world.barrier();
+
+    matched = 0;
+    ygm::timer timer{};
+    for (const auto &[lo, hi] : queries) {
+      m.for_all([lo = lo, hi = hi](const auto &kv) {
+        matched += kv.first >= lo && kv.first < hi;
+      });
+    }
+    world.barrier();
+    report("for_all filtering", timer.elapsed());
+
+    matched = 0;
+    timer.reset();
+    for (size_t q = world.rank(); q < num_queries; q += world.size()) {
+      m.async_visit_range(queries[q].first, queries[q].second,
+                          [](const auto &kv) { ++matched; });
+    }
+    world.barrier();
+    report("async_visit_range, hash partitioned", timer.elapsed());
+  }
+
+  {
+    ygm::timer timer{};
+    range_map  m(world, range_partitioner::sample(world, keys.begin(),
+                                                  keys.end()));
+    for (auto key : keys) {
+      m.async_insert(key, key);
+    }
+    world.barrier();
+    world.cout0("Sampled range partitioned build: ", timer.elapsed(), " s");
+
+    matched = 0;
+    timer.reset();
+    for (size_t q = world.rank(); q < num_queries; q += world.size()) {
+      m.async_visit_range(queries[q].first, queries[q].second,
+                          [](const auto &kv) { ++matched; });
+    }
+    world.barrier();
+    report("async_visit_range, range partitioned", timer.elapsed());
+  }
+
+  return 0;
+}
@@ -0,0 +1,82 @@
+// Copyright 2019-2021 Lawrence Livermore National Security, LLC and other YGM
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: MIT
+
+#include <random>
+#include <vector>
+#include <ygm/comm.hpp>
+#include <ygm/container/map.hpp>
+#include <ygm/utility.hpp>
+
+// PageRank-style accumulation: every rank holds random edges into a global
+// number of vertices and, each iteration, adds one contribution per edge to
+// its target's score.  Compares map::async_visit, which sends one message
+// per edge, with map::async_reduce, which combines contributions to the same
+// target before sending.
+
+int main(int argc, char **argv) {
+  ygm::comm world(&argc, &argv);
+
+  if (argc < 4) {
+    world.cerr0(
+        "Please provide the number of vertices, edges per rank and iterations");
+    exit(EXIT_FAILURE);
+  }
+
+  size_t num_vertices = atoll(argv[1]);
+  size_t num_edges    = atoll(argv[2]);
+  size_t iterations   = atoll(argv[3]);
+  world.cout0("Vertices: ", num_vertices, ", edges per rank: ", num_edges,
+              ", iterations: ", iterations);
+
+  std::mt19937_64                         gen(world.rank());
+  std::uniform_int_distribution<uint64_t> dist(0, num_vertices - 1);
+  std::vector<uint64_t>                   targets(num_edges);
+  for (auto &target : targets) {
+    target = dist(gen);
+  }
+  double contribution = 1.0 / double(num_vertices);
+
+  auto report = [&](const char *name, double elapsed, double checksum) {
+    world.cout0(name, ": ", elapsed, " s, ", world.global_bytes_sent() >> 20,
+                " MiB sent, score sum ", checksum);
+  };
+
+  {
+    ygm::container::map<uint64_t, double> scores(world);
+    world.reset_bytes_sent_counter();
+    world.barrier();
+    ygm::timer timer{};
+    for (size_t iter = 0; iter < iterations; ++iter) {
+      for (auto target : targets) {
+        scores.async_visit(
+            target, [](auto &kv, double c) { kv.second += c; }, contribution);
+      }
+      world.barrier();
+    }
+    double elapsed = timer.elapsed();
+    double sum{0};
+    scores.for_all([&sum](const auto &kv) { sum += kv.second; });
+    report("async_visit", elapsed, world.all_reduce_sum(sum));
+  }
+
+  {
+    ygm::container::map<uint64_t, double> scores(world);
+    world.reset_bytes_sent_counter();
+    world.barrier();
+    ygm::timer timer{};
+    for (size_t iter = 0; iter < iterations; ++iter) {
+      for (auto target : targets) {
+        scores.async_reduce(target, contribution, std::plus<double>());
+      }
+      world.barrier();
+    }
+    double elapsed = timer.elapsed();
+    double sum{0};
+    scores.for_all([&sum](const auto &kv) { sum += kv.second; });
+    report("async_reduce", elapsed, world.all_reduce_sum(sum));
+  }
+
+  return 0;
+}
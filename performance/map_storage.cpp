@@ -0,0 +1,105 @@
+// Copyright 2019-2021 Lawrence Livermore National Security, LLC and other YGM
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: MIT
+
+#include <random>
+#include <string>
+#include <ygm/comm.hpp>
+#include <ygm/container/map.hpp>
+#include <ygm/container/set.hpp>
+#include <ygm/utility.hpp>
+
+// Compares insert and visit rates of the tree and hash table storage policies.
+// The reference runs use 10^9 global keys.
+
+namespace ygmc = ygm::container;
+
+template <typename Map>
+void run_map(ygm::comm &world, const std::string &name, size_t num_keys,
+             uint64_t seed) {
+  Map    m(world);
+  size_t keys_per_rank = num_keys / world.size();
+
+  // Random 64-bit keys, each inserted once
+  std::mt19937_64 gen(seed + world.rank());
+  world.barrier();
+  ygm::timer insert_timer{};
+  for (size_t i = 0; i < keys_per_rank; ++i) {
+    m.async_insert(gen(), i);
+  }
+  world.barrier();
+  double insert_time = insert_timer.elapsed();
+
+  // Visit the same keys again, all hits
+  gen.seed(seed + world.rank());
+  ygm::timer visit_timer{};
+  for (size_t i = 0; i < keys_per_rank; ++i) {
+    m.async_visit(gen(), [](auto &kv) { ++kv.second; });
+  }
+  world.barrier();
+  double visit_time = visit_timer.elapsed();
+
+  ASSERT_RELEASE(m.size() == keys_per_rank * world.size());
+  world.cout0(name, " insert: ", insert_time, " s, ",
+              keys_per_rank * world.size() / insert_time, " keys/s");
+  world.cout0(name, " visit:  ", visit_time, " s, ",
+              keys_per_rank * world.size() / visit_time, " keys/s");
+}
+
+template <typename Set>
+void run_set(ygm::comm &world, const std::string &name, size_t num_keys,
+             uint64_t seed) {
+  Set    s(world);
+  size_t keys_per_rank = num_keys / world.size();
+
+  std::mt19937_64 gen(seed + world.rank());
+  world.barrier();
+  ygm::timer insert_timer{};
+  for (size_t i = 0; i < keys_per_rank; ++i) {
+    s.async_insert(gen());
+  }
+  world.barrier();
+  double insert_time = insert_timer.elapsed();
+
+  world.cout0(name, " insert: ", insert_time, " s, ",
+              keys_per_rank * world.size() / insert_time, " keys/s");
+}
+
+int main(int argc, char **argv) {
+  ygm::comm world(&argc, &argv);
+
+  if (argc < 2) {
+    world.cerr0("Please provide the global number of keys");
+    exit(EXIT_FAILURE);
+  }
+
+  size_t num_keys = atoll(argv[1]);
+  world.cout0("Global keys: ", num_keys);
+
+  using tree_map =
+      ygmc::map<uint64_t, uint64_t, ygmc::detail::hash_partitioner<uint64_t>,
+                std::less<uint64_t>,
+                std::allocator<std::pair<const uint64_t, uint64_t>>,
+                ygmc::detail::tree_storage>;
+  using hash_map =
+      ygmc::map<uint64_t, uint64_t, ygmc::detail::hash_partitioner<uint64_t>,
+                std::less<uint64_t>,
+                std::allocator<std::pair<const uint64_t, uint64_t>>,
+                ygmc::detail::hash_storage>;
+  using tree_set =
+      ygmc::set<uint64_t, ygmc::detail::hash_partitioner<uint64_t>,
+                std::less<uint64_t>, std::allocator<const uint64_t>,
+                ygmc::detail::tree_storage>;
+  using hash_set =
+      ygmc::set<uint64_t, ygmc::detail::hash_partitioner<uint64_t>,
+                std::less<uint64_t>, std::allocator<const uint64_t>,
+                ygmc::detail::hash_storage>;
+
+  run_map<tree_map>(world, "tree map", num_keys, 42);
+  run_map<hash_map>(world, "hash map", num_keys, 42);
+  run_set<tree_set>(world, "tree set", num_keys, 42);
+  run_set<hash_set>(world, "hash set", num_keys, 42);
+
+  return 0;
+}
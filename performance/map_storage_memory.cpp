@@ -0,0 +1,104 @@
+// Copyright 2019-2021 Lawrence Livermore National Security, LLC and other YGM
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: MIT
+
+#include <random>
+#include <string>
+#include <ygm/comm.hpp>
+#include <ygm/container/map.hpp>
+#include <ygm/utility.hpp>
+
+// Reports bytes per entry of a map<uint64_t, uint64_t> under each storage
+// policy, measured with a counting allocator, along with build and lookup
+// rates.
+
+namespace ygmc = ygm::container;
+
+static int64_t allocated_bytes = 0;
+
+template <typename T>
+struct counting_allocator {
+  using value_type = T;
+
+  counting_allocator() = default;
+  template <typename U>
+  counting_allocator(const counting_allocator<U> &) {}
+
+  T *allocate(size_t n) {
+    allocated_bytes += n * sizeof(T);
+    return std::allocator<T>().allocate(n);
+  }
+  void deallocate(T *p, size_t n) {
+    allocated_bytes -= n * sizeof(T);
+    std::allocator<T>().deallocate(p, n);
+  }
+
+  template <typename U>
+  bool operator==(const counting_allocator<U> &) const {
+    return true;
+  }
+  template <typename U>
+  bool operator!=(const counting_allocator<U> &) const {
+    return false;
+  }
+};
+
+template <typename Storage>
+void run(ygm::comm &world, const std::string &name, size_t num_keys) {
+  using map_type =
+      ygmc::map<uint64_t, uint64_t, ygmc::detail::hash_partitioner<uint64_t>,
+                std::less<uint64_t>,
+                counting_allocator<std::pair<const uint64_t, uint64_t>>,
+                Storage>;
+
+  size_t keys_per_rank = num_keys / world.size();
+  {
+    map_type m(world);
+
+    std::mt19937_64 gen(world.rank());
+    world.barrier();
+    ygm::timer build_timer{};
+    for (size_t i = 0; i < keys_per_rank; ++i) {
+      m.async_insert(gen(), i);
+    }
+    // size() is the first read, which completes a flat build
+    size_t global_size = m.size();
+    double build_time  = build_timer.elapsed();
+
+    int64_t global_bytes = world.all_reduce_sum(allocated_bytes);
+
+    gen.seed(world.rank());
+    ygm::timer lookup_timer{};
+    for (size_t i = 0; i < keys_per_rank; ++i) {
+      m.async_visit_if_exists(gen(), [](const auto &kv) {});
+    }
+    world.barrier();
+    double lookup_time = lookup_timer.elapsed();
+
+    world.cout0(name, " bytes per entry: ", double(global_bytes) / global_size);
+    world.cout0(name, " build: ", build_time, " s, ",
+                global_size / build_time, " keys/s");
+    world.cout0(name, " lookup: ", lookup_time, " s, ",
+                global_size / lookup_time, " keys/s");
+  }
+  world.barrier();
+}
+
+int main(int argc, char **argv) {
+  ygm::comm world(&argc, &argv);
+
+  if (argc < 2) {
+    world.cerr0("Please provide the global number of keys");
+    exit(EXIT_FAILURE);
+  }
+
+  size_t num_keys = atoll(argv[1]);
+  world.cout0("Global keys: ", num_keys);
+
+  run<ygmc::detail::tree_storage>(world, "tree", num_keys);
+  run<ygmc::detail::hash_storage>(world, "hash", num_keys);
+  run<ygmc::detail::flat_storage>(world, "flat", num_keys);
+
+  return 0;
+}
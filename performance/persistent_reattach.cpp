@@ -0,0 +1,87 @@
+// Copyright 2019-2021 Lawrence Livermore National Security, LLC and other YGM
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: MIT
+
+#include <filesystem>
+#include <random>
+#include <string>
+#include <ygm/comm.hpp>
+#include <ygm/container/map.hpp>
+#include <ygm/utility.hpp>
+
+// Builds a map<uint64_t, uint64_t> kept in memory-mapped files, then compares
+// reattaching to those files with restoring a binary checkpoint of the same
+// map.
+
+using persistent_map = ygm::container::map<
+    uint64_t, uint64_t, ygm::container::detail::hash_partitioner<uint64_t>,
+    std::less<uint64_t>,
+    ygm::container::detail::mmap_allocator<std::pair<const uint64_t, uint64_t>>,
+    ygm::container::detail::hash_storage>;
+
+int main(int argc, char **argv) {
+  ygm::comm world(&argc, &argv);
+
+  if (argc < 3) {
+    world.cerr0(
+        "Please provide the number of entries per rank and a path prefix for "
+        "the files");
+    exit(EXIT_FAILURE);
+  }
+
+  size_t      num_entries = atoll(argv[1]);
+  std::string prefix      = argv[2];
+  world.cout0("Entries per rank: ", num_entries, ", prefix: ", prefix);
+
+  ygm::container::detail::mmap_file file{prefix + "mmap"};
+  std::string rank_file = file.prefix + std::to_string(world.rank());
+  std::filesystem::remove(rank_file);
+  world.barrier();
+
+  size_t size;
+  {
+    ygm::timer     timer{};
+    persistent_map m(world, file);
+    std::mt19937_64 gen(world.rank());
+    for (size_t i = 0; i < num_entries; ++i) {
+      m.async_insert(gen(), gen());
+    }
+    size = m.size();
+    world.cout0("Build: ", timer.elapsed(), " s");
+
+    timer.reset();
+    m.checkpoint(prefix + "ckpt");
+    world.cout0("Checkpoint: ", timer.elapsed(), " s");
+  }
+
+  {
+    world.barrier();
+    ygm::timer     timer{};
+    persistent_map m(world, file);
+    double         elapsed = timer.elapsed();
+    if (m.size() != size) {
+      world.cerr0("Reattach lost entries");
+    }
+    world.cout0("Reattach: ", elapsed, " s");
+  }
+
+  {
+    world.barrier();
+    ygm::timer                              timer{};
+    ygm::container::map<uint64_t, uint64_t> m(world);
+    m.restore(prefix + "ckpt");
+    double elapsed = timer.elapsed();
+    if (m.size() != size) {
+      world.cerr0("Restore lost entries");
+    }
+    world.cout0("Checkpoint restore: ", elapsed, " s");
+  }
+
+  world.barrier();
+  std::filesystem::remove(rank_file);
+  if (world.rank0()) {
+    std::filesystem::remove(prefix + "ckpt");
+  }
+  return 0;
+}
@@ -0,0 +1,93 @@
+// Copyright 2019-2021 Lawrence Livermore National Security, LLC and other YGM
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: MIT
+
+#include <random>
+#include <unordered_map>
+#include <ygm/comm.hpp>
+#include <ygm/container/adj_list.hpp>
+#include <ygm/container/priority_queue.hpp>
+#include <ygm/utility.hpp>
+
+// Delta-stepping single source shortest paths from vertex 0 on a random
+// undirected graph with edge weights in [1, 100].  The distance checksum
+// should not depend on delta.
+
+using queue_type = ygm::container::priority_queue<uint64_t, uint64_t>;
+
+static queue_type                             *s_queue = nullptr;
+static std::unordered_map<uint64_t, uint64_t> s_dist;
+
+uint64_t weight(uint64_t u, uint64_t v) {
+  uint64_t x = std::min(u, v) * 0x9e3779b97f4a7c15ULL ^ std::max(u, v);
+  x ^= x >> 31;
+  x *= 0xbf58476d1ce4e5b9ULL;
+  x ^= x >> 29;
+  return 1 + x % 100;
+}
+
+int main(int argc, char **argv) {
+  ygm::comm world(&argc, &argv);
+
+  if (argc < 4) {
+    world.cerr0(
+        "Please provide the global number of vertices and edges, and delta");
+    exit(EXIT_FAILURE);
+  }
+
+  uint64_t num_vertices = atoll(argv[1]);
+  uint64_t num_edges    = atoll(argv[2]);
+  uint64_t delta        = atoll(argv[3]);
+  world.cout0("Vertices: ", num_vertices, ", edges: ", num_edges,
+              ", delta: ", delta);
+
+  ygm::container::adj_list<uint64_t> graph(world);
+  std::mt19937_64                    gen(world.rank());
+  for (uint64_t i = 0; i < num_edges / world.size(); ++i) {
+    uint64_t u = gen() % num_vertices;
+    uint64_t v = gen() % num_vertices;
+    graph.async_insert_edge(u, v);
+    graph.async_insert_edge(v, u);
+  }
+  graph.finalize();
+
+  queue_type queue(world, delta);
+  s_queue = &queue;
+
+  world.barrier();
+  ygm::timer timer{};
+  queue.async_push(0, 0);
+  size_t batches{0};
+  while (true) {
+    auto batch = queue.pop_batch();
+    if (queue.current_bucket() == queue.no_bucket) {
+      break;
+    }
+    ++batches;
+    for (const auto &[v, d] : batch) {
+      auto itr = s_dist.find(v);
+      if (itr != s_dist.end() && itr->second <= d) {
+        continue;
+      }
+      s_dist[v] = d;
+      graph.async_visit_neighbors(
+          v,
+          [](uint64_t u, uint64_t w, uint64_t du) {
+            s_queue->async_push(w, du + weight(u, w));
+          },
+          d);
+    }
+  }
+  double elapsed = timer.elapsed();
+
+  uint64_t local_sum{0};
+  for (const auto &[v, d] : s_dist) {
+    local_sum += d;
+  }
+  world.cout0("sssp: ", elapsed, " s, ", batches, " batches, ",
+              world.all_reduce_sum(s_dist.size()), " reached, checksum ",
+              world.all_reduce_sum(local_sum));
+
+  return 0;
+}
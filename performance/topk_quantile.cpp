@@ -0,0 +1,68 @@
+// Copyright 2019-2021 Lawrence Livermore National Security, LLC and other YGM
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: MIT
+
+#include <random>
+#include <vector>
+#include <ygm/comm.hpp>
+#include <ygm/container/bag.hpp>
+#include <ygm/container/map.hpp>
+#include <ygm/utility.hpp>
+
+// Times map::topk, exact median selection and approximate percentiles over a
+// global number of random values.  The reference runs use k = 100000.
+
+int main(int argc, char **argv) {
+  ygm::comm world(&argc, &argv);
+
+  if (argc < 3) {
+    world.cerr0("Please provide the global number of values and k");
+    exit(EXIT_FAILURE);
+  }
+
+  size_t num_values = atoll(argv[1]);
+  size_t k          = atoll(argv[2]);
+  world.cout0("Global values: ", num_values);
+  world.cout0("k: ", k);
+
+  ygm::container::map<uint64_t, uint64_t> m(world);
+  ygm::container::bag<uint64_t>           b(world);
+  std::mt19937_64                         gen(world.rank());
+  for (uint64_t i = world.rank(); i < num_values; i += world.size()) {
+    uint64_t value = gen();
+    m.async_insert(i, value);
+    b.async_insert(value);
+  }
+  world.barrier();
+
+  auto by_value = [](const auto &a, const auto &b) {
+    return a.second > b.second;
+  };
+
+  world.barrier();
+  ygm::timer topk_timer{};
+  auto       top = m.topk(k, by_value);
+  world.cout0("map topk: ", topk_timer.elapsed(), " s, ", top.size(),
+              " results");
+
+  world.barrier();
+  ygm::timer bag_topk_timer{};
+  auto       bag_top = b.topk(k);
+  world.cout0("bag topk: ", bag_topk_timer.elapsed(), " s");
+  ASSERT_RELEASE(bag_top.size() == top.size());
+  ASSERT_RELEASE(bag_top.back() == top.back().second);
+
+  world.barrier();
+  ygm::timer select_timer{};
+  auto       median = b.nth_element(num_values / 2);
+  world.cout0("bag nth_element: ", select_timer.elapsed(), " s");
+
+  world.barrier();
+  ygm::timer sketch_timer{};
+  auto       approx = b.approx_quantiles({0.01, 0.5, 0.99});
+  world.cout0("bag approx_quantiles: ", sketch_timer.elapsed(), " s");
+  world.cout0("Exact median: ", median, ", approximate median: ", approx[1]);
+
+  return 0;
+}
@@ -0,0 +1,85 @@
+// Copyright 2019-2021 Lawrence Livermore National Security, LLC and other YGM
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: MIT
+
+#undef NDEBUG
+#include <ygm/comm.hpp>
+#include <ygm/container/adj_list.hpp>
+
+static size_t visited;
+
+int main(int argc, char **argv) {
+  ygm::comm world(&argc, &argv);
+
+  //
+  // Test ring
+  {
+    ygm::container::adj_list<size_t> graph(world);
+    size_t                           num_vertices = 1000;
+    for (size_t u = world.rank(); u < num_vertices; u += world.size()) {
+      graph.async_insert_edge(u, (u + 1) % num_vertices);
+    }
+    ASSERT_RELEASE(graph.num_edges() == num_vertices);
+    ASSERT_RELEASE(graph.num_vertices() == num_vertices);
+    graph.for_all_edges([&graph, num_vertices](size_t u, size_t v) {
+      ASSERT_RELEASE(graph.owner(u) == graph.comm().rank());
+      ASSERT_RELEASE(v == (u + 1) % num_vertices);
+    });
+
+    visited = 0;
+    if (world.rank() == 0) {
+      graph.async_visit_neighbors(17, [](size_t u, size_t v) {
+        ASSERT_RELEASE(u == 17 && v == 18);
+        ++visited;
+      });
+    }
+    world.barrier();
+    ASSERT_RELEASE(world.all_reduce_sum(visited) == 1);
+
+    // Edges added after a finalize are merged by the next one
+    if (world.rank() == 0) {
+      graph.async_insert_edge(17, 500);
+    }
+    ASSERT_RELEASE(graph.num_edges() == num_vertices + 1);
+  }
+
+  //
+  // Test delegated hub
+  {
+    ygm::container::adj_list<size_t> graph(world, 100);
+    size_t                           num_leaves = 1000;
+    for (size_t v = world.rank(); v < num_leaves; v += world.size()) {
+      graph.async_insert_edge(0, v + 1);
+      graph.async_insert_edge(v + 1, 0);
+    }
+    ASSERT_RELEASE(graph.num_edges() == 2 * num_leaves);
+    ASSERT_RELEASE(graph.delegates().size() == 1);
+    ASSERT_RELEASE(graph.is_delegated(0));
+    ASSERT_RELEASE(graph.num_vertices() == num_leaves + 1);
+
+    // Hub edges sit with the owners of their targets
+    graph.for_all_edges([&graph](size_t u, size_t v) {
+      if (u == 0) {
+        ASSERT_RELEASE(graph.owner(v) == graph.comm().rank());
+      } else {
+        ASSERT_RELEASE(graph.owner(u) == graph.comm().rank());
+      }
+    });
+
+    // Later hub edges go straight to the target's owner
+    if (world.rank() == 0) {
+      graph.async_insert_edge(0, num_leaves + 1);
+    }
+    ASSERT_RELEASE(graph.num_edges() == 2 * num_leaves + 1);
+
+    visited = 0;
+    graph.async_visit_neighbors(0, [](auto padj, int from, size_t u,
+                                      size_t v) { ++visited; });
+    world.barrier();
+    ASSERT_RELEASE(world.all_reduce_sum(visited) ==
+                   (num_leaves + 1) * world.size());
+  }
+
+  return 0;
+}
@@ -0,0 +1,87 @@
+// Copyright 2019-2021 Lawrence Livermore National Security, LLC and other YGM
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: MIT
+
+#undef NDEBUG
+#include <string>
+
+#include <ygm/comm.hpp>
+#include <ygm/container/array.hpp>
+
+namespace ygmc = ygm::container;
+
+template <typename Partitioner>
+void run_tests(ygm::comm &world) {
+  //
+  // Test set and for_all
+  {
+    ygmc::array<int, Partitioner> arr(world, 1000);
+    ASSERT_RELEASE(arr.size() == 1000);
+    if (world.rank() == 0) {
+      for (size_t i = 0; i < arr.size(); ++i) {
+        arr.async_set(i, 2 * i);
+      }
+    }
+
+    size_t local_count{0};
+    arr.for_all([&local_count, &arr](size_t index, int value) {
+      ASSERT_RELEASE(arr.is_mine(index));
+      ASSERT_RELEASE(value == 2 * index);
+      ++local_count;
+    });
+    ASSERT_RELEASE(world.all_reduce_sum(local_count) == 1000);
+  }
+
+  //
+  // Test reduce and visit
+  {
+    ygmc::array<size_t, Partitioner> arr(world, 37);
+    for (size_t i = 0; i < arr.size(); ++i) {
+      arr.async_reduce(i, i, [](size_t a, size_t b) { return a + b; });
+    }
+    arr.for_all([&world](size_t index, size_t value) {
+      ASSERT_RELEASE(value == index * world.size());
+    });
+
+    arr.async_visit(5, [](size_t index, size_t &value, size_t add) {
+      value += add;
+    }, size_t(1));
+    arr.for_all([&world](size_t index, size_t value) {
+      ASSERT_RELEASE(value == index * world.size() + (index == 5) * world.size());
+    });
+  }
+
+  //
+  // Test resize keeps values and fills new elements
+  {
+    ygmc::array<std::string, Partitioner> arr(world, 10, "none");
+    if (world.rank() == 0) {
+      for (size_t i = 0; i < arr.size(); ++i) {
+        arr.async_set(i, std::to_string(i));
+      }
+    }
+    arr.resize(1000, "new");
+    ASSERT_RELEASE(arr.size() == 1000);
+    arr.for_all([](size_t index, const std::string &value) {
+      ASSERT_RELEASE(value == (index < 10 ? std::to_string(index) : "new"));
+    });
+
+    arr.resize(5);
+    size_t local_count{0};
+    arr.for_all([&local_count](size_t index, const std::string &value) {
+      ASSERT_RELEASE(value == std::to_string(index));
+      ++local_count;
+    });
+    ASSERT_RELEASE(world.all_reduce_sum(local_count) == 5);
+  }
+}
+
+int main(int argc, char **argv) {
+  ygm::comm world(&argc, &argv);
+
+  run_tests<ygmc::detail::block_partitioner>(world);
+  run_tests<ygmc::detail::cyclic_partitioner>(world);
+
+  return 0;
+}
@@ -0,0 +1,63 @@
+// Copyright 2019-2021 Lawrence Livermore National Security, LLC and other YGM
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: MIT
+
+#undef NDEBUG
+#include <string>
+#include <vector>
+#include <ygm/comm.hpp>
+#include <ygm/detail/ygm_ptr.hpp>
+
+int main(int argc, char** argv) {
+  ygm::comm world(&argc, &argv);
+
+  //
+  // Test calls returning the remote rank
+  {
+    std::vector<ygm::future<int>> futures;
+    for (int dest = 0; dest < world.size(); ++dest) {
+      futures.push_back(world.async_call(
+          dest, [](auto pcomm, int from) { return pcomm->rank(); }));
+    }
+    for (int dest = 0; dest < world.size(); ++dest) {
+      ASSERT_RELEASE(futures[dest].valid());
+      ASSERT_RELEASE(futures[dest].get() == dest);
+    }
+  }
+
+  //
+  // Test remote lookups into a local table
+  {
+    std::vector<std::string>                table(10);
+    ygm::ygm_ptr<std::vector<std::string>> ptable(&table);
+    for (size_t i = 0; i < table.size(); ++i) {
+      table[i] = std::to_string(world.rank()) + ":" + std::to_string(i);
+    }
+    world.barrier();
+
+    int  dest = (world.rank() + 1) % world.size();
+    auto f    = world.async_call(
+        dest, [](auto ptable, size_t i) { return (*ptable)[i]; }, ptable,
+        size_t(3));
+    ASSERT_RELEASE(f.get() == std::to_string(dest) + ":3");
+  }
+
+  //
+  // Test futures resolved by barrier
+  {
+    std::vector<ygm::future<size_t>> futures;
+    for (size_t i = 0; i < 1000; ++i) {
+      futures.push_back(world.async_call(
+          i % world.size(), [](size_t a, size_t b) { return a * b; }, i,
+          size_t(2)));
+    }
+    world.barrier();
+    for (size_t i = 0; i < futures.size(); ++i) {
+      ASSERT_RELEASE(futures[i].ready());
+      ASSERT_RELEASE(futures[i].get() == 2 * i);
+    }
+  }
+
+  return 0;
+}
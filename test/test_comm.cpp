@@ -4,9 +4,34 @@
 // SPDX-License-Identifier: MIT
 
 #undef NDEBUG
+#include <chrono>
+#include <thread>
 #include <ygm/comm.hpp>
 #include <ygm/detail/ygm_ptr.hpp>
 
+static size_t chain_hops = 0;
+
+// Last hops of the chain: rank 2 forwards once more to rank 0
+struct chain_tail {
+  template <typename Comm>
+  void operator()(Comm* pcomm, int from) {
+    ++chain_hops;
+    if (pcomm->rank() == 2) {
+      pcomm->async(0, chain_tail());
+    }
+  }
+};
+
+// First hop of the chain: rank 1 forwards to ranks 2 and 3
+struct chain_head {
+  template <typename Comm>
+  void operator()(Comm* pcomm, int from) {
+    ++chain_hops;
+    pcomm->async(2, chain_tail());
+    pcomm->async(3, chain_tail());
+  }
+};
+
 int main(int argc, char** argv) {
   ygm::comm world(&argc, &argv);
 
@@ -71,5 +96,36 @@ int main(int argc, char** argv) {
     });
     ASSERT_RELEASE(red2 == world.size() - 1);
   }
+
+  //
+  // Test buffer pool counters
+  {
+    ASSERT_RELEASE(world.local_buffer_pool_misses() > 0);
+    ASSERT_RELEASE(world.local_peak_buffer_bytes() > 0);
+    ASSERT_RELEASE(world.global_peak_buffer_bytes() >=
+                   world.local_peak_buffer_bytes());
+    world.reset_buffer_pool_counters();
+    ASSERT_RELEASE(world.local_buffer_pool_hits() == 0);
+    ASSERT_RELEASE(world.local_buffer_pool_misses() == 0);
+  }
+
+  //
+  // Test barrier with a chain of forwarded messages spanning its first
+  // check.  Ranks 0 and 1 handle hops after their first snapshot while
+  // ranks 2 and 3 handle theirs before it, so the first sum balances even
+  // though the chain is still moving.
+  if (world.size() >= 4) {
+    for (int round = 0; round < 4; ++round) {
+      chain_hops = 0;
+      if (world.rank() == 0) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        world.async(1, chain_head());
+      } else if (world.rank() == 2 || world.rank() == 3) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(150));
+      }
+      world.barrier();
+      ASSERT_RELEASE(world.all_reduce_sum(chain_hops) == 4);
+    }
+  }
   return 0;
 }
\ No newline at end of file
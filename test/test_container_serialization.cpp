@@ -9,6 +9,7 @@
 #include <ygm/container/bag.hpp>
 #include <ygm/container/map.hpp>
 #include <ygm/container/counting_set.hpp>
+#include <algorithm>
 
 int main(int argc, char** argv) {
   ygm::comm world(&argc, &argv);
@@ -201,5 +202,187 @@ smap.serialize("serialization_test.mmap");
     ASSERT_RELEASE(reloaded_cset.count_all() == 3 * world.size());
   }
 }
+
+//
+// Test bag checkpoint
+{
+  {
+    ygm::container::bag<int> my_bag(world);
+    for (int i = 0; i < 100; ++i) {
+      my_bag.async_insert(i);
+    }
+    my_bag.checkpoint("checkpoint_test.bag");
+  }
+  ygm::container::bag<int> reloaded_bag(world);
+  reloaded_bag.async_insert(-1);
+  reloaded_bag.restore("checkpoint_test.bag");
+  ASSERT_RELEASE(reloaded_bag.size() == 100 * world.size());
+  int64_t local_sum{0};
+  reloaded_bag.for_all([&local_sum](int i) { local_sum += i; });
+  ASSERT_RELEASE(world.all_reduce_sum(local_sum) == 4950 * world.size());
+}
+
+//
+// Test set and multiset checkpoint
+{
+  {
+    ygm::container::set<int>      my_set(world);
+    ygm::container::multiset<int> my_mset(world);
+    my_set.async_insert(world.rank());
+    my_set.async_insert(42);
+    my_mset.async_insert(42);
+    my_set.checkpoint("checkpoint_test.set");
+    my_mset.checkpoint("checkpoint_test.mset");
+  }
+  ygm::container::set<int>      reloaded_set(world);
+  ygm::container::multiset<int> reloaded_mset(world);
+  reloaded_set.restore("checkpoint_test.set");
+  reloaded_mset.restore("checkpoint_test.mset");
+  ASSERT_RELEASE(reloaded_set.size() == world.size() + (world.size() <= 42));
+  ASSERT_RELEASE(reloaded_set.count(42) == 1);
+  ASSERT_RELEASE(reloaded_mset.count(42) == world.size());
+}
+
+//
+// Test map, multimap and counting_set checkpoint
+{
+  {
+    ygm::container::map<std::string, std::string> smap(world, "default");
+    ygm::container::multimap<int, std::string>     mmap(world);
+    ygm::container::counting_set<std::string>      cset(world);
+    for (int i = 0; i < 1000; ++i) {
+      smap.async_insert("key" + std::to_string(i), std::to_string(i));
+      mmap.async_insert(i % 10, std::to_string(i));
+      cset.async_insert("key" + std::to_string(i % 7));
+    }
+    smap.checkpoint("checkpoint_test.map");
+    mmap.checkpoint("checkpoint_test.mmap");
+    cset.checkpoint("checkpoint_test.cset");
+  }
+  ygm::container::map<std::string, std::string> reloaded_map(world);
+  ygm::container::multimap<int, std::string>     reloaded_mmap(world);
+  ygm::container::counting_set<std::string>      reloaded_cset(world);
+  reloaded_map.restore("checkpoint_test.map");
+  reloaded_mmap.restore("checkpoint_test.mmap");
+  reloaded_cset.restore("checkpoint_test.cset");
+  ASSERT_RELEASE(reloaded_map.size() == 1000);
+  for (int i = 0; i < 1000; i += 37) {
+    std::string key = "key" + std::to_string(i);
+    if (reloaded_map.is_mine(key)) {
+      ASSERT_RELEASE(reloaded_map.local_get(key) ==
+                     std::vector<std::string>{std::to_string(i)});
+    }
+  }
+  // The default value is restored too
+  reloaded_map.async_visit("absent", [](auto &kv) {
+    ASSERT_RELEASE(kv.second == "default");
+  });
+  ASSERT_RELEASE(reloaded_mmap.size() == 1000 * world.size());
+  ASSERT_RELEASE(reloaded_mmap.count(3) == 100 * world.size());
+  ASSERT_RELEASE(reloaded_cset.count("key3") ==
+                 (1000 / 7 + (3 < 1000 % 7)) * world.size());
+}
+
+//
+// Test streaming records through blocks larger than the read buffer
+{
+  namespace ygmd = ygm::container::detail;
+  {
+    ygmd::checkpoint_writer writer(world, 100);
+    writer.meta(std::string("meta"), world.rank());
+    for (int i = 0; i < 10000; ++i) {
+      writer.record(i, std::string(i % 50, 'x'));
+    }
+    writer.write("checkpoint_test.raw");
+  }
+  world.barrier();
+  ygmd::checkpoint_reader reader(world, "checkpoint_test.raw", 64);
+  ASSERT_RELEASE(reader.num_ranks() == world.size());
+  std::string meta;
+  int         rank;
+  reader.read_meta(world.size() - 1 - world.rank(), meta, rank);
+  ASSERT_RELEASE(meta == "meta" && rank == world.size() - 1 - world.rank());
+  int next{0};
+  reader.for_each_record<int, std::string>(
+      world.rank(), [&next](int &i, std::string &s) {
+        ASSERT_RELEASE(i == next++);
+        ASSERT_RELEASE(s == std::string(i % 50, 'x'));
+      });
+  ASSERT_RELEASE(next == 10000);
+  ASSERT_RELEASE(reader.index()[world.rank()].records == 10000);
+}
+
+//
+// Test restoring checkpoints onto a different number of ranks
+{
+  // Both halves build the same containers so every rank creates them in the
+  // same order; only the first half's files are restored
+  int      half  = std::max(1, world.size() / 2);
+  int      color = world.rank() < half ? 0 : 1;
+  MPI_Comm half_mpi;
+  MPI_Comm_split(MPI_COMM_WORLD, color, world.rank(), &half_mpi);
+
+  // Written by half the ranks, restored by all
+  {
+    std::string prefix = "checkpoint_test.resize" + std::to_string(color);
+    ygm::comm                             half_comm(half_mpi);
+    ygm::container::map<int, std::string> imap(half_comm, "none");
+    ygm::container::multimap<int, int>    mmap(half_comm);
+    ygm::container::set<std::string>      sset(half_comm);
+    ygm::container::bag<int>              ibag(half_comm);
+    for (int i = half_comm.rank(); i < 1000; i += half_comm.size()) {
+      imap.async_insert(i, std::to_string(i));
+      mmap.async_insert(i % 10, i);
+      sset.async_insert("key" + std::to_string(i % 100));
+      ibag.async_insert(i);
+    }
+    imap.checkpoint(prefix + ".map");
+    mmap.checkpoint(prefix + ".mmap");
+    sset.checkpoint(prefix + ".set");
+    ibag.checkpoint(prefix + ".bag");
+  }
+  world.barrier();
+  {
+    ygm::container::map<int, std::string> imap(world);
+    ygm::container::multimap<int, int>    mmap(world);
+    ygm::container::set<std::string>      sset(world);
+    ygm::container::bag<int>              ibag(world);
+    imap.restore("checkpoint_test.resize0.map");
+    mmap.restore("checkpoint_test.resize0.mmap");
+    sset.restore("checkpoint_test.resize0.set");
+    ibag.restore("checkpoint_test.resize0.bag");
+
+    ASSERT_RELEASE(imap.size() == 1000);
+    size_t local{0};
+    imap.for_all([&imap, &local](const auto &kv) {
+      ASSERT_RELEASE(imap.is_mine(kv.first));
+      ASSERT_RELEASE(kv.second == std::to_string(kv.first));
+      ++local;
+    });
+    imap.async_visit(-1, [](auto &kv) { ASSERT_RELEASE(kv.second == "none"); });
+    ASSERT_RELEASE(mmap.size() == 1000);
+    ASSERT_RELEASE(mmap.count(7) == 100);
+    ASSERT_RELEASE(sset.size() == 100);
+    ASSERT_RELEASE(sset.count("key42") == 1);
+    ASSERT_RELEASE(ibag.size() == 1000);
+    size_t bag_local{0};
+    ibag.for_all([&bag_local](int) { ++bag_local; });
+    ASSERT_RELEASE(bag_local >= 1000 / world.size() - 1);
+
+    // Written by all ranks, restored by half
+    imap.checkpoint("checkpoint_test.resize.map");
+  }
+  {
+    ygm::comm                             half_comm(half_mpi);
+    ygm::container::map<int, std::string> imap(half_comm);
+    imap.restore("checkpoint_test.resize.map");
+    ASSERT_RELEASE(imap.size() == 1001);
+    imap.for_all([&imap](const auto &kv) {
+      ASSERT_RELEASE(imap.is_mine(kv.first));
+    });
+  }
+  MPI_Comm_free(&half_mpi);
+  world.barrier();
+}
 return 0;
 }
@@ -0,0 +1,55 @@
+// Copyright 2019-2021 Lawrence Livermore National Security, LLC and other YGM
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: MIT
+
+#undef NDEBUG
+#include <vector>
+#include <ygm/comm.hpp>
+#include <ygm/detail/ygm_ptr.hpp>
+
+static size_t tasks_completed = 0;
+
+// Two dependent remote lookups followed by a local update
+ygm::task two_hop_lookup(ygm::comm& world,
+                         ygm::ygm_ptr<std::vector<int>> ptable, size_t start) {
+  auto lookup = [](auto pcomm, int from, auto ptable, size_t index) {
+    return std::make_pair(pcomm->rank(), (*ptable)[index]);
+  };
+
+  int  first_dest = start % world.size();
+  auto first      = co_await world.remote(first_dest, lookup, ptable, start);
+  ASSERT_RELEASE(first.first == first_dest);
+
+  int  second_dest = (first.second + 1) % world.size();
+  auto second      = co_await world.remote(second_dest, lookup, ptable,
+                                      size_t(first.second));
+  ASSERT_RELEASE(second.first == second_dest);
+  ASSERT_RELEASE(second.second == first.second);
+
+  ++tasks_completed;
+}
+
+int main(int argc, char** argv) {
+  ygm::comm world(&argc, &argv);
+
+  //
+  // Test thousands of in-flight tasks per rank
+  {
+    size_t                         num_tasks = 10000;
+    std::vector<int>               table(num_tasks);
+    ygm::ygm_ptr<std::vector<int>> ptable(&table);
+    for (size_t i = 0; i < num_tasks; ++i) {
+      table[i] = i;
+    }
+    world.barrier();
+
+    for (size_t i = 0; i < num_tasks; ++i) {
+      two_hop_lookup(world, ptable, i);
+    }
+    world.barrier();
+    ASSERT_RELEASE(tasks_completed == num_tasks);
+  }
+
+  return 0;
+}
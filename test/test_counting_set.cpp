@@ -55,5 +55,41 @@ int main(int argc, char **argv) {
     ASSERT_RELEASE(cset.count_all() == 3 * world.size());
   }
 
+  //
+  // Test cache evictions, resizing and statistics
+  {
+    size_t num_keys = 1000;
+    size_t inserts  = 20000;
+    ygm::container::counting_set<size_t> cset(world, 16, 4);
+    for (size_t i = 0; i < inserts; ++i) {
+      // Key 0 is hot; the rest collide with it in a small cache
+      cset.async_insert(i % 2 == 0 ? 0 : i % num_keys);
+      if (i == inserts / 2) {
+        cset.resize_cache(64, 2);
+      }
+    }
+    const auto &stats = cset.cache_stats();
+    ASSERT_RELEASE(stats.hits + stats.misses == inserts);
+    ASSERT_RELEASE(stats.evictions > 0);
+    ASSERT_RELEASE(stats.hit_rate() > 0.45);
+
+    ASSERT_RELEASE(cset.count_all() == inserts * world.size());
+    ASSERT_RELEASE(cset.count(0) == (inserts / 2) * world.size());
+    ASSERT_RELEASE(cset.count(1) == (inserts / num_keys) * world.size());
+    ASSERT_RELEASE(cset.size() == num_keys / 2 + 1);
+  }
+
+  //
+  // Test uncached counting_set
+  {
+    ygm::container::counting_set<std::string> cset(world, 0);
+    cset.async_insert("dog");
+    cset.async_insert("dog");
+    cset.async_insert("cat");
+    ASSERT_RELEASE(cset.cache_stats().hits == 0);
+    ASSERT_RELEASE(cset.count("dog") == 2 * world.size());
+    ASSERT_RELEASE(cset.count("cat") == world.size());
+  }
+
   return 0;
 }
@@ -0,0 +1,113 @@
+// Copyright 2019-2021 Lawrence Livermore National Security, LLC and other YGM
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: MIT
+
+#undef NDEBUG
+#include <numeric>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <ygm/comm.hpp>
+#include <ygm/container/disjoint_set.hpp>
+
+// Sequential union-find for reference
+size_t find_root(std::vector<size_t> &parent, size_t x) {
+  while (parent[x] != x) {
+    x = parent[x] = parent[parent[x]];
+  }
+  return x;
+}
+
+int main(int argc, char **argv) {
+  ygm::comm world(&argc, &argv);
+
+  //
+  // Test a chain collapses to one set
+  {
+    ygm::container::disjoint_set<size_t> dset(world);
+    size_t                               num_items = 1000;
+    for (size_t i = world.rank(); i + 1 < num_items; i += world.size()) {
+      dset.async_union(i, i + 1);
+    }
+    ASSERT_RELEASE(dset.size() == num_items);
+    ASSERT_RELEASE(dset.num_sets() == 1);
+
+    size_t root = dset.all_find(std::vector<size_t>{0}).at(0);
+    dset.for_all([root](size_t item, size_t item_root) {
+      ASSERT_RELEASE(item_root == root);
+    });
+  }
+
+  //
+  // Test random unions against a sequential reference
+  {
+    ygm::container::disjoint_set<size_t> dset(world);
+    size_t                               num_items = 5000;
+    size_t                               num_edges = 3000;
+
+    std::mt19937                          gen(42);
+    std::uniform_int_distribution<size_t> dist(0, num_items - 1);
+    std::vector<size_t>                   parent(num_items);
+    std::iota(parent.begin(), parent.end(), 0);
+    for (size_t i = 0; i < num_edges; ++i) {
+      size_t a = dist(gen);
+      size_t b = dist(gen);
+      if (i % world.size() == size_t(world.rank())) {
+        dset.async_union(a, b);
+      }
+      parent[find_root(parent, a)] = find_root(parent, b);
+    }
+    // Make every item present
+    for (size_t i = world.rank(); i < num_items; i += world.size()) {
+      dset.async_union(i, i);
+    }
+
+    size_t expected_sets{0};
+    for (size_t i = 0; i < num_items; ++i) {
+      expected_sets += find_root(parent, i) == i;
+    }
+    ASSERT_RELEASE(dset.num_sets() == expected_sets);
+
+    std::vector<size_t> items(num_items);
+    std::iota(items.begin(), items.end(), 0);
+    auto roots = dset.all_find(items);
+    ASSERT_RELEASE(roots.size() == num_items);
+    for (size_t i = 1; i < num_items; ++i) {
+      bool same     = roots[i] == roots[i - 1];
+      bool expected = find_root(parent, i) == find_root(parent, i - 1);
+      ASSERT_RELEASE(same == expected);
+    }
+  }
+
+  //
+  // Test async_find and string items
+  {
+    ygm::container::disjoint_set<std::string> dset(world);
+    if (world.rank() == 0) {
+      dset.async_union("cat", "dog");
+      dset.async_union("red", "blue");
+      dset.async_union("dog", "mouse");
+    }
+    world.barrier();
+
+    if (world.rank() == 0) {
+      dset.async_find("mouse",
+                      [](auto pdset, int from, const std::string &item,
+                         const std::string &root) {
+                        ASSERT_RELEASE(item == "mouse");
+                        ASSERT_RELEASE(pdset->owner(root) ==
+                                       pdset->comm().rank());
+                      });
+    }
+    world.barrier();
+
+    auto roots = dset.all_find(std::vector<std::string>{"cat", "mouse", "red"});
+    ASSERT_RELEASE(roots["cat"] == roots["mouse"]);
+    ASSERT_RELEASE(roots["cat"] != roots["red"]);
+    ASSERT_RELEASE(dset.num_sets() == 2);
+  }
+
+  return 0;
+}
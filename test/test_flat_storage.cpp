@@ -0,0 +1,183 @@
+// Copyright 2019-2021 Lawrence Livermore National Security, LLC and other YGM
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: MIT
+
+#undef NDEBUG
+#include <map>
+#include <random>
+#include <string>
+
+#include <ygm/comm.hpp>
+#include <ygm/container/map.hpp>
+#include <ygm/container/set.hpp>
+
+namespace ygmc = ygm::container;
+
+template <typename Key, typename Value>
+using flat_map = ygmc::map<Key, Value, ygmc::detail::hash_partitioner<Key>,
+                           std::less<Key>,
+                           std::allocator<std::pair<const Key, Value>>,
+                           ygmc::detail::flat_storage>;
+
+template <typename Key, typename Value>
+using flat_multimap =
+    ygmc::multimap<Key, Value, ygmc::detail::hash_partitioner<Key>,
+                   std::less<Key>, std::allocator<std::pair<const Key, Value>>,
+                   ygmc::detail::flat_storage>;
+
+template <typename Key>
+using flat_set =
+    ygmc::set<Key, ygmc::detail::hash_partitioner<Key>, std::less<Key>,
+              std::allocator<const Key>, ygmc::detail::flat_storage>;
+
+int main(int argc, char **argv) {
+  ygm::comm world(&argc, &argv);
+
+  //
+  // Test local flat table against std::multimap
+  {
+    ygmc::detail::flat_multimap<int, int> table;
+    std::multimap<int, int>               reference;
+    std::mt19937                          gen(world.rank());
+    std::uniform_int_distribution<int>    dist(0, 9999);
+    for (int round = 0; round < 5; ++round) {
+      for (int i = 0; i < 20000; ++i) {
+        int key = dist(gen);
+        table.insert(std::make_pair(key, i));
+        reference.insert(std::make_pair(key, i));
+      }
+      for (int i = 0; i < 100; ++i) {
+        int key = dist(gen);
+        ASSERT_RELEASE(table.erase(key) == reference.erase(key));
+      }
+      ASSERT_RELEASE(table.size() == reference.size());
+      for (int key = 0; key < 10000; key += 7) {
+        ASSERT_RELEASE(table.count(key) == reference.count(key));
+      }
+    }
+    ASSERT_RELEASE(std::equal(
+        table.begin(), table.end(), reference.begin(),
+        [](const auto &a, const auto &b) { return a.first == b.first; }));
+    ASSERT_RELEASE(table.find(-1) == table.end());
+    ASSERT_RELEASE(table.find(10000) == table.end());
+  }
+
+  //
+  // Test pending operations resolve in insertion order
+  {
+    ygmc::detail::flat_multimap<int, int> table;
+    table.insert(std::make_pair(1, 1));
+    table.insert(std::make_pair(1, 2));
+    table.assign(1, 3);
+    table.insert_if_absent(1, 4);
+    table.insert_if_absent(2, 5);
+    table.insert(std::make_pair(2, 6));
+    ASSERT_RELEASE(table.count(1) == 1);
+    ASSERT_RELEASE(table.find(1)->second == 3);
+    ASSERT_RELEASE(table.count(2) == 2);
+
+    table.assign(2, 7);
+    ASSERT_RELEASE(table.count(2) == 1);
+    ASSERT_RELEASE(table.find(2)->second == 7);
+  }
+
+  //
+  // Test map
+  {
+    flat_map<std::string, std::string> smap(world);
+    if (world.rank() == 0) {
+      smap.async_insert("dog", "cat");
+      smap.async_insert("apple", "orange");
+      smap.async_insert("red", "green");
+    }
+    smap.async_insert("dog", "mouse");
+    ASSERT_RELEASE(smap.size() == 3);
+    ASSERT_RELEASE(smap.count("dog") == 1);
+    ASSERT_RELEASE(smap.count("blue") == 0);
+
+    smap.async_visit("blue", [](auto &kv) { kv.second = "purple"; });
+    auto gathered = smap.all_gather({"blue", "apple", "dog"});
+    ASSERT_RELEASE(gathered["blue"] == "purple");
+    ASSERT_RELEASE(gathered["apple"] == "orange");
+    ASSERT_RELEASE(gathered["dog"] == "mouse");
+  }
+
+  //
+  // Test visitors inserting into the map they visit, then writing the
+  // visited value
+  {
+    flat_map<size_t, size_t> smap(world);
+    size_t                   num_keys = 1000;
+    size_t                   copies   = 8;
+    for (size_t i = world.rank(); i < num_keys; i += world.size()) {
+      smap.async_insert(i, 0);
+    }
+    world.barrier();
+    for (size_t i = world.rank(); i < num_keys; i += world.size()) {
+      smap.async_visit(
+          i,
+          [](auto pmap, int from, auto &kv, size_t num_keys, size_t copies) {
+            for (size_t c = 1; c <= copies; ++c) {
+              pmap->async_insert_unique(kv.first + c * num_keys, 2);
+            }
+            kv.second = 1;
+          },
+          num_keys, copies);
+    }
+    // Visits of absent keys insert them and must see them afterwards
+    for (size_t i = world.rank(); i < num_keys; i += world.size()) {
+      smap.async_visit(
+          i + (copies + 1) * num_keys,
+          [](auto pmap, int from, auto &kv, size_t offset) {
+            pmap->async_insert_unique(kv.first + offset, 2);
+            kv.second = 1;
+          },
+          num_keys);
+    }
+    ASSERT_RELEASE(smap.size() == (copies + 3) * num_keys);
+
+    size_t local_wrong{0};
+    smap.for_all([&local_wrong, num_keys, copies](const auto &kv) {
+      bool visited = kv.first < num_keys ||
+                     (kv.first >= (copies + 1) * num_keys &&
+                      kv.first < (copies + 2) * num_keys);
+      if (kv.second != (visited ? 1 : 2)) {
+        ++local_wrong;
+      }
+    });
+    ASSERT_RELEASE(world.all_reduce_sum(local_wrong) == 0);
+  }
+
+  //
+  // Test multimap
+  {
+    flat_multimap<size_t, size_t> smap(world);
+    for (size_t i = 0; i < 1000; ++i) {
+      smap.async_insert(i, world.rank());
+    }
+    ASSERT_RELEASE(smap.size() == 1000 * world.size());
+    ASSERT_RELEASE(smap.count(17) == world.size());
+
+    if (world.rank() == 0) {
+      smap.async_erase(17);
+    }
+    ASSERT_RELEASE(smap.count(17) == 0);
+    ASSERT_RELEASE(smap.size() == 999 * world.size());
+  }
+
+  //
+  // Test set
+  {
+    flat_set<std::string> sset(world);
+    sset.async_insert("dog");
+    sset.async_insert("apple");
+    sset.async_insert("red");
+    ASSERT_RELEASE(sset.size() == 3);
+    ASSERT_RELEASE(sset.count("apple") == 1);
+    sset.async_erase("apple");
+    ASSERT_RELEASE(sset.count("apple") == 0);
+  }
+
+  return 0;
+}
@@ -0,0 +1,74 @@
+// Copyright 2019-2021 Lawrence Livermore National Security, LLC and other YGM
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: MIT
+
+#undef NDEBUG
+#include <ygm/comm.hpp>
+#include <ygm/detail/ygm_ptr.hpp>
+
+int main(int argc, char** argv) {
+  // Create comm with small buffers and the smallest allowed credit budget
+  ygm::comm world(&argc, &argv, 64, 128);
+
+  int64_t hot_rank_waits{0};
+
+  //
+  // Test all ranks sending to a single hot rank
+  {
+    size_t               num_msgs = 10000;
+    size_t               counter{};
+    ygm::ygm_ptr<size_t> pcounter(&counter);
+    for (size_t i = 0; i < num_msgs; ++i) {
+      world.async(
+          0, [](auto pcomm, int from, auto pcounter) { (*pcounter)++; },
+          pcounter);
+    }
+    world.barrier();
+    if (world.rank0()) {
+      ASSERT_RELEASE(counter == num_msgs * world.size());
+    } else {
+      ASSERT_RELEASE(counter == 0);
+    }
+    // Senders outrun rank 0's credit budget and must wait for credit
+    hot_rank_waits = world.local_credit_waits();
+    if (world.size() > 1 && world.rank() != 0) {
+      ASSERT_RELEASE(hot_rank_waits > 0);
+    }
+  }
+
+  //
+  // Test large messages larger than the credit budget
+  {
+    size_t               large_msg_size = 1024;
+    size_t               counter{};
+    ygm::ygm_ptr<size_t> pcounter(&counter);
+    std::vector<size_t>  large_msg(large_msg_size);
+    for (int i = 0; i < 10; ++i) {
+      world.async(
+          0,
+          [](auto pcomm, int from, auto pcounter,
+             const std::vector<size_t>& vec) { (*pcounter) += vec.size(); },
+          pcounter, large_msg);
+    }
+    world.barrier();
+    if (world.rank0()) {
+      ASSERT_RELEASE(counter == 10 * large_msg_size * world.size());
+    }
+  }
+
+  //
+  // Test credit wait counters
+  {
+    ASSERT_RELEASE(world.local_credit_waits() >= hot_rank_waits);
+    ASSERT_RELEASE(world.local_credit_wait_time() >= 0);
+    if (world.size() > 1) {
+      ASSERT_RELEASE(world.global_credit_wait_time() > 0);
+    }
+    world.reset_credit_wait_counters();
+    ASSERT_RELEASE(world.local_credit_waits() == 0);
+    ASSERT_RELEASE(world.global_credit_wait_time() == 0);
+  }
+
+  return 0;
+}
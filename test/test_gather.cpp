@@ -0,0 +1,90 @@
+// Copyright 2019-2021 Lawrence Livermore National Security, LLC and other YGM
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: MIT
+
+#undef NDEBUG
+#include <string>
+#include <vector>
+
+#include <ygm/comm.hpp>
+#include <ygm/container/counting_set.hpp>
+#include <ygm/container/map.hpp>
+
+int main(int argc, char **argv) {
+  ygm::comm world(&argc, &argv);
+
+  const size_t num_keys = 10000;
+
+  //
+  // Test all_gather with repeated keys spanning several batches
+  {
+    ygm::container::map<size_t, size_t> smap(world);
+    for (size_t i = world.rank(); i < num_keys; i += world.size()) {
+      smap.async_insert(i, 2 * i);
+    }
+
+    std::vector<size_t> keys;
+    for (size_t i = 0; i < 3 * num_keys; ++i) {
+      keys.push_back((i * 7) % (num_keys + 100));
+    }
+    auto gathered = smap.all_gather(keys);
+    ASSERT_RELEASE(gathered.size() == num_keys);
+    for (const auto &kv : gathered) {
+      ASSERT_RELEASE(kv.second == 2 * kv.first);
+    }
+  }
+
+  //
+  // Test multimap all_gather returns every value once
+  {
+    ygm::container::multimap<std::string, int> smap(world);
+    smap.async_insert("dog", world.rank());
+    smap.async_insert("cat", world.rank());
+
+    auto gathered = smap.all_gather({"dog", "dog", "cat", "fish"});
+    ASSERT_RELEASE(gathered.count("dog") == world.size());
+    ASSERT_RELEASE(gathered.count("cat") == world.size());
+    ASSERT_RELEASE(gathered.count("fish") == 0);
+  }
+
+  //
+  // Test non-collective async_gather
+  {
+    ygm::container::map<size_t, size_t> smap(world);
+    for (size_t i = world.rank(); i < num_keys; i += world.size()) {
+      smap.async_insert(i, i + 1);
+    }
+    world.barrier();
+
+    if (world.rank() == 0) {
+      std::vector<size_t> keys     = {1, 2, 3, 3, num_keys + 1};
+      auto                request  = smap.async_gather(keys);
+      auto                gathered = request.get();
+      ASSERT_RELEASE(request.ready());
+      ASSERT_RELEASE(gathered.size() == 3);
+      ASSERT_RELEASE(gathered[3] == 4);
+    }
+    world.barrier();
+  }
+
+  //
+  // Test counting_set gathers
+  {
+    ygm::container::counting_set<std::string> cset(world);
+    cset.async_insert("dog");
+    cset.async_insert("dog");
+    cset.async_insert("apple");
+
+    auto counts = cset.all_gather({"dog", "apple", "dog", "cat"});
+    ASSERT_RELEASE(counts["dog"] == 2 * world.size());
+    ASSERT_RELEASE(counts["apple"] == world.size());
+    ASSERT_RELEASE(counts.count("cat") == 0);
+
+    auto request = cset.async_gather(std::vector<std::string>{"apple"});
+    ASSERT_RELEASE(request.get()["apple"] == world.size());
+    world.barrier();
+  }
+
+  return 0;
+}
@@ -0,0 +1,115 @@
+// Copyright 2019-2021 Lawrence Livermore National Security, LLC and other YGM
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: MIT
+
+#undef NDEBUG
+#include <string>
+
+#include <ygm/comm.hpp>
+#include <ygm/container/counting_set.hpp>
+#include <ygm/container/map.hpp>
+#include <ygm/container/set.hpp>
+
+int main(int argc, char **argv) {
+  ygm::comm world(&argc, &argv);
+
+  ASSERT_RELEASE(world.handler_threads() == 0);
+  world.set_handler_threads(4);
+  ASSERT_RELEASE(world.handler_threads() == 4);
+
+  const size_t num_keys = 10000;
+
+  //
+  // Test map async_insert and async_visit
+  {
+    ygm::container::map<size_t, size_t> smap(world);
+    for (size_t i = world.rank(); i < num_keys; i += world.size()) {
+      smap.async_insert(i, i);
+    }
+    ASSERT_RELEASE(smap.size() == num_keys);
+
+    for (size_t i = 0; i < num_keys; ++i) {
+      smap.async_visit(i, [](auto &kv) { kv.second += 1; });
+    }
+
+    size_t local_wrong{0};
+    smap.for_all([&local_wrong, &world](const auto &kv) {
+      if (kv.second != kv.first + world.size()) {
+        ++local_wrong;
+      }
+    });
+    ASSERT_RELEASE(world.all_reduce_sum(local_wrong) == 0);
+    ASSERT_RELEASE(smap.count(42) == 1);
+
+    for (size_t i = world.rank(); i < num_keys; i += world.size()) {
+      if (i % 2 == 0) {
+        smap.async_erase(i);
+      }
+    }
+    ASSERT_RELEASE(smap.size() == num_keys / 2);
+  }
+
+  //
+  // Test visitors sending from handler threads
+  {
+    ygm::container::map<size_t, size_t> smap(world);
+    for (size_t i = world.rank(); i < num_keys; i += world.size()) {
+      smap.async_insert(i, 2 * i);
+    }
+    world.barrier();
+    for (size_t i = world.rank(); i < num_keys; i += world.size()) {
+      smap.async_visit(
+          i,
+          [](auto pmap, int from, auto &kv, size_t offset) {
+            pmap->async_insert_unique(kv.first + offset, kv.second);
+          },
+          num_keys);
+    }
+    ASSERT_RELEASE(smap.size() == 2 * num_keys);
+
+    size_t local_wrong{0};
+    smap.for_all([&local_wrong, num_keys](const auto &kv) {
+      size_t base = kv.first % num_keys;
+      if (kv.second != 2 * base) {
+        ++local_wrong;
+      }
+    });
+    ASSERT_RELEASE(world.all_reduce_sum(local_wrong) == 0);
+  }
+
+  //
+  // Test multimap async_insert
+  {
+    ygm::container::multimap<std::string, int> smap(world);
+    smap.async_insert("dog", world.rank());
+    smap.async_insert("cat", world.rank());
+    ASSERT_RELEASE(smap.count("dog") == world.size());
+    ASSERT_RELEASE(smap.size() == 2 * world.size());
+  }
+
+  //
+  // Test set async_insert
+  {
+    ygm::container::set<size_t> sset(world);
+    for (size_t i = 0; i < num_keys; ++i) {
+      sset.async_insert(i);
+    }
+    ASSERT_RELEASE(sset.size() == num_keys);
+    ASSERT_RELEASE(sset.count(7) == 1);
+  }
+
+  //
+  // Test counting_set async_insert
+  {
+    ygm::container::counting_set<size_t> cset(world);
+    for (size_t i = 0; i < num_keys; ++i) {
+      cset.async_insert(i % 100);
+    }
+    ASSERT_RELEASE(cset.size() == 100);
+    ASSERT_RELEASE(cset.count(5) == (num_keys / 100) * world.size());
+    ASSERT_RELEASE(cset.count_all() == num_keys * world.size());
+  }
+
+  return 0;
+}
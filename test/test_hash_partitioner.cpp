@@ -0,0 +1,135 @@
+// Copyright 2019-2021 Lawrence Livermore National Security, LLC and other YGM
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: MIT
+
+#undef NDEBUG
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include <ygm/comm.hpp>
+#include <ygm/container/map.hpp>
+
+namespace ygmc = ygm::container;
+
+template <typename Key, typename Value>
+using carried_map =
+    ygmc::map<Key, Value, ygmc::detail::hash_partitioner<Key>, std::less<Key>,
+              std::allocator<std::pair<const Key, Value>>,
+              ygmc::detail::carried_hash_storage>;
+
+// Largest count over the mean when num_keys keys from key_of are placed on
+// nranks ranks (bank false) or into nbanks banks (bank true)
+template <typename Key, typename KeyOf>
+double imbalance(KeyOf key_of, size_t num_keys, size_t nranks, size_t nbanks,
+                 bool bank) {
+  ygmc::detail::hash_partitioner<Key> partitioner;
+  std::vector<size_t> counts(bank ? nbanks : nranks);
+  for (size_t i = 0; i < num_keys; ++i) {
+    auto [rank, b] = partitioner(key_of(i), nranks, nbanks);
+    ASSERT_RELEASE(rank < nranks && b < nbanks);
+    ++counts[bank ? b : rank];
+  }
+  double mean = double(num_keys) / counts.size();
+  return *std::max_element(counts.begin(), counts.end()) / mean;
+}
+
+int main(int argc, char **argv) {
+  ygm::comm world(&argc, &argv);
+
+  //
+  // Test rank balance of sequential and strided integer keys
+  {
+    for (size_t nranks : {size_t(world.size()), size_t(3), size_t(16),
+                          size_t(64)}) {
+      for (uint64_t stride : {1, 2, 16, 64, 1024, 4096}) {
+        double ratio = imbalance<uint64_t>(
+            [stride](size_t i) { return i * stride; }, 64 * 1024, nranks, 1024,
+            false);
+        ASSERT_RELEASE(ratio < 1.15);
+      }
+    }
+  }
+
+  //
+  // Test bank balance of strided keys, which the rank does not determine
+  {
+    for (uint64_t stride : {1, 16, 1024}) {
+      double ratio = imbalance<uint64_t>(
+          [stride](size_t i) { return i * stride; }, 256 * 1024, 16, 64, true);
+      ASSERT_RELEASE(ratio < 1.15);
+    }
+  }
+
+  //
+  // Test rank balance of string keys sharing a long prefix
+  {
+    double ratio = imbalance<std::string>(
+        [](size_t i) {
+          return std::string("vertex_with_a_long_common_prefix_") +
+                 std::to_string(i);
+        },
+        64 * 1024, 16, 1024, false);
+    ASSERT_RELEASE(ratio < 1.15);
+  }
+
+  //
+  // Test the carried hash picks the same bank as the full hash
+  {
+    ygmc::detail::hash_partitioner<std::string> partitioner;
+    for (size_t i = 0; i < 1000; ++i) {
+      std::string key = std::to_string(i * 7);
+      uint64_t    hash = partitioner.hash(key);
+      uint32_t    local = partitioner.local_hash(hash);
+      ASSERT_RELEASE(local == ygmc::detail::local_key_hash<std::string>{}(key));
+      ASSERT_RELEASE(partitioner(key, 5, 1024).second ==
+                     partitioner.bank(local, 1024));
+    }
+  }
+
+  //
+  // Test map with carried hashes
+  {
+    carried_map<std::string, int> smap(world);
+    for (int i = 0; i < 1000; ++i) {
+      smap.async_insert("key" + std::to_string(i), i);
+    }
+    world.barrier();
+    ASSERT_RELEASE(smap.size() == 1000);
+    for (int i = 0; i < 1000; ++i) {
+      smap.async_visit("key" + std::to_string(i),
+                       [](auto &kv) { kv.second += 1; });
+      smap.async_visit_if_exists("absent" + std::to_string(i),
+                                 [](auto &kv) { kv.second = -1; });
+    }
+    world.barrier();
+    ASSERT_RELEASE(smap.size() == 1000);
+    int64_t local_sum{0};
+    smap.for_all([&local_sum](const auto &kv) { local_sum += kv.second; });
+    int64_t n = world.size();
+    ASSERT_RELEASE(world.all_reduce_sum(local_sum) == 999 * 1000 / 2 + n * 1000);
+    for (int i = 0; i < 1000; ++i) {
+      ASSERT_RELEASE(smap.is_mine("key" + std::to_string(i)) ==
+                     (smap.local_get("key" + std::to_string(i)).size() == 1));
+    }
+  }
+
+  //
+  // Test multimap with carried hashes
+  {
+    ygmc::multimap<uint64_t, uint64_t, ygmc::detail::hash_partitioner<uint64_t>,
+                   std::less<uint64_t>,
+                   std::allocator<std::pair<const uint64_t, uint64_t>>,
+                   ygmc::detail::carried_hash_storage>
+        mmap(world);
+    for (uint64_t i = 0; i < 100; ++i) {
+      mmap.async_insert(i * 1024, i);
+    }
+    world.barrier();
+    ASSERT_RELEASE(mmap.size() == 100 * world.size());
+    ASSERT_RELEASE(mmap.count(0) == size_t(world.size()));
+  }
+
+  return 0;
+}
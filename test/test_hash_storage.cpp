@@ -0,0 +1,250 @@
+// Copyright 2019-2021 Lawrence Livermore National Security, LLC and other YGM
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: MIT
+
+#undef NDEBUG
+#include <map>
+#include <random>
+#include <string>
+
+#include <ygm/comm.hpp>
+#include <ygm/container/counting_set.hpp>
+#include <ygm/container/map.hpp>
+#include <ygm/container/set.hpp>
+
+namespace ygmc = ygm::container;
+
+template <typename Key, typename Value>
+using hash_map = ygmc::map<Key, Value, ygmc::detail::hash_partitioner<Key>,
+                           std::less<Key>,
+                           std::allocator<std::pair<const Key, Value>>,
+                           ygmc::detail::hash_storage>;
+
+template <typename Key, typename Value>
+using hash_multimap =
+    ygmc::multimap<Key, Value, ygmc::detail::hash_partitioner<Key>,
+                   std::less<Key>, std::allocator<std::pair<const Key, Value>>,
+                   ygmc::detail::hash_storage>;
+
+template <typename Key>
+using hash_set =
+    ygmc::set<Key, ygmc::detail::hash_partitioner<Key>, std::less<Key>,
+              std::allocator<const Key>, ygmc::detail::hash_storage>;
+
+template <typename Key>
+using hash_counting_set =
+    ygmc::counting_set<Key, ygmc::detail::hash_partitioner<Key>,
+                       std::less<Key>,
+                       std::allocator<std::pair<const Key, size_t>>,
+                       ygmc::detail::hash_storage>;
+
+int main(int argc, char **argv) {
+  ygm::comm world(&argc, &argv);
+
+  //
+  // Test local hash table against std::multimap
+  {
+    ygmc::detail::hash_multimap<int, int> table;
+    std::multimap<int, int>               reference;
+    std::mt19937                          gen(world.rank());
+    std::uniform_int_distribution<int>    dist(0, 999);
+    for (int i = 0; i < 100000; ++i) {
+      int key = dist(gen);
+      if (i % 3 == 0) {
+        ASSERT_RELEASE(table.erase(key) == reference.erase(key));
+      } else {
+        table.insert(std::make_pair(key, i));
+        reference.insert(std::make_pair(key, i));
+      }
+    }
+    ASSERT_RELEASE(table.size() == reference.size());
+    for (int key = 0; key < 1000; ++key) {
+      ASSERT_RELEASE(table.count(key) == reference.count(key));
+      int  table_sum{0}, reference_sum{0};
+      auto range = table.equal_range(key);
+      for (auto itr = range.first; itr != range.second; ++itr) {
+        table_sum += itr->second;
+      }
+      auto ref_range = reference.equal_range(key);
+      for (auto itr = ref_range.first; itr != ref_range.second; ++itr) {
+        reference_sum += itr->second;
+      }
+      ASSERT_RELEASE(table_sum == reference_sum);
+    }
+    size_t iterated{0};
+    for (const auto &kv : table) {
+      ++iterated;
+    }
+    ASSERT_RELEASE(iterated == reference.size());
+
+    auto [itr, inserted] = table.try_emplace(5000, 1);
+    ASSERT_RELEASE(inserted && itr->second == 1);
+    std::tie(itr, inserted) = table.try_emplace(5000, 2);
+    ASSERT_RELEASE(!inserted && itr->second == 1);
+
+    table.clear();
+    ASSERT_RELEASE(table.size() == 0 && table.find(5000) == table.end());
+  }
+
+  //
+  // Test map
+  {
+    hash_map<std::string, std::string> smap(world);
+    if (world.rank() == 0) {
+      smap.async_insert("dog", "cat");
+      smap.async_insert("apple", "orange");
+      smap.async_insert("red", "green");
+    }
+    smap.async_insert("dog", "cat");
+    ASSERT_RELEASE(smap.size() == 3);
+    ASSERT_RELEASE(smap.count("dog") == 1);
+    ASSERT_RELEASE(smap.count("blue") == 0);
+
+    smap.async_visit("blue", [](auto &kv) { kv.second = "purple"; });
+    auto gathered = smap.all_gather({"blue", "apple"});
+    ASSERT_RELEASE(gathered["blue"] == "purple");
+    ASSERT_RELEASE(gathered["apple"] == "orange");
+
+    smap.async_erase("dog");
+    ASSERT_RELEASE(smap.size() == 3);
+  }
+
+  //
+  // Test visitors inserting many keys into the map they visit, then writing
+  // the visited value
+  {
+    hash_map<size_t, size_t> smap(world);
+    size_t                   num_keys = 1000;
+    size_t                   copies   = 32;
+    for (size_t i = world.rank(); i < num_keys; i += world.size()) {
+      smap.async_insert(i, 0);
+    }
+    world.barrier();
+    for (size_t i = world.rank(); i < num_keys; i += world.size()) {
+      smap.async_visit(
+          i,
+          [](auto pmap, int from, auto &kv, size_t num_keys, size_t copies) {
+            for (size_t c = 1; c <= copies; ++c) {
+              pmap->async_insert_unique(kv.first + c * num_keys, 2);
+            }
+            kv.second = 1;
+          },
+          num_keys, copies);
+    }
+    ASSERT_RELEASE(smap.size() == (copies + 1) * num_keys);
+
+    // Range visits from rank 0 add keys past the range
+    if (world.rank0()) {
+      smap.async_visit_range(
+          0, num_keys,
+          [](auto pmap, int from, auto &kv, size_t offset) {
+            pmap->async_insert_unique(kv.first + offset, 3);
+            kv.second += 2;
+          },
+          (copies + 1) * num_keys);
+    }
+    ASSERT_RELEASE(smap.size() == (copies + 2) * num_keys);
+
+    size_t local_wrong{0};
+    smap.for_all([&local_wrong, num_keys, copies](const auto &kv) {
+      size_t expected = kv.first < num_keys                    ? 3
+                        : kv.first < (copies + 1) * num_keys ? 2
+                                                               : 3;
+      if (kv.second != expected) {
+        ++local_wrong;
+      }
+    });
+    ASSERT_RELEASE(world.all_reduce_sum(local_wrong) == 0);
+  }
+
+  //
+  // Test for_all inserting into the set it iterates
+  {
+    hash_set<size_t> sset(world);
+    size_t           num_keys = 10000;
+    for (size_t i = world.rank(); i < num_keys; i += world.size()) {
+      sset.async_insert(i);
+    }
+    sset.for_all([&sset, num_keys](const size_t &key) {
+      if (key < num_keys) {
+        sset.async_insert(key + num_keys);
+      }
+    });
+    ASSERT_RELEASE(sset.size() == 2 * num_keys);
+  }
+
+  //
+  // Test multimap
+  {
+    hash_multimap<size_t, size_t> smap(world);
+    for (size_t i = 0; i < 1000; ++i) {
+      smap.async_insert(i, world.rank());
+    }
+    ASSERT_RELEASE(smap.size() == 1000 * world.size());
+    ASSERT_RELEASE(smap.count(17) == world.size());
+
+    smap.async_visit(17, [](auto &kv) { kv.second = 100; });
+    size_t local_visited{0};
+    smap.for_all([&local_visited](const auto &kv) {
+      if (kv.first == 17 && kv.second == 100) {
+        ++local_visited;
+      }
+    });
+    ASSERT_RELEASE(world.all_reduce_sum(local_visited) == world.size());
+
+    if (world.rank() == 0) {
+      smap.async_erase(17);
+    }
+    ASSERT_RELEASE(smap.count(17) == 0);
+    ASSERT_RELEASE(smap.size() == 999 * world.size());
+  }
+
+  //
+  // Test set
+  {
+    hash_set<std::string> sset(world);
+    sset.async_insert("dog");
+    sset.async_insert("apple");
+    sset.async_insert("red");
+    ASSERT_RELEASE(sset.size() == 3);
+    ASSERT_RELEASE(sset.count("apple") == 1);
+    sset.async_erase("apple");
+    ASSERT_RELEASE(sset.count("apple") == 0);
+  }
+
+  //
+  // Test counting_set
+  {
+    hash_counting_set<size_t> cset(world);
+    for (size_t i = 0; i < 10000; ++i) {
+      cset.async_insert(i % 100);
+    }
+    ASSERT_RELEASE(cset.size() == 100);
+    ASSERT_RELEASE(cset.count(3) == 100 * world.size());
+    ASSERT_RELEASE(cset.count_all() == 10000 * world.size());
+  }
+
+  //
+  // Test serialization round trip between storages
+  {
+    hash_map<std::string, int> smap(world);
+    if (world.rank() == 0) {
+      smap.async_insert("one", 1);
+      smap.async_insert("two", 2);
+    }
+    smap.serialize("hash_storage_test");
+
+    ygmc::map<std::string, int> tree_map(world);
+    tree_map.deserialize("hash_storage_test");
+    ASSERT_RELEASE(tree_map.size() == 2);
+    ASSERT_RELEASE(tree_map.count("two") == 1);
+
+    hash_map<std::string, int> hmap(world);
+    hmap.deserialize("hash_storage_test");
+    ASSERT_RELEASE(hmap.size() == 2);
+    ASSERT_RELEASE(hmap.count("one") == 1);
+  }
+
+  return 0;
+}
@@ -0,0 +1,103 @@
+// Copyright 2019-2021 Lawrence Livermore National Security, LLC and other YGM
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: MIT
+
+#undef NDEBUG
+#include <string>
+#include <vector>
+
+#include <ygm/comm.hpp>
+#include <ygm/container/map.hpp>
+#include <ygm/container/set.hpp>
+
+int main(int argc, char **argv) {
+  ygm::comm world(&argc, &argv);
+
+  const size_t num_keys = 10000;
+
+  //
+  // Test map async_insert_range keeps the last value of duplicate keys
+  {
+    std::vector<std::pair<size_t, size_t>> local;
+    for (size_t i = 0; i < num_keys; ++i) {
+      local.emplace_back(i, 0);
+      local.emplace_back(i, i + 1);
+    }
+
+    ygm::container::map<size_t, size_t> smap(world);
+    smap.async_insert_range(local.begin(), local.end());
+    ASSERT_RELEASE(smap.size() == num_keys);
+
+    size_t local_wrong{0};
+    smap.for_all([&local_wrong](const auto &kv) {
+      if (kv.second != kv.first + 1) ++local_wrong;
+    });
+    ASSERT_RELEASE(world.all_reduce_sum(local_wrong) == 0);
+
+    ygm::container::map<size_t, size_t> uncombined(world);
+    uncombined.async_insert_range(local.begin(), local.end(), false);
+    ASSERT_RELEASE(uncombined.size() == num_keys);
+  }
+
+  //
+  // Test combining keeps keys that are not moved
+  {
+    std::vector<std::pair<std::string, int>> local = {{"a", 1}, {"b", 2}};
+    ygm::container::map<std::string, int> smap(world);
+    smap.async_insert_range(local.begin(), local.end());
+    auto gathered = smap.all_gather(std::vector<std::string>{"a", "b"});
+    ASSERT_RELEASE(smap.size() == 2);
+    ASSERT_RELEASE(gathered["a"] == 1 && gathered["b"] == 2);
+  }
+
+  //
+  // Test multimap from_local constructor
+  {
+    std::vector<std::pair<std::string, int>> local;
+    local.emplace_back("dog", world.rank());
+    local.emplace_back("dog", world.rank());
+    local.emplace_back("cat", world.rank());
+
+    ygm::container::multimap<std::string, int> smap(
+        world, ygm::container::from_local, local.begin(), local.end());
+    ASSERT_RELEASE(smap.count("dog") == 2 * world.size());
+    ASSERT_RELEASE(smap.count("cat") == world.size());
+    ASSERT_RELEASE(smap.size() == 3 * world.size());
+  }
+
+  //
+  // Test set from_local constructor and async_insert_range
+  {
+    std::vector<size_t> local;
+    for (size_t i = 0; i < num_keys; ++i) {
+      local.push_back(i % 1000);
+    }
+
+    ygm::container::set<size_t> sset(world, ygm::container::from_local,
+                                     local.begin(), local.end());
+    ASSERT_RELEASE(sset.size() == 1000);
+
+    ygm::container::multiset<size_t> smset(world);
+    smset.async_insert_range(local.begin(), local.end());
+    ASSERT_RELEASE(smset.size() == num_keys * world.size());
+    ASSERT_RELEASE(smset.count(7) == 10 * world.size());
+  }
+
+  //
+  // Test with handler threads
+  world.set_handler_threads(2);
+  {
+    std::vector<std::pair<size_t, size_t>> local;
+    for (size_t i = world.rank(); i < num_keys; i += world.size()) {
+      local.emplace_back(i, i);
+    }
+    ygm::container::map<size_t, size_t> smap(world, ygm::container::from_local,
+                                             local.begin(), local.end());
+    ASSERT_RELEASE(smap.size() == num_keys);
+    ASSERT_RELEASE(smap.count(1234) == 1);
+  }
+  world.set_handler_threads(0);
+
+  return 0;
+}
@@ -0,0 +1,104 @@
+// Copyright 2019-2021 Lawrence Livermore National Security, LLC and other YGM
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: MIT
+
+#undef NDEBUG
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <ygm/comm.hpp>
+#include <ygm/container/bag.hpp>
+#include <ygm/container/map.hpp>
+#include <ygm/io/line_parser.hpp>
+
+// Line i of file f is "f:i" padded with 'x' to a length varying with i, so
+// lines straddle every rank boundary and buffer refill
+std::string make_line(int f, int i) {
+  std::string line = std::to_string(f) + ":" + std::to_string(i);
+  line.append((i * 7919) % 300, 'x');
+  return line;
+}
+
+static size_t line_count = 0;
+static size_t byte_count = 0;
+
+int main(int argc, char **argv) {
+  ygm::comm world(&argc, &argv);
+
+  std::string dir = "line_parser_test.d";
+  // Line counts per file: one large file, small ones, an empty one
+  std::vector<int> num_lines = {5000, 1, 0, 37, 2000};
+  std::vector<std::string> paths;
+  size_t expected_lines = 0;
+  size_t expected_bytes = 0;
+  for (size_t f = 0; f < num_lines.size(); ++f) {
+    paths.push_back(dir + "/file" + std::to_string(f));
+    for (int i = 0; i < num_lines[f]; ++i) {
+      ++expected_lines;
+      expected_bytes += make_line(f, i).size();
+    }
+  }
+  if (world.rank0()) {
+    std::filesystem::create_directory(dir);
+    for (size_t f = 0; f < num_lines.size(); ++f) {
+      std::ofstream os(paths[f], std::ios::binary);
+      for (int i = 0; i < num_lines[f]; ++i) {
+        os << make_line(f, i);
+        // The last file ends without a newline
+        if (f + 1 < num_lines.size() || i + 1 < num_lines[f]) {
+          os << "\n";
+        }
+      }
+    }
+  }
+  world.barrier();
+
+  //
+  // Test every line is read exactly once, buffered and mapped, with buffers
+  // smaller than many lines
+  for (bool use_mmap : {false, true}) {
+    for (size_t buffer_size : {size_t(64), size_t(1) << 20}) {
+      ygm::io::line_parser parser(world, paths, use_mmap, buffer_size);
+      ASSERT_RELEASE(parser.files().size() == num_lines.size());
+      ygm::container::map<std::string, int> lines(world);
+      line_count = 0;
+      byte_count = 0;
+      parser.for_all([&lines](std::string_view line) {
+        ++line_count;
+        byte_count += line.size();
+        lines.async_insert(std::string(line), 1);
+      });
+      world.barrier();
+      ASSERT_RELEASE(world.all_reduce_sum(line_count) == expected_lines);
+      ASSERT_RELEASE(world.all_reduce_sum(byte_count) == expected_bytes);
+      ASSERT_RELEASE(lines.size() == expected_lines);
+      ASSERT_RELEASE(lines.count(make_line(0, 4999)) == 1);
+      ASSERT_RELEASE(lines.count(make_line(4, 1999)) == 1);
+      ASSERT_RELEASE(lines.count(make_line(1, 0)) == 1);
+      // The large file is shared rather than read by one rank
+      ASSERT_RELEASE(world.all_reduce_max(line_count) <
+                     expected_lines / world.size() + 600);
+    }
+  }
+
+  //
+  // Test reading a directory into a bag through std::string callbacks
+  {
+    ygm::io::line_parser     parser(world, {dir});
+    ygm::container::bag<int> lengths(world);
+    parser.for_all([&lengths](const std::string &line) {
+      lengths.async_insert(line.size());
+    });
+    ASSERT_RELEASE(lengths.size() == expected_lines);
+  }
+
+  world.barrier();
+  if (world.rank0()) {
+    std::filesystem::remove_all(dir);
+  }
+  return 0;
+}
@@ -122,5 +122,117 @@ int main(int argc, char **argv) {
     }
   }
 
+  //
+  // Test async_reduce with sum, min, max and bitwise or
+  {
+    size_t num_keys = 100;
+    size_t updates  = 10000;
+    ygm::container::map<size_t, size_t> sums(world);
+    ygm::container::map<size_t, size_t> mins(world);
+    ygm::container::map<size_t, size_t> maxs(world);
+    ygm::container::map<size_t, size_t> ors(world);
+    // Smallest buffers, so updates are sent before the barrier
+    mins.set_reduce_buffer_capacity(0);
+    for (size_t i = 0; i < updates; ++i) {
+      size_t key   = i % num_keys;
+      size_t value = i + world.rank();
+      sums.async_reduce(key, size_t(1), std::plus<size_t>());
+      mins.async_reduce(key, value, [](size_t a, size_t b) {
+        return std::min(a, b);
+      });
+      maxs.async_reduce(key, value, [](size_t a, size_t b) {
+        return std::max(a, b);
+      });
+      ors.async_reduce(key, size_t(1) << ((i / num_keys) % 16),
+                       [](size_t a, size_t b) { return a | b; });
+    }
+
+    ASSERT_RELEASE(sums.size() == num_keys);
+    sums.for_all([&](const auto &kv) {
+      ASSERT_RELEASE(kv.second == (updates / num_keys) * world.size());
+    });
+    mins.for_all([&](const auto &kv) { ASSERT_RELEASE(kv.second == kv.first); });
+    maxs.for_all([&](const auto &kv) {
+      ASSERT_RELEASE(kv.second ==
+                     updates - num_keys + kv.first + world.size() - 1);
+    });
+    auto gathered = ors.all_gather(std::vector<size_t>{0, 1});
+    ASSERT_RELEASE(gathered[0] == 0xFFFF);
+    ASSERT_RELEASE(gathered[1] == 0xFFFF);
+  }
+
+  //
+  // Test async_reduce mixing ops and visits
+  {
+    ygm::container::map<std::string, int> smap(world);
+    if (world.rank0()) {
+      // Changing op flushes, so rank 0's updates apply in order
+      smap.async_reduce("a", 1, std::plus<int>());
+      smap.async_reduce("a", 5, [](int a, int b) { return std::max(a, b); });
+      smap.async_reduce("a", 1, std::plus<int>());
+    }
+    smap.async_reduce("b", 1, std::plus<int>());
+    world.barrier();
+    if (world.rank0()) {
+      smap.async_visit("b", [](auto &kv) { kv.second *= 2; });
+    }
+    world.barrier();
+    smap.async_reduce("b", 1, std::plus<int>());
+
+    auto gathered = smap.all_gather(std::vector<std::string>{"a", "b"});
+    ASSERT_RELEASE(gathered["a"] == 6);
+    ASSERT_RELEASE(gathered["b"] == 3 * world.size());
+  }
+
+  //
+  // Test async_reduce hot keys
+  {
+    size_t updates = 40000;
+    ygm::container::map<size_t, size_t> hot(world);
+    ygm::container::map<size_t, size_t> cold(world);
+    cold.set_hot_key_fraction(0);
+    for (size_t i = 0; i < updates; ++i) {
+      // Half of all updates go to key 0
+      size_t key = i % 2 == 0 ? 0 : i;
+      hot.async_reduce(key, size_t(1), std::plus<size_t>());
+      cold.async_reduce(key, size_t(1), std::plus<size_t>());
+    }
+    ASSERT_RELEASE(hot.hot_keys() == std::vector<size_t>{0});
+    ASSERT_RELEASE(cold.hot_keys().empty());
+
+    auto hot_counts  = hot.all_gather(std::vector<size_t>{0, 1});
+    auto cold_counts = cold.all_gather(std::vector<size_t>{0, 1});
+    ASSERT_RELEASE(hot_counts[0] == (updates / 2) * world.size());
+    ASSERT_RELEASE(hot_counts[1] == world.size());
+    ASSERT_RELEASE(hot_counts == cold_counts);
+    ASSERT_RELEASE(hot.size() == cold.size());
+  }
+
+  //
+  // Test async_reduce from handlers while the same map is flushing
+  for (double hot_fraction : {0.01, 0.0}) {
+    size_t                            updates = 100000;
+    ygm::container::map<size_t, long> smap(world);
+    smap.set_hot_key_fraction(hot_fraction);
+    auto psmap = smap.get_ygm_ptr();
+    for (size_t i = 0; i < updates; ++i) {
+      // Half of all updates go to key 0
+      size_t key = i % 2 == 0 ? 0 : i % 1000;
+      smap.async_reduce(key, 1, std::plus<long>());
+      world.async(
+          (world.rank() + 1) % world.size(),
+          [](auto pcomm, int from, auto psmap, size_t key) {
+            psmap->async_reduce(key, 1, std::plus<long>());
+          },
+          psmap, key);
+    }
+    world.barrier();
+
+    long local_sum{0};
+    smap.for_all([&local_sum](const auto &kv) { local_sum += kv.second; });
+    ASSERT_RELEASE(world.all_reduce_sum(local_sum) ==
+                   long(2 * updates * world.size()));
+  }
+
   return 0;
 }
@@ -0,0 +1,209 @@
+// Copyright 2019-2021 Lawrence Livermore National Security, LLC and other YGM
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: MIT
+
+#undef NDEBUG
+#include <filesystem>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <ygm/comm.hpp>
+#include <ygm/container/bag.hpp>
+#include <ygm/container/map.hpp>
+#include <ygm/container/set.hpp>
+
+namespace ygmc = ygm::container;
+
+using ygmc::detail::mmap_allocator;
+using ygmc::detail::mmap_file;
+
+template <typename Key, typename Value>
+using persistent_map =
+    ygmc::map<Key, Value, ygmc::detail::hash_partitioner<Key>, std::less<Key>,
+              mmap_allocator<std::pair<const Key, Value>>,
+              ygmc::detail::hash_storage>;
+
+template <typename Key, typename Value>
+using persistent_multimap =
+    ygmc::multimap<Key, Value, ygmc::detail::hash_partitioner<Key>,
+                   std::less<Key>, mmap_allocator<std::pair<const Key, Value>>,
+                   ygmc::detail::hash_storage>;
+
+template <typename Key>
+using persistent_set =
+    ygmc::set<Key, ygmc::detail::hash_partitioner<Key>, std::less<Key>,
+              mmap_allocator<Key>, ygmc::detail::hash_storage>;
+
+template <typename Item>
+using persistent_bag = ygmc::bag<Item, mmap_allocator<Item>>;
+
+void remove_files(ygm::comm &world, const std::string &prefix) {
+  world.barrier();
+  std::filesystem::remove(prefix + std::to_string(world.rank()));
+  world.barrier();
+}
+
+int main(int argc, char **argv) {
+  ygm::comm world(&argc, &argv);
+
+  const size_t capacity = size_t(64) << 20;
+
+  //
+  // Test offset_ptr and the arena allocator locally
+  {
+    std::string prefix = "persistent_test.local";
+    remove_files(world, prefix);
+    ygmc::detail::mmap_root<std::vector<int, mmap_allocator<int>>> root(
+        world, mmap_file{prefix, capacity}, 1);
+    ASSERT_RELEASE(root.created());
+
+    ASSERT_RELEASE(root.count() == 1);
+    auto &v = *root.roots();
+    for (int i = 0; i < 100000; ++i) {
+      v.push_back(i);
+    }
+    ASSERT_RELEASE(v.size() == 100000 && v[99999] == 99999);
+    // Moving the vector object keeps its offset_ptrs pointing into the arena
+    auto moved = std::move(v);
+    ASSERT_RELEASE(moved[12345] == 12345);
+    ASSERT_RELEASE(v.get_allocator() == moved.get_allocator());
+
+    ygmc::detail::offset_ptr<int> p(&moved[10]);
+    ygmc::detail::offset_ptr<int> q = p + 5;
+    ASSERT_RELEASE(*q == 15 && q - p == 5 && p < q);
+    ygmc::detail::offset_ptr<int> null;
+    ASSERT_RELEASE(!null && null == nullptr && null.get() == nullptr);
+
+    // The root reads back through a second mapping at another address
+    v = std::move(moved);
+    root.sync();
+    {
+      ygmc::detail::mmap_arena second(prefix + std::to_string(world.rank()),
+                                      capacity);
+      auto *header = second.header();
+      ASSERT_RELEASE(header != root.allocator().arena());
+      auto *parked = reinterpret_cast<std::vector<int, mmap_allocator<int>> *>(
+          header->base() + header->root);
+      ASSERT_RELEASE(parked->size() == 100000 && (*parked)[54321] == 54321);
+    }
+  }
+  remove_files(world, "persistent_test.local");
+
+  //
+  // Test a map survives destruction and reattaches
+  {
+    std::string prefix = "persistent_test.map";
+    remove_files(world, prefix);
+    {
+      persistent_map<uint64_t, double> pmap(world, mmap_file{prefix, capacity});
+      ASSERT_RELEASE(pmap.size() == 0);
+      for (uint64_t i = world.rank(); i < 10000; i += world.size()) {
+        pmap.async_insert(i, i * 0.5);
+      }
+      ASSERT_RELEASE(pmap.size() == 10000);
+    }
+    {
+      persistent_map<uint64_t, double> pmap(world, mmap_file{prefix, capacity});
+      ASSERT_RELEASE(pmap.size() == 10000);
+      pmap.for_all([&pmap](const auto &kv) {
+        ASSERT_RELEASE(pmap.is_mine(kv.first));
+        ASSERT_RELEASE(kv.second == kv.first * 0.5);
+      });
+      if (world.rank0()) {
+        pmap.async_visit(uint64_t(1234), [](auto &kv) { kv.second = -1; });
+        pmap.async_erase(uint64_t(4321));
+        pmap.async_insert(uint64_t(20000), 1.0);
+      }
+      world.barrier();
+      pmap.persist();
+      ASSERT_RELEASE(pmap.count(uint64_t(4321)) == 0);
+    }
+    {
+      persistent_map<uint64_t, double> pmap(world, mmap_file{prefix, capacity});
+      ASSERT_RELEASE(pmap.size() == 10000);
+      auto values = pmap.all_gather({uint64_t(1234), uint64_t(20000)});
+      ASSERT_RELEASE(values[1234] == -1 && values[20000] == 1.0);
+    }
+    remove_files(world, prefix);
+  }
+
+  //
+  // Test a reattached map keeps its data in the file while it runs, so a job
+  // that dies before destroying it loses nothing
+  {
+    std::string prefix = "persistent_test.live";
+    remove_files(world, prefix);
+    {
+      persistent_map<uint64_t, double> pmap(world, mmap_file{prefix, capacity});
+      for (uint64_t i = world.rank(); i < 1000; i += world.size()) {
+        pmap.async_insert(i, i * 0.5);
+      }
+    }
+    {
+      using local_map_type =
+          persistent_map<uint64_t, double>::impl_type::local_map_type;
+      persistent_map<uint64_t, double> pmap(world, mmap_file{prefix, capacity});
+      size_t local_size = 0;
+      pmap.for_all([&local_size](const auto &kv) { ++local_size; });
+      ASSERT_RELEASE(world.all_reduce_sum(local_size) == 1000);
+
+      ygmc::detail::mmap_arena second(prefix + std::to_string(world.rank()),
+                                      capacity);
+      auto *header = second.header();
+      auto *roots  = reinterpret_cast<local_map_type *>(header->base() +
+                                                       header->root);
+      size_t file_size = 0;
+      for (size_t i = 0; i < header->root_count; ++i) {
+        file_size += roots[i].size();
+      }
+      ASSERT_RELEASE(file_size == local_size);
+    }
+    remove_files(world, prefix);
+  }
+
+  //
+  // Test multimap, set and bag reattach
+  {
+    std::string prefix = "persistent_test.";
+    remove_files(world, prefix + "mmap");
+    remove_files(world, prefix + "set");
+    remove_files(world, prefix + "bag");
+    {
+      persistent_multimap<int, int> mmap(world,
+                                         mmap_file{prefix + "mmap", capacity});
+      persistent_set<int>  pset(world, mmap_file{prefix + "set", capacity});
+      persistent_bag<int>  pbag(world, mmap_file{prefix + "bag", capacity});
+      for (int i = world.rank(); i < 1000; i += world.size()) {
+        mmap.async_insert(i % 10, i);
+        pset.async_insert(i % 100);
+        pbag.async_insert(i);
+      }
+    }
+    {
+      persistent_multimap<int, int> mmap(world,
+                                         mmap_file{prefix + "mmap", capacity});
+      persistent_set<int>  pset(world, mmap_file{prefix + "set", capacity});
+      persistent_bag<int>  pbag(world, mmap_file{prefix + "bag", capacity});
+      ASSERT_RELEASE(mmap.size() == 1000);
+      ASSERT_RELEASE(mmap.count(7) == 100);
+      ASSERT_RELEASE(pset.size() == 100);
+      ASSERT_RELEASE(pset.count(42) == 1);
+      ASSERT_RELEASE(pbag.size() == 1000);
+      long sum{0};
+      pbag.for_all([&sum](int i) { sum += i; });
+      ASSERT_RELEASE(world.all_reduce_sum(sum) == 999 * 1000 / 2);
+      pbag.clear();
+    }
+    {
+      persistent_bag<int> pbag(world, mmap_file{prefix + "bag", capacity});
+      ASSERT_RELEASE(pbag.size() == 0);
+    }
+    remove_files(world, prefix + "mmap");
+    remove_files(world, prefix + "set");
+    remove_files(world, prefix + "bag");
+  }
+
+  return 0;
+}
@@ -0,0 +1,73 @@
+// Copyright 2019-2021 Lawrence Livermore National Security, LLC and other YGM
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: MIT
+
+#undef NDEBUG
+#include <random>
+#include <string>
+
+#include <ygm/comm.hpp>
+#include <ygm/container/priority_queue.hpp>
+
+int main(int argc, char **argv) {
+  ygm::comm world(&argc, &argv);
+
+  //
+  // Test batches come out bucket by bucket
+  {
+    ygm::container::priority_queue<size_t, double> pq(world, 10.0);
+    std::mt19937                                   gen(world.rank());
+    std::uniform_real_distribution<double>         dist(0, 1000);
+    size_t                                         num_pushes = 1000;
+    for (size_t i = 0; i < num_pushes; ++i) {
+      pq.async_push(world.rank() * num_pushes + i, dist(gen));
+    }
+    ASSERT_RELEASE(pq.size() == num_pushes * world.size());
+
+    size_t   popped{0};
+    uint64_t last_bucket{0};
+    while (true) {
+      auto batch = pq.pop_batch();
+      if (pq.current_bucket() == pq.no_bucket) {
+        ASSERT_RELEASE(batch.empty());
+        break;
+      }
+      ASSERT_RELEASE(pq.current_bucket() >= last_bucket);
+      last_bucket = pq.current_bucket();
+      double prev = 0;
+      for (const auto &[item, priority] : batch) {
+        ASSERT_RELEASE(pq.owner(item) == world.rank());
+        ASSERT_RELEASE(uint64_t(priority / 10.0) == last_bucket);
+        ASSERT_RELEASE(prev <= priority);
+        prev = priority;
+      }
+      popped += batch.size();
+    }
+    ASSERT_RELEASE(world.all_reduce_sum(popped) == num_pushes * world.size());
+    ASSERT_RELEASE(pq.empty());
+  }
+
+  //
+  // Test pushes into the current bucket are returned by the next batch
+  {
+    ygm::container::priority_queue<std::string, uint64_t> pq(world, 5);
+    if (world.rank() == 0) {
+      pq.async_push("a", 7);
+      pq.async_push("b", 12);
+    }
+    auto batch = pq.pop_batch();
+    ASSERT_RELEASE(pq.current_bucket() == 1);
+    if (world.rank() == 0) {
+      pq.async_push("c", 8);
+    }
+    batch = pq.pop_batch();
+    ASSERT_RELEASE(pq.current_bucket() == 1);
+    ASSERT_RELEASE(world.all_reduce_sum(batch.size()) == 1);
+    batch = pq.pop_batch();
+    ASSERT_RELEASE(pq.current_bucket() == 2);
+    ASSERT_RELEASE(pq.empty());
+  }
+
+  return 0;
+}
@@ -0,0 +1,65 @@
+// Copyright 2019-2021 Lawrence Livermore National Security, LLC and other YGM
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: MIT
+
+#undef NDEBUG
+#include <ygm/comm.hpp>
+
+static size_t hops_received = 0;
+
+// Forwards a message to the next rank until no hops remain
+struct hop {
+  template <typename Comm>
+  void operator()(Comm* pcomm, int from, size_t hops_left, int stride) {
+    ++hops_received;
+    if (hops_left > 0) {
+      int next = (pcomm->rank() + stride) % pcomm->size();
+      pcomm->async(next, hop(), hops_left - 1, stride);
+    }
+  }
+};
+
+int main(int argc, char** argv) {
+  ygm::comm world(&argc, &argv);
+
+  ASSERT_RELEASE(world.max_process_depth() > 0);
+
+  //
+  // Test million-hop chain of messages to self
+  {
+    hops_received = 0;
+    size_t num_hops = 1000000;
+    world.async(world.rank(), hop(), num_hops - 1, 0);
+    world.barrier();
+    ASSERT_RELEASE(hops_received == num_hops);
+  }
+
+  //
+  // Test many concurrent chains hopping between ranks
+  {
+    hops_received = 0;
+    size_t num_chains = 100;
+    size_t num_hops   = 1000;
+    for (size_t i = 0; i < num_chains; ++i) {
+      world.async((world.rank() + 1) % world.size(), hop(), num_hops - 1, 1);
+    }
+    world.barrier();
+    ASSERT_RELEASE(world.all_reduce_sum(hops_received) ==
+                   num_chains * num_hops * world.size());
+  }
+
+  //
+  // Test with processing depth limited to a single level
+  {
+    world.set_max_process_depth(1);
+    ASSERT_RELEASE(world.max_process_depth() == 1);
+    hops_received = 0;
+    size_t num_hops = 100000;
+    world.async(world.rank(), hop(), num_hops - 1, 0);
+    world.barrier();
+    ASSERT_RELEASE(hops_received == num_hops);
+  }
+
+  return 0;
+}
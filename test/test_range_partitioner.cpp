@@ -0,0 +1,173 @@
+// Copyright 2019-2021 Lawrence Livermore National Security, LLC and other YGM
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: MIT
+
+#undef NDEBUG
+#include <random>
+#include <vector>
+
+#include <ygm/comm.hpp>
+#include <ygm/container/map.hpp>
+
+namespace ygmc = ygm::container;
+
+using range_partitioner = ygmc::detail::range_partitioner<uint64_t>;
+
+template <typename Storage>
+using range_map =
+    ygmc::map<uint64_t, uint64_t, range_partitioner, std::less<uint64_t>,
+              std::allocator<std::pair<const uint64_t, uint64_t>>, Storage>;
+
+static uint64_t visited_count = 0;
+static uint64_t visited_sum   = 0;
+
+template <typename Map>
+void check_visit_range(ygm::comm &world, Map &m, uint64_t lo, uint64_t hi) {
+  visited_count = 0;
+  visited_sum   = 0;
+  world.barrier();
+  if (world.rank0()) {
+    m.async_visit_range(lo, hi, [](auto &kv) {
+      ASSERT_RELEASE(kv.second == 2 * kv.first);
+      ++visited_count;
+      visited_sum += kv.first;
+    });
+  }
+  world.barrier();
+  ASSERT_RELEASE(world.all_reduce_sum(visited_count) == hi - lo);
+  ASSERT_RELEASE(world.all_reduce_sum(visited_sum) ==
+                 (hi - lo) * (lo + hi - 1) / 2);
+}
+
+int main(int argc, char **argv) {
+  ygm::comm world(&argc, &argv);
+
+  //
+  // Test placement and rank ranges from fixed splits
+  {
+    range_partitioner p({10, 20, 30});
+    ASSERT_RELEASE(p(5, 4, 1024).first == 0);
+    ASSERT_RELEASE(p(10, 4, 1024).first == 1);
+    ASSERT_RELEASE(p(25, 4, 1024).first == 2);
+    ASSERT_RELEASE(p(35, 4, 1024).first == 3);
+    ASSERT_RELEASE(p(35, 2, 1024).first == 1);
+    ASSERT_RELEASE(p.rank_range(12, 25, 4) == std::make_pair(size_t(1),
+                                                             size_t(3)));
+    ASSERT_RELEASE(p.rank_range(10, 20, 4) == std::make_pair(size_t(1),
+                                                             size_t(2)));
+    ASSERT_RELEASE(p.rank_range(0, 100, 4) == std::make_pair(size_t(0),
+                                                             size_t(4)));
+    ASSERT_RELEASE(p.rank_range(20, 20, 4).first ==
+                   p.rank_range(20, 20, 4).second);
+    ASSERT_RELEASE(range_partitioner()(42, 4, 1024).first == 0);
+  }
+
+  //
+  // Test sampled splits balance skewed keys
+  {
+    std::mt19937_64       gen(world.rank());
+    std::vector<uint64_t> keys(10000);
+    for (auto &key : keys) {
+      key = gen() % 1000 * (gen() % 1000);
+    }
+    auto p = range_partitioner::sample(world, keys.begin(), keys.end(), 512);
+    ASSERT_RELEASE(p.splits().size() == size_t(world.size() - 1));
+    std::vector<size_t> counts(world.size());
+    for (auto key : keys) {
+      ++counts[p(key, world.size(), 1024).first];
+    }
+    for (auto &count : counts) {
+      count = world.all_reduce_sum(count);
+    }
+    size_t mean = 10000;
+    for (auto count : counts) {
+      ASSERT_RELEASE(count < mean * 3 / 2);
+    }
+  }
+
+  //
+  // Test async_visit_range on a map built with sampled splits
+  {
+    std::vector<uint64_t> local_keys;
+    for (uint64_t key = world.rank(); key < 10000; key += world.size()) {
+      local_keys.push_back(key);
+    }
+    range_map<ygmc::detail::tree_storage> m(
+        world, range_partitioner::sample(world, local_keys.begin(),
+                                         local_keys.end()));
+    for (auto key : local_keys) {
+      m.async_insert(key, 2 * key);
+    }
+    world.barrier();
+    ASSERT_RELEASE(m.size() == 10000);
+    for (uint64_t key : {uint64_t(0), uint64_t(4999), uint64_t(9999)}) {
+      ASSERT_RELEASE(m.is_mine(key) == (m.local_get(key).size() == 1));
+    }
+    check_visit_range(world, m, 0, 10000);
+    check_visit_range(world, m, 1234, 5678);
+    check_visit_range(world, m, 9000, 9001);
+    check_visit_range(world, m, 50, 50);
+
+    // A range inside one rank's share only reaches that rank
+    world.barrier();
+    visited_count = 0;
+    if (world.rank0()) {
+      m.async_visit_range(1200, 1210, [](auto &kv) { ++visited_count; });
+    }
+    world.barrier();
+    ASSERT_RELEASE(world.all_reduce_sum(visited_count) == 10);
+    ASSERT_RELEASE(world.all_reduce_max(visited_count) == 10);
+  }
+
+  //
+  // Test rebalance after loading through an unsplit partitioner
+  {
+    range_map<ygmc::detail::tree_storage> m(world);
+    for (uint64_t key = world.rank(); key < 10000; key += world.size()) {
+      m.async_insert(key, 2 * key);
+    }
+    world.barrier();
+    size_t local{0};
+    m.for_all([&local](const auto &kv) { ++local; });
+    ASSERT_RELEASE(local == (world.rank0() ? 10000 : 0));
+
+    m.rebalance();
+    ASSERT_RELEASE(m.size() == 10000);
+    local = 0;
+    m.for_all([&local](const auto &kv) { ++local; });
+    ASSERT_RELEASE(local < 2 * 10000 / world.size());
+    for (uint64_t key = 0; key < 10000; key += 97) {
+      ASSERT_RELEASE(m.is_mine(key) == (m.local_get(key).size() == 1));
+    }
+    check_visit_range(world, m, 100, 7000);
+  }
+
+  //
+  // Test async_visit_range with unordered storage and a hash partitioner
+  {
+    range_map<ygmc::detail::hash_storage> hm(world);
+    ygmc::map<uint64_t, uint64_t>         m(world);
+    for (uint64_t key = world.rank(); key < 10000; key += world.size()) {
+      hm.async_insert(key, 2 * key);
+      m.async_insert(key, 2 * key);
+    }
+    hm.rebalance();
+    check_visit_range(world, hm, 100, 7000);
+    check_visit_range(world, m, 100, 7000);
+  }
+
+  //
+  // Test async_visit_range with flat storage
+  {
+    range_map<ygmc::detail::flat_storage> fm(world);
+    for (uint64_t key = world.rank(); key < 10000; key += world.size()) {
+      fm.async_insert(key, 2 * key);
+    }
+    fm.rebalance();
+    check_visit_range(world, fm, 0, 10000);
+    check_visit_range(world, fm, 3333, 4444);
+  }
+
+  return 0;
+}
@@ -0,0 +1,144 @@
+// Copyright 2019-2021 Lawrence Livermore National Security, LLC and other YGM
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: MIT
+
+#undef NDEBUG
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include <ygm/comm.hpp>
+#include <ygm/container/bag.hpp>
+#include <ygm/container/counting_set.hpp>
+#include <ygm/container/map.hpp>
+
+namespace ygmc = ygm::container;
+
+int main(int argc, char **argv) {
+  ygm::comm world(&argc, &argv);
+
+  //
+  // Test local sketch against exact ranks
+  {
+    ygmc::detail::quantile_sketch<int> sketch(64);
+    for (int i = 0; i < 100000; ++i) {
+      sketch.insert(i, 1, std::less<int>());
+    }
+    ASSERT_RELEASE(sketch.total_weight() == 100000);
+    auto qs = sketch.quantiles({0.0, 0.25, 0.5, 0.99, 1.0}, std::less<int>());
+    ASSERT_RELEASE(std::abs(qs[1] - 25000) < 5000);
+    ASSERT_RELEASE(std::abs(qs[2] - 50000) < 5000);
+    ASSERT_RELEASE(std::abs(qs[3] - 99000) < 5000);
+    ASSERT_RELEASE(qs[0] <= qs[1] && qs[3] <= qs[4]);
+  }
+
+  //
+  // Test map topk, nth_element and quantiles
+  {
+    ygmc::map<int, int> imap(world);
+    int                 num_keys = 10000;
+    if (world.rank() == 0) {
+      for (int i = 0; i < num_keys; ++i) {
+        imap.async_insert(i, (i * 7919) % num_keys);
+      }
+    }
+    world.barrier();
+
+    auto by_value = [](const auto &a, const auto &b) {
+      return a.second > b.second;
+    };
+    auto top = imap.topk(100, by_value);
+    ASSERT_RELEASE(top.size() == 100);
+    for (int i = 0; i < 100; ++i) {
+      ASSERT_RELEASE(top[i].second == num_keys - 1 - i);
+    }
+
+    auto by_key = [](const auto &a, const auto &b) { return a.first < b.first; };
+    ASSERT_RELEASE(imap.nth_element(0, by_key).first == 0);
+    ASSERT_RELEASE(imap.nth_element(1234, by_key).first == 1234);
+    ASSERT_RELEASE(imap.nth_element(num_keys - 1, by_key).first ==
+                   num_keys - 1);
+    ASSERT_RELEASE(imap.quantile(0.5, by_key).first == (num_keys - 1) / 2);
+
+    auto approx = imap.approx_quantiles({0.1, 0.9}, by_key);
+    ASSERT_RELEASE(std::abs(approx[0].first - 1000) < 500);
+    ASSERT_RELEASE(std::abs(approx[1].first - 9000) < 500);
+  }
+
+  //
+  // Test bag with duplicates
+  {
+    ygmc::bag<int> ibag(world);
+    for (int i = 0; i < 1000; ++i) {
+      ibag.async_insert(i % 100);
+    }
+    size_t total = 1000 * world.size();
+    ASSERT_RELEASE(ibag.nth_element(0) == 0);
+    ASSERT_RELEASE(ibag.nth_element(total - 1) == 99);
+    // Every value appears 10 * size times
+    ASSERT_RELEASE(ibag.nth_element(10 * world.size() * 42) == 42);
+    ASSERT_RELEASE(ibag.nth_element(10 * world.size() * 43 - 1) == 42);
+    ASSERT_RELEASE(ibag.quantile(1.0) == 99);
+
+    auto top = ibag.topk(3);
+    ASSERT_RELEASE(top.size() == 3);
+    ASSERT_RELEASE(top[0] == 99 && top[2] == 99);
+
+    auto approx = ibag.approx_quantiles({0.5});
+    ASSERT_RELEASE(std::abs(approx[0] - 50) <= 10);
+  }
+
+  //
+  // Test counting_set weighted by counts
+  {
+    ygmc::counting_set<int> cset(world);
+    if (world.rank() == 0) {
+      // key i inserted i times
+      for (int i = 1; i <= 100; ++i) {
+        for (int j = 0; j < i; ++j) {
+          cset.async_insert(i);
+        }
+      }
+    }
+    // 5050 insertions; rank 4950 is the first insertion of key 100
+    ASSERT_RELEASE(cset.nth_element(0) == 1);
+    ASSERT_RELEASE(cset.nth_element(4949) == 99);
+    ASSERT_RELEASE(cset.nth_element(4950) == 100);
+    ASSERT_RELEASE(cset.quantile(1.0) == 100);
+
+    auto top = cset.topk(2);
+    ASSERT_RELEASE(top[0].first == 100 && top[0].second == 100);
+    ASSERT_RELEASE(top[1].first == 99);
+
+    auto approx = cset.approx_quantiles({0.5});
+    // Median of the weighted distribution is about 71
+    ASSERT_RELEASE(std::abs(approx[0] - 71) <= 5);
+  }
+
+  //
+  // Test topk straight after inserts sees every pending count
+  {
+    ygmc::counting_set<int> cset(world);
+    ygmc::map<int, int>     imap(world);
+    // Every rank inserts key i i times
+    for (int i = 1; i <= 100; ++i) {
+      for (int j = 0; j < i; ++j) {
+        cset.async_insert(i);
+        imap.async_reduce(i, 1, std::plus<int>());
+      }
+    }
+    auto ctop = cset.topk(2);
+    ASSERT_RELEASE(ctop[0].first == 100 &&
+                   ctop[0].second == size_t(100 * world.size()));
+    ASSERT_RELEASE(ctop[1].first == 99 &&
+                   ctop[1].second == size_t(99 * world.size()));
+
+    auto mtop = imap.topk(
+        1, [](const auto &a, const auto &b) { return a.second > b.second; });
+    ASSERT_RELEASE(mtop[0].first == 100 &&
+                   mtop[0].second == 100 * world.size());
+  }
+
+  return 0;
+}
@@ -0,0 +1,123 @@
+// Copyright 2019-2021 Lawrence Livermore National Security, LLC and other YGM
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: MIT
+
+#undef NDEBUG
+#include <climits>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <ygm/comm.hpp>
+#include <ygm/container/bag.hpp>
+
+int main(int argc, char **argv) {
+  ygm::comm world(&argc, &argv);
+
+  //
+  // Test sorting random values
+  {
+    ygm::container::bag<int> bbag(world);
+    std::mt19937             gen(world.rank());
+    for (int i = 0; i < 10000; ++i) {
+      bbag.async_insert(gen() % 100000);
+    }
+
+    auto sorted = bbag.sort();
+    ASSERT_RELEASE(sorted.size() == 10000 * world.size());
+    ASSERT_RELEASE(bbag.size() == 10000 * world.size());
+
+    // Sorted within each block, with consecutive global indices
+    int    local_first{INT_MAX}, local_last{INT_MIN};
+    size_t expected_index = sorted.local_offset();
+    sorted.for_all([&](size_t index, int value) {
+      ASSERT_RELEASE(index == expected_index++);
+      ASSERT_RELEASE(local_last == INT_MIN || local_last <= value);
+      local_first = std::min(local_first, value);
+      local_last  = value;
+    });
+
+    // Blocks are ordered across ranks
+    std::vector<std::pair<int, int>> blocks(world.size(), {INT_MAX, INT_MIN});
+    blocks[world.rank()] = {local_first, local_last};
+    blocks = world.all_reduce(blocks, [](const auto &a, const auto &b) {
+      std::vector<std::pair<int, int>> out(a);
+      for (size_t i = 0; i < out.size(); ++i) {
+        out[i].first  = std::min(a[i].first, b[i].first);
+        out[i].second = std::max(a[i].second, b[i].second);
+      }
+      return out;
+    });
+    int prev_last = INT_MIN;
+    for (const auto &block : blocks) {
+      if (block.first != INT_MAX) {
+        ASSERT_RELEASE(prev_last <= block.first);
+        prev_last = block.second;
+      }
+    }
+
+    // Index lookups reach the owner of each index
+    static size_t visited;
+    visited = 0;
+    if (world.rank() == 0) {
+      for (size_t i = 0; i < sorted.size(); i += 997) {
+        sorted.async_visit(i, [](auto parr, int from, size_t index,
+                                  const int &value) {
+          ASSERT_RELEASE(parr->is_mine(index));
+          ASSERT_RELEASE(parr->local_at(index) == value);
+          ++visited;
+        });
+      }
+    }
+    world.barrier();
+    ASSERT_RELEASE(world.all_reduce_sum(visited) ==
+                   (sorted.size() + 996) / 997);
+  }
+
+  //
+  // Test rank queries with duplicates
+  {
+    ygm::container::bag<int> bbag(world);
+    for (int i = 0; i < 10000; ++i) {
+      bbag.async_insert(i % 100);
+    }
+    auto sorted = bbag.sort();
+    ASSERT_RELEASE(sorted.lower_bound(42) == 4200 * world.size());
+    ASSERT_RELEASE(sorted.upper_bound(42) == 4300 * world.size());
+    ASSERT_RELEASE(sorted.lower_bound(-1) == 0);
+    ASSERT_RELEASE(sorted.upper_bound(100) == sorted.size());
+  }
+
+  //
+  // Test equal items are still spread across ranks
+  {
+    ygm::container::bag<int> bbag(world);
+    for (int i = 0; i < 10000; ++i) {
+      bbag.async_insert(7);
+    }
+    auto sorted = bbag.sort();
+    ASSERT_RELEASE(world.all_reduce_max(sorted.local_size()) <= 20000);
+  }
+
+  //
+  // Test custom comparator
+  {
+    ygm::container::bag<std::string> bbag(world);
+    if (world.rank() == 0) {
+      bbag.async_insert("apple");
+      bbag.async_insert("red");
+      bbag.async_insert("dog");
+    }
+    auto sorted = bbag.sort(std::greater<std::string>());
+    ASSERT_RELEASE(sorted.size() == 3);
+    if (sorted.is_mine(0)) {
+      ASSERT_RELEASE(sorted.local_at(0) == "red");
+    }
+    if (sorted.is_mine(2)) {
+      ASSERT_RELEASE(sorted.local_at(2) == "apple");
+    }
+  }
+
+  return 0;
+}